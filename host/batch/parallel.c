@@ -0,0 +1,200 @@
+/* Parallel loops of the host tools, see parallel.h */
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "parallel.h"
+
+struct parallel_job {
+  atomic_size_t next;
+  size_t        n;
+  size_t        chunk;
+  parallel_fn   fn;
+  void         *arg;
+};
+
+struct parallel_worker {
+  pthread_t            thread;
+  struct parallel_job *job;
+  int                  id;
+};
+
+static void parallel_run(struct parallel_job *job, int id)
+{
+  size_t begin, end;
+
+  for (;;) {
+    begin = atomic_fetch_add(&job->next, job->chunk);
+    if (begin >= job->n)
+      return;
+    end = begin + job->chunk < job->n ? begin + job->chunk : job->n;
+    job->fn(begin, end, id, job->arg);
+  }
+}
+
+static void *parallel_thread(void *arg)
+{
+  struct parallel_worker *w = arg;
+
+  parallel_run(w->job, w->id);
+  return NULL;
+}
+
+/* The share of a worker of parallel_steal(), on its own cache line */
+struct parallel_deque {
+  pthread_mutex_t lock;
+  size_t          begin, end;
+  long            steals;
+  char            pad[64];
+};
+
+struct parallel_steal_job {
+  struct parallel_deque *deque;
+  int                    workers;
+  size_t                 chunk;
+  parallel_fn            fn;
+  void                  *arg;
+};
+
+struct parallel_thief {
+  pthread_t                  thread;
+  struct parallel_steal_job *job;
+  int                        id;
+};
+
+/* Moves the back half of another worker's share to the own one; 0 if all are empty */
+static int parallel_steal_half(struct parallel_steal_job *job, int id)
+{
+  struct parallel_deque *own = &job->deque[id], *victim;
+  size_t begin = 0, end = 0;
+  int    k;
+
+  for (k = 1; k < job->workers && begin == end; k++) {
+    victim = &job->deque[(id + k) % job->workers];
+    pthread_mutex_lock(&victim->lock);
+    if (victim->begin < victim->end) {
+      end           = victim->end;
+      begin         = end - (end - victim->begin + 1) / 2;
+      victim->end   = begin;
+    }
+    pthread_mutex_unlock(&victim->lock);
+  }
+  if (begin == end)
+    return 0;
+  pthread_mutex_lock(&own->lock);
+  own->begin = begin;
+  own->end   = end;
+  own->steals++;
+  pthread_mutex_unlock(&own->lock);
+  return 1;
+}
+
+static void parallel_steal_run(struct parallel_steal_job *job, int id)
+{
+  struct parallel_deque *own = &job->deque[id];
+  size_t begin, end;
+
+  do {
+    for (;;) {
+      pthread_mutex_lock(&own->lock);
+      begin      = own->begin;
+      end        = begin + job->chunk < own->end ? begin + job->chunk : own->end;
+      own->begin = end;
+      pthread_mutex_unlock(&own->lock);
+      if (begin == end)
+        break;
+      job->fn(begin, end, id, job->arg);
+    }
+  } while (parallel_steal_half(job, id));
+}
+
+static void *parallel_steal_thread(void *arg)
+{
+  struct parallel_thief *t = arg;
+
+  parallel_steal_run(t->job, t->id);
+  return NULL;
+}
+
+int parallel_workers(int requested)
+{
+  long cpus;
+
+  if (requested > 0)
+    return requested;
+  cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  return cpus > 0 ? (int) cpus : 1;
+}
+
+int parallel_for(size_t n, size_t chunk, int workers, parallel_fn fn, void *arg)
+{
+  struct parallel_job     job;
+  struct parallel_worker *w;
+  int                     i, started;
+
+  atomic_init(&job.next, 0);
+  job.n     = n;
+  job.chunk = chunk ? chunk : 1;
+  job.fn    = fn;
+  job.arg   = arg;
+
+  w = calloc(workers > 1 ? workers : 1, sizeof(*w));
+  if (w == NULL)
+    return -1;
+  for (started = 1; started < workers; started++) {
+    w[started].job = &job;
+    w[started].id  = started;
+    if (pthread_create(&w[started].thread, NULL, parallel_thread, &w[started]) != 0)
+      break;
+  }
+  parallel_run(&job, 0);
+  for (i = 1; i < started; i++)
+    pthread_join(w[i].thread, NULL);
+  free(w);
+  return 0;
+}
+
+long parallel_steal(size_t n, size_t chunk, int workers, parallel_fn fn, void *arg)
+{
+  struct parallel_steal_job job;
+  struct parallel_thief    *t;
+  long                      steals = 0;
+  int                       i, started;
+
+  if (workers < 1)
+    workers = 1;
+  job.deque   = calloc(workers, sizeof(*job.deque));
+  t           = calloc(workers, sizeof(*t));
+  job.workers = workers;
+  job.chunk   = chunk ? chunk : 1;
+  job.fn      = fn;
+  job.arg     = arg;
+  if (job.deque == NULL || t == NULL) {
+    free(job.deque);
+    free(t);
+    return -1;
+  }
+  /* contiguous shares, the first n % workers one item larger */
+  for (i = 0; i < workers; i++) {
+    pthread_mutex_init(&job.deque[i].lock, NULL);
+    job.deque[i].begin = n / workers * i + ((size_t) i < n % workers ? (size_t) i : n % workers);
+    job.deque[i].end   = job.deque[i].begin + n / workers + ((size_t) i < n % workers);
+  }
+  for (started = 1; started < workers; started++) {
+    t[started].job = &job;
+    t[started].id  = started;
+    if (pthread_create(&t[started].thread, NULL, parallel_steal_thread, &t[started]) != 0)
+      break;
+  }
+  parallel_steal_run(&job, 0);
+  for (i = 1; i < started; i++)
+    pthread_join(t[i].thread, NULL);
+  for (i = 0; i < workers; i++) {
+    steals += job.deque[i].steals;
+    pthread_mutex_destroy(&job.deque[i].lock);
+  }
+  free(job.deque);
+  free(t);
+  return steals;
+}
@@ -0,0 +1,33 @@
+/* Parallel loops of the host tools
+ *
+ * Description:
+ *
+ *   parallel_for() hands the items 0..n-1 out in chunks from a shared
+ *   work queue (an atomic cursor) to a set of worker threads, the calling
+ *   thread being worker 0. Every call of fn() gets the number of the
+ *   worker running it, so that results can go to per-worker buffers
+ *   without locking.
+ *
+ *   parallel_steal() is for items of very uneven cost: every worker starts
+ *   on its own contiguous share of the items and takes chunks from its
+ *   front; once it runs dry it steals the back half of what another worker
+ *   has left, so that a few long items at the end of one share do not
+ *   leave the other workers idle.
+ */
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <stddef.h>
+
+typedef void (*parallel_fn)(size_t begin, size_t end, int worker, void *arg);
+
+/* 'requested' workers, or one per online CPU if it is 0 or less */
+int parallel_workers(int requested);
+
+/* Returns 0, -1 if out of memory (then nothing ran) */
+int parallel_for(size_t n, size_t chunk, int workers, parallel_fn fn, void *arg);
+
+/* Returns the number of steals, -1 if out of memory (then nothing ran) */
+long parallel_steal(size_t n, size_t chunk, int workers, parallel_fn fn, void *arg);
+
+#endif /* PARALLEL_H */
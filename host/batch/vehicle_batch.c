@@ -0,0 +1,222 @@
+/* Batch vehicle simulator, see vehicle_batch.h
+ *
+ * The vector step uses the GCC vector extensions, so the same code
+ * compiles to SSE/AVX on x86_64 and to NEON on aarch64. All lanes compute
+ * in 32 bits and are truncated to the 16 bit types of the scalar model on
+ * the way back, which reproduces its wrap-arounds.
+ *
+ * The scalar model rounds 'velocity + acceleration * 300 / 1000.0' towards
+ * zero. The exact value is a multiple of 1/10 that is never closer than
+ * 1/10 to the next integer, so (10 * velocity + 3 * acceleration) / 10 in
+ * single precision, whose operands stay below 2^24, truncates to the same
+ * integer.
+ *
+ * Tracks up to 2^31 m long are supported.
+ */
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "vehicle_batch.h"
+
+#ifdef VEHICLE_FIXED_POINT
+#error "vehicle_batch.c: the batch simulator implements the integer model"
+#endif
+
+#if VEHICLE_STEP_MS % 100 != 0
+#error "vehicle_batch.c: VEHICLE_STEP_MS must be a multiple of 100 ms"
+#endif
+#define VB_STEP (VEHICLE_STEP_MS / 100)  /* tenths of a second */
+
+#define VB_ALIGN 64
+
+typedef INT32S vb_i32 __attribute__((vector_size(VEHICLE_BATCH_LANES * 4)));
+typedef float  vb_f32 __attribute__((vector_size(VEHICLE_BATCH_LANES * 4)));
+typedef INT16S vb_i16 __attribute__((vector_size(VEHICLE_BATCH_LANES * 2)));
+typedef INT32U vb_u32 __attribute__((vector_size(VEHICLE_BATCH_LANES * 4)));
+typedef INT8U  vb_u8  __attribute__((vector_size(VEHICLE_BATCH_LANES)));
+
+static void *vb_alloc(size_t bytes)
+{
+  void *p;
+
+  if (posix_memalign(&p, VB_ALIGN, bytes) != 0)
+    return NULL;
+  memset(p, 0, bytes);
+  return p;
+}
+
+int vehicle_batch_init(struct vehicle_batch *batch, size_t n)
+{
+  size_t size = (n + VEHICLE_BATCH_LANES - 1) / VEHICLE_BATCH_LANES * VEHICLE_BATCH_LANES;
+
+  batch->n        = n;
+  batch->size     = size;
+  batch->track    = track_default;
+  batch->indexed  = NULL;
+  batch->next_start = NULL;
+  batch->gradient = NULL;
+  batch->position = vb_alloc(size * sizeof(INT32U));
+  batch->velocity = vb_alloc(size * sizeof(INT16S));
+  batch->throttle = vb_alloc(size);
+  batch->brake    = vb_alloc(size);
+  batch->engine   = vb_alloc(size);
+  if (!batch->position || !batch->velocity || !batch->throttle || !batch->brake ||
+      !batch->engine) {
+    vehicle_batch_free(batch);
+    return -1;
+  }
+  memset(batch->brake, off, size);
+  memset(batch->engine, off, size);
+  return 0;
+}
+
+void vehicle_batch_free(struct vehicle_batch *batch)
+{
+  free(batch->position);
+  free(batch->velocity);
+  free(batch->throttle);
+  free(batch->brake);
+  free(batch->engine);
+  free(batch->next_start);
+  free(batch->gradient);
+  memset(batch, 0, sizeof(*batch));
+}
+
+/* Widens one step at a time, which the compiler turns into vector moves */
+static inline vb_i32 vb_load_u8(const INT8U *p)
+{
+  return __builtin_convertvector(__builtin_convertvector(*(const vb_u8 *) p, vb_i16), vb_i32);
+}
+
+/* Gathers tbl[idx] for every lane */
+static inline vb_i32 vb_gather(const INT32S *tbl, vb_i32 idx)
+{
+#if defined(__AVX512F__) && VEHICLE_BATCH_LANES == 16
+  return (vb_i32) _mm512_i32gather_epi32((__m512i) idx, tbl, 4);
+#elif defined(__AVX2__) && VEHICLE_BATCH_LANES == 16
+  __m256i half[2];
+  vb_i32  r;
+
+  memcpy(half, &idx, sizeof(half));
+  half[0] = _mm256_i32gather_epi32((const int *) tbl, half[0], 4);
+  half[1] = _mm256_i32gather_epi32((const int *) tbl, half[1], 4);
+  memcpy(&r, half, sizeof(r));
+  return r;
+#else
+  vb_i32 r;
+  int    k;
+
+  for (k = 0; k < VEHICLE_BATCH_LANES; k++)
+    r[k] = tbl[idx[k]];
+  return r;
+#endif
+}
+
+/*
+ * Copies the segment table of the track into the arrays the vector lookup
+ * uses: the start of the next segment (INT32_MAX past the last one) and
+ * the gradient of every segment.
+ */
+static int vb_track(struct vehicle_batch *batch)
+{
+  const struct track *track = batch->track;
+  INT32U i;
+
+  if (batch->indexed == track)
+    return 0;
+  free(batch->next_start);
+  free(batch->gradient);
+  batch->indexed    = NULL;
+  batch->next_start = malloc(track->segments * sizeof(INT32S));
+  batch->gradient   = malloc(track->segments * sizeof(INT32S));
+  if (batch->next_start == NULL || batch->gradient == NULL) {
+    // nothing is indexed, the next step tries again
+    free(batch->next_start);
+    free(batch->gradient);
+    batch->next_start = NULL;
+    batch->gradient   = NULL;
+    return -1;
+  }
+  for (i = 0; i < track->segments; i++) {
+    batch->next_start[i] = i + 1 < track->segments ? (INT32S) track->segment[i + 1].start : INT32_MAX;
+    batch->gradient[i]   = track->segment[i].gradient;
+  }
+  batch->indexed = track;
+  return 0;
+}
+
+/* x / 10 rounded towards zero, exact for |x| < 2^24 */
+static inline vb_i32 vb_div10(vb_i32 x)
+{
+  return __builtin_convertvector(__builtin_convertvector(x, vb_f32) * 0.1f, vb_i32);
+}
+
+int vehicle_batch_step(struct vehicle_batch *batch)
+{
+  INT32U *restrict position = __builtin_assume_aligned(batch->position, VB_ALIGN);
+  INT16S *restrict velocity = __builtin_assume_aligned(batch->velocity, VB_ALIGN);
+  const struct track *track = batch->track;
+  const INT32S length = (INT32S) track->length;
+  const INT32S *bucket = (const INT32S *) track->bucket;
+  size_t i;
+
+  if (vb_track(batch) < 0)
+    return -1;
+
+  for (i = 0; i < batch->size; i += VEHICLE_BATCH_LANES) {
+    vb_i32 p   = (vb_i32) *(vb_u32 *) &position[i];
+    vb_i32 v   = __builtin_convertvector(*(vb_i16 *) &velocity[i], vb_i32);
+    vb_i32 t   = vb_load_u8(&batch->throttle[i]);
+    vb_i32 brk = vb_load_u8(&batch->brake[i]);
+    vb_i32 eng = vb_load_u8(&batch->engine[i]);
+    vb_i32 a_free, a_brake, a, m, seg;
+
+    // vehichle cannot effort more than 80 units of throttle
+    m = t > MAX_THROTTLE;
+    t = (t & ~m) | (MAX_THROTTLE & m);
+
+    // wind resistance, engine and gravity
+    a_free = -WIND_FACTOR * v + (t & (eng == on));
+    seg = vb_gather(bucket, p >> track->shift);
+    seg -= p >= vb_gather(batch->next_start, seg);
+    a_free += vb_gather(batch->gradient, seg);
+    // the brake dynamics dominates
+    a_brake = -BRAKE_FACTOR * v;
+    m = brk == off;
+    a = (a_free & m) | (a_brake & ~m);
+    a = (a << 16) >> 16;  /* INT16S acceleration */
+
+    // the position is unsigned, backing up past 0 m wraps as well
+    p = p + vb_div10(VB_STEP * v);
+    p &= (p >= 0) & (p <= length);
+    v = vb_div10(10 * v + VB_STEP * a);
+
+    *(vb_u32 *) &position[i] = (vb_u32) p;
+    *(vb_i16 *) &velocity[i] = __builtin_convertvector(v, vb_i16);
+  }
+  return 0;
+}
+
+void vehicle_batch_step_scalar(struct vehicle_batch *batch)
+{
+  struct vehicle_state  car;
+  struct vehicle_inputs in;
+  size_t i;
+
+  vehicle_init(&car);
+  car.track = batch->track;
+  for (i = 0; i < batch->n; i++) {
+    car.position   = batch->position[i];
+    car.velocity   = batch->velocity[i];
+    in.throttle    = batch->throttle[i];
+    in.brake_pedal = (enum active) batch->brake[i];
+    in.engine      = (enum active) batch->engine[i];
+    vehicle_step(&car, &in);
+    batch->position[i] = car.position;
+    batch->velocity[i] = car.velocity;
+  }
+}
@@ -0,0 +1,51 @@
+/* Batch vehicle simulator
+ *
+ * Description:
+ *
+ *   N independent instances of the vehicle model (model/vehicle.h) stored
+ *   as a structure of arrays, so that one step of all of them runs as
+ *   vector code: every field lives in its own cache line aligned array
+ *   padded to a multiple of VEHICLE_BATCH_LANES entries.
+ *
+ *   vehicle_batch_step() gives bit for bit the same positions and
+ *   velocities as calling vehicle_step() on every vehicle, which is what
+ *   vehicle_batch_step_scalar() does. All vehicles feel the WIND_FACTOR
+ *   of calm weather.
+ */
+#ifndef VEHICLE_BATCH_H
+#define VEHICLE_BATCH_H
+
+#include <stddef.h>
+
+#include "vehicle.h"
+
+/* Vehicles advanced by one iteration of the vector loop */
+#define VEHICLE_BATCH_LANES 16
+
+struct vehicle_batch {
+  size_t  n;          /* Vehicles in use */
+  size_t  size;       /* Entries allocated, n rounded up to the lanes */
+  const struct track *track;  /* Shared by all vehicles, track_default at first */
+  INT32U *position;
+  INT16S *velocity;
+  INT8U  *throttle;   /* Inputs, enum active for brake and engine */
+  INT8U  *brake;
+  INT8U  *engine;
+
+  const struct track *indexed;  /* Track the segment arrays below hold */
+  INT32S *next_start;
+  INT32S *gradient;
+};
+
+/* Allocates n vehicles at rest with their engine off; returns -1 if out of memory */
+int  vehicle_batch_init(struct vehicle_batch *batch, size_t n);
+void vehicle_batch_free(struct vehicle_batch *batch);
+
+/*
+ * Advances every vehicle by VEHICLE_STEP_MS. The vector step copies the
+ * segments of a new track first and returns -1 if that runs out of memory.
+ */
+int  vehicle_batch_step(struct vehicle_batch *batch);
+void vehicle_batch_step_scalar(struct vehicle_batch *batch);
+
+#endif /* VEHICLE_BATCH_H */
@@ -0,0 +1,112 @@
+/* Speed of the batch vehicle simulator
+ *
+ * Description:
+ *
+ *   Steps the same N vehicles with vehicle_batch_step_scalar() (one
+ *   vehicle_step() call per vehicle) and with the vector vehicle_batch_step(),
+ *   checks that both end in the same state and reports vehicle steps per
+ *   second. The vehicles start at random places of the track with random
+ *   throttle, brake and engine inputs that stay constant during the run.
+ *
+ *   usage: batch-bench [-w vehicle steps per run] [N ...]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "vehicle_batch.h"
+#include "bench.h"
+
+static unsigned long bench_seed;
+
+static unsigned long bench_rand(void)
+{
+  bench_seed = bench_seed * 6364136223846793005ull + 1442695040888963407ull;
+  return bench_seed >> 33;
+}
+
+static void bench_fill(struct vehicle_batch *batch)
+{
+  size_t i;
+
+  bench_seed = 1;
+  for (i = 0; i < batch->n; i++) {
+    batch->position[i] = bench_rand() % (TRACK_LENGTH + 1);
+    batch->velocity[i] = (INT16S) (bench_rand() % 80) - 10;
+    batch->throttle[i] = bench_rand() % 100;
+    batch->brake[i]    = bench_rand() % 8 == 0 ? on : off;
+    batch->engine[i]   = bench_rand() % 8 != 0 ? on : off;
+  }
+}
+
+static void bench_scalar(struct vehicle_batch *batch)
+{
+  vehicle_batch_step_scalar(batch);
+}
+
+static void bench_simd(struct vehicle_batch *batch)
+{
+  if (vehicle_batch_step(batch) < 0) {
+    fprintf(stderr, "batch-bench: out of memory for the segments of the track\n");
+    exit(1);
+  }
+}
+
+static double bench_run(struct vehicle_batch *batch, void (*step)(struct vehicle_batch *),
+                        unsigned long steps)
+{
+  unsigned long k;
+  double        t0 = bench_now();
+
+  for (k = 0; k < steps; k++)
+    step(batch);
+  return bench_now() - t0;
+}
+
+int main(int argc, char **argv)
+{
+  static const size_t  defaults[] = {1000, 100000, 1000000};
+  double               work = 2e8;
+  struct vehicle_batch scalar, simd;
+  unsigned long        steps;
+  double               ts, tv;
+  size_t               n;
+  int                  i, nn, opt, same;
+
+  while ((opt = getopt(argc, argv, "w:")) != -1) {
+    switch (opt) {
+    case 'w': work = strtod(optarg, NULL); break;
+    default:
+      fprintf(stderr, "usage: %s [-w vehicle steps per run] [N ...]\n", argv[0]);
+      return 2;
+    }
+  }
+  nn = optind < argc ? argc - optind : 3;
+
+  printf("%9s %8s %16s %16s %8s %6s\n", "N", "steps", "scalar[steps/s]", "simd[steps/s]",
+         "speed-up", "match");
+  for (i = 0; i < nn; i++) {
+    n = optind < argc ? strtoul(argv[optind + i], NULL, 0) : defaults[i];
+    steps = (unsigned long) (work / n) + 1;
+    if (vehicle_batch_init(&scalar, n) < 0 || vehicle_batch_init(&simd, n) < 0) {
+      fprintf(stderr, "%s: out of memory for %zu vehicles\n", argv[0], n);
+      return 1;
+    }
+    bench_fill(&scalar);
+    bench_fill(&simd);
+
+    ts = bench_run(&scalar, bench_scalar, steps);
+    tv = bench_run(&simd, bench_simd, steps);
+    same = memcmp(scalar.position, simd.position, n * sizeof(INT32U)) == 0 &&
+           memcmp(scalar.velocity, simd.velocity, n * sizeof(INT16S)) == 0;
+
+    printf("%9zu %8lu %16.4g %16.4g %7.1fx %6s\n", n, steps, n * steps / ts, n * steps / tv,
+           ts / tv, same ? "yes" : "NO");
+    vehicle_batch_free(&scalar);
+    vehicle_batch_free(&simd);
+    if (!same)
+      return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,40 @@
+/* Timing helpers of the host benchmarks
+ *
+ * Description:
+ *
+ *   bench_now() reads the monotonic clock in seconds. bench_cycles() reads
+ *   the time stamp counter (x86_64) or the virtual counter (aarch64); it
+ *   only serves to compare two code paths measured on the same machine.
+ */
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include <time.h>
+
+static inline double bench_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static inline uint64_t bench_cycles(void)
+{
+#if defined(__x86_64__)
+  return __builtin_ia32_rdtsc();
+#elif defined(__aarch64__)
+  uint64_t t;
+
+  __asm__ __volatile__("isb; mrs %0, cntvct_el0" : "=r"(t));
+  return t;
+#else
+  return (uint64_t) (bench_now() * 1e9);
+#endif
+}
+
+/* Keeps the compiler from dropping a result the benchmark does not use */
+#define BENCH_KEEP(x) __asm__ __volatile__("" : : "g"(x) : "memory")
+
+#endif /* BENCH_H */
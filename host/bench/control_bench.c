@@ -0,0 +1,222 @@
+/* Quality benchmark of the cruise controllers
+ *
+ * Description:
+ *
+ *   Closes the loop of every controller variant around the vehicle model
+ *   (tune/cruise_run.h) in a fixed set of standard scenarios and writes
+ *   one CSV line per variant and scenario, to be compared between
+ *   revisions:
+ *
+ *     flat       30 -> 40 m/s on a track without slopes, 60 s
+ *     uphill     40 m/s through the uphill and steep uphill of the lab
+ *                track (400 to 1200 m)
+ *     downhill   40 m/s through the downhill and steep downhill (1600 m
+ *                to the end)
+ *     retarget   cruising at 40 m/s on the flat for 30 s, then the target
+ *                changes to 50 m/s; the metrics are those of the 60 s
+ *                after the change
+ *     lap        40 m/s over two laps of the lab track, 120 s
+ *
+ *   The cruise control stays engaged throughout: control_step() drops it
+ *   below 25 m/s.
+ *
+ *   The variants are the ControlTask of the lab copies: src/cruise.c and
+ *   src/cruise-mbox-errors.c send a constant throttle of 40, src-merlijn
+ *   runs control_step() (the fixed-point PID of model/), with the single
+ *   set of gains, scheduled per segment of the lab track or with the
+ *   feed-forward of the slopes -H ms ahead, 0 by default, or the explicit
+ *   MPC table instead of the PID (control.h; the flat track of the flat and
+ *   retarget scenarios has no schedule, no slopes and no table).
+ *
+ *   IAE and ISE are in (m/s) s and (m/s)^2 s, the settling time is -1 if
+ *   the velocity is still out of the band at the end (cruise_run.h). The
+ *   cycles per period are the best of -r runs of the scenario, less the
+ *   cost of reading the counter around an empty controller.
+ *
+ *   usage: control-bench [-r runs] [-H horizon_ms]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "cruise_run.h"
+#include "bench.h"
+
+#define BENCH_MAX_PERIODS  2000
+#define BENCH_AFTER_CHANGE 200       /* periods measured after a target change */
+#define BENCH_CALLS        100000
+
+enum bench_end {
+  BENCH_PERIODS,                     /* after 'periods' */
+  BENCH_LEAVE                        /* once the car leaves [position, until) */
+};
+
+struct bench_scenario {
+  const char        *name;
+  struct cruise_case c;
+  int                end;            /* enum bench_end */
+  INT32U             periods;        /* or until the target change */
+  INT32U             until;          /* m */
+  INT16S             retarget;       /* m/s, 0: none */
+};
+
+struct bench_variant {
+  const char                    *name;
+  cruise_control_fn              control;
+  const struct control_schedule *schedule;
+  const struct control_offsets  *feed_forward;
+  const struct control_mpc      *mpc;
+};
+
+static const struct track_segment bench_flat_segment[] = {{0, 0}};
+static const INT32U               bench_flat_bucket[]  = {0};
+
+/* The length of the lab track without its slopes */
+static const struct track bench_flat = {
+  TRACK_LENGTH, 1, bench_flat_segment, 31, bench_flat_bucket,
+};
+
+static const struct bench_scenario bench_scenarios[] = {
+  {"flat",     {30, 40,    0, &bench_flat}, BENCH_PERIODS, 200,    0,  0},
+  {"uphill",   {40, 40,  400, NULL},        BENCH_LEAVE,     0, 1200,  0},
+  {"downhill", {40, 40, 1600, NULL},        BENCH_LEAVE,     0, 2400,  0},
+  {"retarget", {40, 40,    0, &bench_flat}, BENCH_PERIODS, 100,    0, 50},
+  {"lap",      {40, 40,    0, NULL},        BENCH_PERIODS, 400,    0,  0},
+};
+
+/* ControlTask of src/cruise.c and src/cruise-mbox-errors.c */
+static void bench_constant(struct control_state *state, const struct control_inputs *in,
+                           struct control_outputs *out)
+{
+  out->throttle = STATIONARY_THROTTLE;
+  out->brake    = off;
+  out->engine   = 0;
+}
+
+static const struct bench_variant bench_variants[] = {
+  {"src",                      bench_constant, NULL,                  NULL,                 NULL},
+  {"src-merlijn",              control_step,   NULL,                  NULL,                 NULL},
+  {"src-merlijn-scheduled",    control_step,   &control_schedule_lab, NULL,                 NULL},
+  {"src-merlijn-feed-forward", control_step,   NULL,                  &control_offsets_lab, NULL},
+  {"src-merlijn-mpc",          control_step,   NULL,                  NULL,                 &control_mpc_lab},
+};
+
+/* The loop of cruise_run.h applies the throttle in the period it is
+   computed for, so nothing needs to be anticipated */
+static INT32U bench_horizon = 0;
+
+/* The controller of the variant being measured, timed around every call */
+static cruise_control_fn bench_control;
+static uint64_t          bench_spent;
+
+static void bench_timed(struct control_state *state, const struct control_inputs *in,
+                        struct control_outputs *out)
+{
+  uint64_t t0 = bench_cycles();
+
+  bench_control(state, in, out);
+  bench_spent += bench_cycles() - t0;
+}
+
+static void bench_nothing(struct control_state *state, const struct control_inputs *in,
+                          struct control_outputs *out)
+{
+  BENCH_KEEP(out);
+}
+
+/* Cycles bench_timed() adds to a call, best of a few rounds */
+static double bench_overhead(void)
+{
+  struct control_state   state;
+  struct control_inputs  in = {0, 0, 0};
+  struct control_outputs out;
+  double best = 1e30;
+  int    round, k;
+
+  bench_control = bench_nothing;
+  for (round = 0; round < 10; round++) {
+    bench_spent = 0;
+    for (k = 0; k < BENCH_CALLS; k++)
+      bench_timed(&state, &in, &out);
+    if ((double) bench_spent / BENCH_CALLS < best)
+      best = (double) bench_spent / BENCH_CALLS;
+  }
+  return best;
+}
+
+/* Runs the scenario once; returns the cycles spent in the controller */
+static uint64_t bench_run(const struct bench_scenario *s, const struct bench_variant *v,
+                          struct cruise_run *run)
+{
+  INT32U k;
+
+  cruise_run_init(run, &s->c, CONTROL_KP, CONTROL_KI, CONTROL_KD);
+  run->ctrl.schedule     = v->schedule;
+  run->ctrl.feed_forward = v->feed_forward;
+  run->ctrl.horizon_ms   = bench_horizon;
+  run->ctrl.mpc          = v->mpc;
+  run->control  = bench_timed;
+  bench_control = v->control;
+  bench_spent   = 0;
+  if (s->end == BENCH_PERIODS) {
+    cruise_run_step(run, s->periods, 0);
+    if (s->retarget == 0)
+      return bench_spent;
+    cruise_run_retarget(run, s->retarget);
+    bench_spent = 0;
+    cruise_run_step(run, BENCH_AFTER_CHANGE, 0);
+    return bench_spent;
+  }
+  for (k = 0; k < BENCH_MAX_PERIODS; k++) {
+    cruise_run_step(run, 1, 0);
+    if (run->car.position < s->c.position || run->car.position >= s->until)
+      break;
+  }
+  return bench_spent;
+}
+
+int main(int argc, char **argv)
+{
+  const struct bench_scenario *s;
+  const struct bench_variant  *v;
+  struct cruise_run            run;
+  struct cruise_metrics        m;
+  uint64_t best, spent;
+  double   overhead, cycles;
+  int      opt, runs = 100, i;
+  size_t   vi, si;
+
+  while ((opt = getopt(argc, argv, "r:H:")) != -1) {
+    switch (opt) {
+    case 'r': runs = atoi(optarg); break;
+    case 'H': bench_horizon = strtoul(optarg, NULL, 0); break;
+    default:
+      fprintf(stderr, "usage: %s [-r runs] [-H horizon_ms]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (runs < 1)
+    runs = 1;
+
+  overhead = bench_overhead();
+  printf("controller,scenario,periods,iae,ise,overshoot,settling_s,ss_error,effort,"
+         "cycles_per_period\n");
+  for (vi = 0; vi < sizeof(bench_variants) / sizeof(bench_variants[0]); vi++) {
+    v = &bench_variants[vi];
+    for (si = 0; si < sizeof(bench_scenarios) / sizeof(bench_scenarios[0]); si++) {
+      s = &bench_scenarios[si];
+      best = UINT64_MAX;
+      for (i = 0; i < runs; i++) {
+        spent = bench_run(s, v, &run);
+        if (spent < best)
+          best = spent;
+      }
+      cruise_run_metrics(&run, &m);
+      cycles = (double) best / run.period - overhead;
+      printf("%s,%s,%u,%.1f,%.1f,%g,%.1f,%.3f,%.2f,%.1f\n", v->name, s->name, run.period,
+             m.iae, m.ise, m.overshoot, m.settling, m.ss_error, m.effort,
+             cycles > 0 ? cycles : 0.0);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,129 @@
+/* Fast-forward of the vehicle model against period-by-period stepping
+ *
+ * Description:
+ *
+ *   Drives the double and the Q16.16 vehicle model for hours of simulated
+ *   time with inputs that change at random events (on average every -e
+ *   periods), once calling the step function every period and once
+ *   calling the fast-forward between two events. The states are compared
+ *   at every event; the report gives the time both take per simulated
+ *   hour and the iterations the fast-forward needed.
+ *
+ *   usage: fast-forward-bench [-H hours] [-e periods] [-t track]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "vehicle.h"
+#include "track_file.h"
+#include "bench.h"
+
+#define BENCH_PERIODS_PER_HOUR (3600000 / VEHICLE_STEP_MS)
+
+struct bench_event {
+  INT32U                periods;   /* the inputs hold this long */
+  struct vehicle_inputs in;
+};
+
+static struct bench_event *bench_fill(INT32U periods, INT32U every, INT32U *events)
+{
+  struct bench_event *ev = malloc((periods + 1) * sizeof(*ev));
+  unsigned long long  seed = 1;
+  INT32U              n, left = periods;
+
+  if (ev == NULL)
+    return NULL;
+  for (n = 0; left > 0; n++) {
+    seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+    ev[n].periods = 1 + (INT32U) ((seed >> 33) % (2 * every));
+    if (ev[n].periods > left)
+      ev[n].periods = left;
+    left -= ev[n].periods;
+    ev[n].in.throttle    = (seed >> 20) % (MAX_THROTTLE + 1);
+    ev[n].in.brake_pedal = (seed >> 45) % 16 == 0 ? on : off;
+    ev[n].in.engine      = (seed >> 50) % 16 != 0 ? on : off;
+  }
+  *events = n;
+  return ev;
+}
+
+int main(int argc, char **argv)
+{
+  struct vehicle_state     car, car_ff;
+  struct vehicle_fx_state  fx, fx_ff;
+  struct bench_event      *ev;
+  struct track            *track = NULL;
+  double                   hours = 100, t0, t1, t2, t3, t4;
+  INT32U                   every = 2000, periods, events, e, k;
+  unsigned long long       work = 0, work_fx = 0;
+  unsigned long            differ = 0, differ_fx = 0;
+  int                      opt;
+
+  while ((opt = getopt(argc, argv, "H:e:t:")) != -1) {
+    switch (opt) {
+    case 'H': hours = atof(optarg); break;
+    case 'e': every = strtoul(optarg, NULL, 0); break;
+    case 't':
+      if ((track = track_load(optarg)) == NULL)
+        return 1;
+      track_default = track;
+      break;
+    default:
+      fprintf(stderr, "usage: %s [-H hours] [-e periods] [-t track]\n", argv[0]);
+      return 2;
+    }
+  }
+  periods = (INT32U) (hours * BENCH_PERIODS_PER_HOUR);
+  if (every == 0 || (ev = bench_fill(periods, every, &events)) == NULL) {
+    fprintf(stderr, "%s: out of memory\n", argv[0]);
+    return 1;
+  }
+
+  vehicle_init(&car);
+  vehicle_init(&car_ff);
+  vehicle_fx_init(&fx);
+  vehicle_fx_init(&fx_ff);
+
+  t0 = bench_now();
+  for (e = 0; e < events; e++)
+    for (k = 0; k < ev[e].periods; k++)
+      vehicle_step(&car, &ev[e].in);
+  t1 = bench_now();
+  for (e = 0; e < events; e++)
+    work += vehicle_fast_forward(&car_ff, &ev[e].in, ev[e].periods);
+  t2 = bench_now();
+  for (e = 0; e < events; e++)
+    for (k = 0; k < ev[e].periods; k++)
+      vehicle_fx_step(&fx, &ev[e].in);
+  t3 = bench_now();
+  for (e = 0; e < events; e++)
+    work_fx += vehicle_fx_fast_forward(&fx_ff, &ev[e].in, ev[e].periods);
+  t4 = bench_now();
+
+  /* Same again, comparing the states at every event */
+  vehicle_init(&car);
+  vehicle_init(&car_ff);
+  vehicle_fx_init(&fx);
+  vehicle_fx_init(&fx_ff);
+  for (e = 0; e < events; e++) {
+    for (k = 0; k < ev[e].periods; k++) {
+      vehicle_step(&car, &ev[e].in);
+      vehicle_fx_step(&fx, &ev[e].in);
+    }
+    vehicle_fast_forward(&car_ff, &ev[e].in, ev[e].periods);
+    vehicle_fx_fast_forward(&fx_ff, &ev[e].in, ev[e].periods);
+    differ    += car.position != car_ff.position || car.velocity != car_ff.velocity;
+    differ_fx += fx.position != fx_ff.position || fx.velocity != fx_ff.velocity;
+  }
+
+  printf("%.0f h, %u periods, %u input events\n", hours, periods, events);
+  printf("model   step[ms/h]  fast-forward[ms/h]  speed-up  iterations  events differing\n");
+  printf("double  %10.3f  %18.3f  %7.0fx  %10llu  %lu\n", (t1 - t0) * 1e3 / hours,
+         (t2 - t1) * 1e3 / hours, (t1 - t0) / (t2 - t1), work, differ);
+  printf("Q16.16  %10.3f  %18.3f  %7.0fx  %10llu  %lu\n", (t3 - t2) * 1e3 / hours,
+         (t4 - t3) * 1e3 / hours, (t3 - t2) / (t4 - t3), work_fx, differ_fx);
+  free(ev);
+  track_free(track);
+  return differ || differ_fx;
+}
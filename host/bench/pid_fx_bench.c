@@ -0,0 +1,156 @@
+/* Cost and accuracy of the fixed-point incremental PID
+ *
+ * Description:
+ *
+ *   Measures the cycles one pid_fx_step() call takes against the same
+ *   velocity-form law in double precision, the gains of the cruise
+ *   controller (control.h) being used for both.
+ *
+ *   The accuracy check closes the loop around the Q16.16 vehicle model with
+ *   the double controller, starting at 25 m/s, for every setpoint of the
+ *   sweep. The errors of that run are replayed to pid_fx_step() in several
+ *   Q formats and its output is compared to the double output: largest and
+ *   RMS difference in throttle units, and the periods in which the throttle
+ *   sent to the vehicle (rounded to a whole unit) differs.
+ *
+ *   usage: pid-fx-bench [-n calls] [-p periods]
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "control.h"
+#include "bench.h"
+
+#define BENCH_ERRORS 4096   /* power of two */
+
+struct pid_ref {
+  double kp, ki, kd;
+  double out_min, out_max;
+  double out, e1, e2;
+};
+
+static void pid_ref_init(struct pid_ref *pid)
+{
+  pid->kp      = CONTROL_KP;
+  pid->ki      = CONTROL_KI;
+  pid->kd      = CONTROL_KD;
+  pid->out_min = 0;
+  pid->out_max = MAX_THROTTLE;
+  pid->out     = STATIONARY_THROTTLE;
+  pid->e1      = 0;
+  pid->e2      = 0;
+}
+
+static double pid_ref_step(struct pid_ref *pid, double error)
+{
+  double out = pid->out + pid->kp * (error - pid->e1) + pid->ki * error +
+               pid->kd * (error - 2 * pid->e1 + pid->e2);
+
+  if (out > pid->out_max)
+    out = pid->out_max;
+  else if (out < pid->out_min)
+    out = pid->out_min;
+  pid->e2  = pid->e1;
+  pid->e1  = error;
+  pid->out = out;
+  return out;
+}
+
+static void pid_bench_init(struct pid_fx *pid, int q)
+{
+  pid_fx_init(pid, q, PID_FX_C(CONTROL_KP, q), PID_FX_C(CONTROL_KI, q), PID_FX_C(CONTROL_KD, q),
+              0, (int32_t) MAX_THROTTLE << q);
+  pid_fx_reset(pid, (int32_t) STATIONARY_THROTTLE << q);
+}
+
+int main(int argc, char **argv)
+{
+  static const int        qs[] = {8, 12, 16, 20};
+  static int32_t          err_fx[BENCH_ERRORS];
+  static double           err_d[BENCH_ERRORS];
+  static const struct vehicle_inputs coast = {0, off, on};
+  unsigned long           calls = 10000000, k;
+  int                     periods = 400;
+  struct pid_fx           pid;
+  struct pid_ref          ref;
+  struct vehicle_fx_state car;
+  struct vehicle_inputs   in = coast;
+  double                  *errors, *outputs, u, d, max, sum, cyc_fx, cyc_d;
+  uint64_t                c0, c1;
+  int32_t                 acc = 0;
+  int                     i, j, setpoint, opt, diff;
+
+  while ((opt = getopt(argc, argv, "n:p:")) != -1) {
+    switch (opt) {
+    case 'n': calls   = strtoul(optarg, NULL, 0); break;
+    case 'p': periods = atoi(optarg); break;
+    default:
+      fprintf(stderr, "usage: %s [-n calls] [-p periods]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  /* Cycles per call on errors of up to +-40 m/s */
+  for (i = 0; i < BENCH_ERRORS; i++) {
+    err_d[i]  = ((i * 2654435761u) >> 16) % 8001 / 100.0 - 40.0;
+    err_fx[i] = PID_FX_C(err_d[i], PID_FX_Q);
+  }
+  pid_bench_init(&pid, PID_FX_Q);
+  c0 = bench_cycles();
+  for (k = 0; k < calls; k++)
+    acc += pid_fx_step(&pid, err_fx[k & (BENCH_ERRORS - 1)]);
+  c1 = bench_cycles();
+  BENCH_KEEP(acc);
+  cyc_fx = (double) (c1 - c0) / calls;
+
+  pid_ref_init(&ref);
+  u  = 0;
+  c0 = bench_cycles();
+  for (k = 0; k < calls; k++)
+    u += pid_ref_step(&ref, err_d[k & (BENCH_ERRORS - 1)]);
+  c1 = bench_cycles();
+  BENCH_KEEP(u);
+  cyc_d = (double) (c1 - c0) / calls;
+
+  printf("controller  cycles/call\n");
+  printf("double      %11.2f\n", cyc_d);
+  printf("Q%-2d         %11.2f\n\n", PID_FX_Q, cyc_fx);
+
+  /* Tracking of the double controller */
+  errors  = malloc(periods * sizeof(*errors));
+  outputs = malloc(periods * sizeof(*outputs));
+  if (errors == NULL || outputs == NULL)
+    return 1;
+  printf("setpoint   q  max|du|  rms|du|  throttle differs\n");
+  for (setpoint = 25; setpoint <= MAXIMUM_TARGET_VELOCITY; setpoint += 5) {
+    vehicle_fx_init(&car);
+    car.velocity = fix16_from_int(25);
+    pid_ref_init(&ref);
+    for (j = 0; j < periods; j++) {
+      errors[j]   = setpoint - car.velocity / 65536.0;
+      outputs[j]  = pid_ref_step(&ref, errors[j]);
+      in.throttle = (INT8U) lround(outputs[j]);
+      vehicle_fx_step(&car, &in);
+    }
+    for (i = 0; i < (int) (sizeof(qs) / sizeof(qs[0])); i++) {
+      pid_bench_init(&pid, qs[i]);
+      max  = 0;
+      sum  = 0;
+      diff = 0;
+      for (j = 0; j < periods; j++) {
+        acc = pid_fx_step(&pid, (int32_t) lround(errors[j] * (1 << qs[i])));
+        d   = fabs(acc / (double) (1 << qs[i]) - outputs[j]);
+        max = d > max ? d : max;
+        sum += d * d;
+        diff += (acc + (1 << (qs[i] - 1))) >> qs[i] != lround(outputs[j]);
+      }
+      printf("%8d  %2d  %7.5f  %7.5f  %4d/%d\n", setpoint, qs[i], max, sqrt(sum / periods),
+             diff, periods);
+    }
+  }
+  free(errors);
+  free(outputs);
+  return 0;
+}
@@ -0,0 +1,138 @@
+/* Speed of the bucketed gradient lookup
+ *
+ * Description:
+ *
+ *   Builds a random track of N segments (1 to 200 m long, gradients of
+ *   -4..4 m/s^2), or reads one with -i, and looks up the gradient at random
+ *   positions with track_gradient() and with a linear scan of the segment
+ *   table, checking that both agree everywhere on the track. -o writes the
+ *   track to a file that cruise-sim -t can drive on.
+ *
+ *   usage: track-bench [-n lookups] [-i track] [-o track] [N ...]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "track_file.h"
+#include "bench.h"
+
+static unsigned long bench_seed = 1;
+
+static unsigned long bench_rand(void)
+{
+  bench_seed = bench_seed * 6364136223846793005ull + 1442695040888963407ull;
+  return bench_seed >> 33;
+}
+
+static INT16S track_linear(const struct track *track, INT32U position)
+{
+  INT32U i;
+
+  for (i = 0; i + 1 < track->segments && track->segment[i + 1].start <= position; i++)
+    ;
+  return track->segment[i].gradient;
+}
+
+static struct track *bench_track(INT32U segments)
+{
+  struct track         *track   = malloc(sizeof(*track));
+  struct track_segment *segment = malloc(segments * sizeof(*segment));
+  INT32U               *bucket;
+  INT32U                i, start = 0, n;
+
+  if (track == NULL || segment == NULL)
+    return NULL;
+  for (i = 0; i < segments; i++) {
+    segment[i].start    = start;
+    segment[i].gradient = (INT16S) (bench_rand() % 9) - 4;
+    start += 1 + bench_rand() % 200;
+  }
+  track->length   = start - 1;
+  track->segments = segments;
+  track->segment  = segment;
+  n = track_buckets(segment, segments, track->length, &track->shift);
+  if (n == 0 || (bucket = malloc(n * sizeof(*bucket))) == NULL)
+    return NULL;
+  track_index(track, bucket);
+  return track;
+}
+
+static void bench_lookup(const struct track *track, unsigned long lookups)
+{
+  INT32U       *pos = malloc(4096 * sizeof(*pos));
+  unsigned long k, linear;
+  INT32U        p;
+  double        t0, tb, tl;
+  long          sum = 0;
+
+  if (pos == NULL)
+    abort();
+  for (p = 0; p <= track->length; p++)
+    if (track_gradient(track, p) != track_linear(track, p)) {
+      printf("mismatch at %u m\n", p);
+      exit(1);
+    }
+  for (k = 0; k < 4096; k++)
+    pos[k] = bench_rand() % (track->length + 1);
+
+  t0 = bench_now();
+  for (k = 0; k < lookups; k++)
+    sum += track_gradient(track, pos[k & 4095]);
+  tb = bench_now() - t0;
+
+  linear = lookups / (track->segments / 64 + 1) + 4096;
+  t0 = bench_now();
+  for (k = 0; k < linear; k++)
+    sum += track_linear(track, pos[k & 4095]);
+  tl = bench_now() - t0;
+  BENCH_KEEP(sum);
+
+  printf("%9u %10u %6u %14.2f %14.2f\n", track->segments, track->length, 1u << track->shift,
+         tb * 1e9 / lookups, tl * 1e9 / linear);
+  free(pos);
+}
+
+int main(int argc, char **argv)
+{
+  static const INT32U defaults[] = {6, 100, 1000, 10000};
+  unsigned long       lookups = 10000000;
+  const char         *in = NULL, *out = NULL;
+  struct track       *track;
+  int                 i, nn, opt;
+
+  while ((opt = getopt(argc, argv, "n:i:o:")) != -1) {
+    switch (opt) {
+    case 'n': lookups = strtoul(optarg, NULL, 0); break;
+    case 'i': in      = optarg; break;
+    case 'o': out     = optarg; break;
+    default:
+      fprintf(stderr, "usage: %s [-n lookups] [-i track] [-o track] [N ...]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  printf("%9s %10s %6s %14s %14s\n", "segments", "length[m]", "bucket", "bucket[ns]",
+         "linear[ns]");
+  if (in != NULL) {
+    if ((track = track_load(in)) == NULL)
+      return 1;
+    bench_lookup(track, lookups);
+    track_free(track);
+    return 0;
+  }
+  bench_lookup(&track_lab, lookups);
+  nn = optind < argc ? argc - optind : 4;
+  for (i = 0; i < nn; i++) {
+    track = bench_track(optind < argc ? strtoul(argv[optind + i], NULL, 0) : defaults[i]);
+    if (track == NULL) {
+      fprintf(stderr, "%s: cannot build the track\n", argv[0]);
+      return 1;
+    }
+    bench_lookup(track, lookups);
+    if (out != NULL && i == nn - 1 && track_save(out, track) < 0)
+      return 1;
+    track_free(track);
+  }
+  return 0;
+}
@@ -0,0 +1,289 @@
+/* Fleet simulation of the cruise control
+ *
+ * Description:
+ *
+ *   Drives a fleet of independent vehicles, each with its own ControlTask
+ *   (control_step() of model/control.c, the logic of src-merlijn), its
+ *   own driver script and its own start on the track, and sums what the
+ *   fleet did: periods driven, distance, share of the time under cruise
+ *   control and its velocity error.
+ *
+ *   The script of a vehicle is drawn from Philox (philox.h) keyed by the
+ *   seed and counted by vehicle and leg, so nothing is stored and every
+ *   vehicle drives the same whichever worker simulates it. The driver
+ *   starts the engine, accelerates and engages the cruise control, then
+ *   drives 1 to -l legs, each a stretch of cruising followed by a brake, an
+ *   overtake on the gas or a gear change and the cruise button again, and
+ *   finally brakes to a stop and turns the engine off. The number of legs
+ *   is about log-uniform, so a few vehicles take 50 times as long as most.
+ *
+ *   The vehicles are spread over the workers with parallel_steal(): every
+ *   worker has its own share and steals half of another's once it is done,
+ *   so the long trips do not keep one worker busy while the others idle.
+ *   Unless -s, the fleet is simulated with 1, 2, 4, ... up to -j workers
+ *   and the report gives the speedup and the parallel efficiency of each,
+ *   the steals, and the busiest worker against the mean.
+ *
+ *   usage: fleet-sim [-n vehicles] [-l legs] [-S seed] [-j workers] [-c chunk] [-s]
+ *                    [-t track]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "control.h"
+#include "parallel.h"
+#include "philox.h"
+#include "track_file.h"
+#include "bench.h"
+
+#define FLEET_LEGS_MAX   1024
+#define FLEET_STOP_MAX   200         /* periods of braking before giving up */
+
+/* Philox counters of the start and the end, the legs count from 0 */
+#define FLEET_START      0xFFFFFFFFu
+
+struct fleet {
+  const struct track *track;
+  uint64_t            seed;
+  INT32U              legs;           /* at most, per vehicle */
+  size_t              vehicles;
+  struct fleet_stats *worker;
+};
+
+struct fleet_stats {
+  uint64_t vehicles;
+  uint64_t periods;
+  uint64_t distance;                  /* sum of the velocities, m/s per period */
+  uint64_t cruising;                  /* periods */
+  uint64_t error;                     /* sum of |target - velocity| while cruising */
+  uint64_t engagements;
+  uint64_t checksum;                  /* sum of a hash of every vehicle's end */
+  double   busy;                      /* s */
+  char     pad[64];
+};
+
+struct fleet_car {
+  struct vehicle_state   car;
+  struct control_state   ctrl;
+  struct vehicle_inputs  drive;
+  struct fleet_stats    *stats;
+};
+
+static uint64_t fleet_mix(uint64_t z)
+{
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  return z ^ (z >> 31);
+}
+
+/* Draws four numbers for leg 'leg' of vehicle 'v' */
+static void fleet_draw(const struct fleet *f, uint64_t v, uint32_t leg, uint32_t u[4])
+{
+  uint32_t ctr[4] = {(uint32_t) v, (uint32_t) (v >> 32), leg, 0};
+
+  philox4x32(ctr, f->seed, u);
+}
+
+/* One period of ControlTask and VehicleTask, as the tasks pass the values */
+static void fleet_step(struct fleet_car *c, INT8U buttons, int switches, INT32U periods)
+{
+  struct control_inputs  in;
+  struct control_outputs out;
+  struct fleet_stats    *st = c->stats;
+  enum active            was;
+  INT32U                 k;
+
+  in.buttons  = buttons;
+  in.switches = switches;
+  for (k = 0; k < periods; k++) {
+    was         = c->ctrl.cruise_control;
+    in.velocity = c->car.velocity;
+    control_step(&c->ctrl, &in, &out);
+    c->drive.throttle    = out.throttle;
+    c->drive.brake_pedal = out.brake;
+    if (out.engine != 0)
+      c->drive.engine = out.engine;
+    vehicle_step(&c->car, &c->drive);
+
+    st->periods++;
+    st->distance += c->car.velocity > 0 ? c->car.velocity : -c->car.velocity;
+    if (c->ctrl.cruise_control == on) {
+      st->cruising++;
+      st->error += abs(c->ctrl.target_velocity - c->car.velocity);
+      st->engagements += was != on;
+    }
+  }
+}
+
+static void fleet_drive(const struct fleet *f, uint64_t v, struct fleet_stats *st)
+{
+  static const int running = ENGINE_FLAG | TOP_GEAR_FLAG;
+  struct fleet_car c;
+  uint32_t         u[4];
+  INT32U           legs, leg, k, bits;
+
+  fleet_draw(f, v, FLEET_START, u);
+  vehicle_init(&c.car);
+  control_init(&c.ctrl);
+  c.car.track     = f->track;
+  c.ctrl.track    = f->track;
+  c.car.position  = u[0] % f->track->length;
+  c.ctrl.position = c.car.position;
+  c.drive.throttle    = 0;
+  c.drive.brake_pedal = off;
+  c.drive.engine      = off;
+  c.stats             = st;
+  for (bits = 0; 2u << bits <= f->legs; bits++)
+    ;
+  legs = 1u << u[2] % (bits + 1);
+  legs = 1 + u[1] % (legs < f->legs ? legs : f->legs);
+
+  /* start the engine, accelerate, engage */
+  fleet_step(&c, 0, running, 1);
+  fleet_step(&c, GAS_PEDAL_FLAG, running, 5 + u[3] % 16);
+  fleet_step(&c, CRUISE_CONTROL_FLAG, running, 1);
+
+  for (leg = 0; leg < legs; leg++) {
+    fleet_draw(f, v, leg, u);
+    fleet_step(&c, 0, running, 20 + (u[0] & 0xFF));
+    switch (u[1] & 3) {
+    case 1:                          /* brake, then back up to speed */
+      fleet_step(&c, BRAKE_PEDAL_FLAG, running, 1 + u[2] % 4);
+      fleet_step(&c, GAS_PEDAL_FLAG, running, 2 + u[3] % 8);
+      break;
+    case 2:                          /* overtake */
+      fleet_step(&c, GAS_PEDAL_FLAG, running, 1 + u[2] % 8);
+      break;
+    case 3:                          /* out of top gear for a while */
+      fleet_step(&c, 0, ENGINE_FLAG, 2 + u[2] % 8);
+      fleet_step(&c, GAS_PEDAL_FLAG, running, 2 + u[3] % 4);
+      break;
+    default:
+      break;
+    }
+    fleet_step(&c, CRUISE_CONTROL_FLAG, running, 1);
+  }
+
+  /* brake to a stop, engine off */
+  for (k = 0; k < FLEET_STOP_MAX && c.car.velocity != 0; k++)
+    fleet_step(&c, BRAKE_PEDAL_FLAG, running, 1);
+  fleet_step(&c, 0, 0, 2);
+
+  st->vehicles++;
+  st->checksum += fleet_mix(v ^ (uint64_t) c.car.position << 32 ^
+                            (uint64_t) (INT16U) c.car.velocity << 16 ^ c.ctrl.engine_state);
+}
+
+static void fleet_chunk(size_t begin, size_t end, int worker, void *arg)
+{
+  struct fleet       *f  = arg;
+  struct fleet_stats *st = &f->worker[worker];
+  double              t0 = bench_now();
+  size_t              v;
+
+  for (v = begin; v < end; v++)
+    fleet_drive(f, v, st);
+  st->busy += bench_now() - t0;
+}
+
+/* Simulates the fleet on 'workers'; returns the steals or -1, the sums in 'total' */
+static long fleet_run(struct fleet *f, int workers, size_t chunk, struct fleet_stats *total,
+                      double *busiest)
+{
+  long steals;
+  int  i;
+
+  f->worker = calloc(workers, sizeof(*f->worker));
+  if (f->worker == NULL)
+    return -1;
+  steals = parallel_steal(f->vehicles, chunk, workers, fleet_chunk, f);
+  *total   = f->worker[0];
+  *busiest = f->worker[0].busy;
+  for (i = 1; i < workers; i++) {
+    total->vehicles    += f->worker[i].vehicles;
+    total->periods     += f->worker[i].periods;
+    total->distance    += f->worker[i].distance;
+    total->cruising    += f->worker[i].cruising;
+    total->error       += f->worker[i].error;
+    total->engagements += f->worker[i].engagements;
+    total->checksum    += f->worker[i].checksum;
+    total->busy        += f->worker[i].busy;
+    if (f->worker[i].busy > *busiest)
+      *busiest = f->worker[i].busy;
+  }
+  free(f->worker);
+  return steals;
+}
+
+int main(int argc, char **argv)
+{
+  struct fleet       f = {NULL, 0xF1EE7, 64, 100000, NULL};
+  struct fleet_stats total, first = {0};
+  struct track      *track = NULL;
+  double  t0, t1, t_one = 0, busiest, step = CONTROL_STEP_MS / 1000.0;
+  size_t  chunk = 1;
+  long    steals;
+  int     opt, workers = 0, single = 0, w;
+
+  while ((opt = getopt(argc, argv, "n:l:S:j:c:st:")) != -1) {
+    switch (opt) {
+    case 'n': f.vehicles = strtoull(optarg, NULL, 0); break;
+    case 'l': f.legs = strtoul(optarg, NULL, 0); break;
+    case 'S': f.seed = strtoull(optarg, NULL, 0); break;
+    case 'j': workers = atoi(optarg); break;
+    case 'c': chunk = strtoull(optarg, NULL, 0); break;
+    case 's': single = 1; break;
+    case 't':
+      if ((track = track_load(optarg)) == NULL)
+        return 1;
+      break;
+    default:
+      goto usage;
+    }
+  }
+  if (f.legs < 1 || f.legs > FLEET_LEGS_MAX || f.vehicles < 1)
+    goto usage;
+  f.track = track != NULL ? track : track_default;
+  workers = parallel_workers(workers);
+
+  printf("workers  seconds  Mperiods/s  speedup  efficiency  steals  busiest/mean\n");
+  for (w = single ? workers : 1; ; w = w * 2 < workers ? w * 2 : workers) {
+    t0     = bench_now();
+    steals = fleet_run(&f, w, chunk, &total, &busiest);
+    t1     = bench_now();
+    if (steals < 0) {
+      fprintf(stderr, "%s: out of memory\n", argv[0]);
+      return 2;
+    }
+    if (w == 1) {
+      t_one = t1 - t0;
+      first = total;
+    }
+    printf("%7d  %7.3f  %10.2f", w, t1 - t0, total.periods / (t1 - t0) / 1e6);
+    if (t_one > 0)
+      printf("  %7.2f  %9.1f%%", t_one / (t1 - t0), 100.0 * t_one / (t1 - t0) / w);
+    else
+      printf("  %7s  %10s", "-", "-");
+    printf("  %6ld  %12.2f\n", steals, busiest / (total.busy / w));
+    if (t_one > 0 && (total.checksum != first.checksum || total.periods != first.periods))
+      fprintf(stderr, "%s: %d workers drove a different fleet than 1\n", argv[0], w);
+    if (w == workers)
+      break;
+  }
+  printf("fleet: %llu vehicles, %llu periods (%.1f h of driving), %.0f km\n",
+         (unsigned long long) total.vehicles, (unsigned long long) total.periods,
+         total.periods * step / 3600, total.distance * step / 1000);
+  printf("cruising %.1f %% of the time, %.2f engagements per vehicle, mean |error| %.3f m/s, "
+         "checksum %016llx\n", 100.0 * total.cruising / total.periods,
+         (double) total.engagements / total.vehicles,
+         total.cruising ? (double) total.error / total.cruising : 0.0,
+         (unsigned long long) total.checksum);
+  track_free(track);
+  return 0;
+
+usage:
+  fprintf(stderr, "usage: %s [-n vehicles] [-l legs] [-S seed] [-j workers] [-c chunk] [-s]\n"
+          "       [-t track]\n", argv[0]);
+  return 2;
+}
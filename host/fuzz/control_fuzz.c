@@ -0,0 +1,304 @@
+/* Fuzz target of the cruise controller mode logic
+ *
+ * Description:
+ *
+ *   Drives control_step() (model/control.c, the ControlTask logic of
+ *   src-merlijn) with sequences of velocity, button and switch inputs and
+ *   checks after every step that
+ *
+ *     - the cruise control is only on in top gear,
+ *     - the throttle is within [0, MAX_THROTTLE],
+ *     - the brake dominates: with the brake pedal pressed the brake is
+ *       applied, the throttle is 0 and the cruise control is off,
+ *     - the engine is only stopped at zero velocity.
+ *
+ *   An input is a mode byte, then FUZZ_STEP bytes per step: the velocity
+ *   (INT16S, little endian), the buttons and the switches. The bits of the
+ *   mode turn on the gain schedule, the feed-forward and the MPC table of
+ *   the lab track (FUZZ_SCHEDULE, ...), whatever the build flags, so that
+ *   every combination is checked. LLVMFuzzerTestOneInput() runs one and
+ *   aborts on a violation, so the file builds as a libFuzzer target as well:
+ *
+ *     clang -fsanitize=fuzzer -DCONTROL_FUZZ_LIBFUZZER -Iinclude -Iucos -I../model \
+ *           fuzz/control_fuzz.c ../model/{control,control_mpc_lab,pid_fx,track,vehicle}.c
+ *
+ *   Without libFuzzer, main() generates the inputs itself on all CPUs:
+ *   input i is a pure function of (seed, i) (Philox, philox.h), with the
+ *   velocities drawn mostly around the thresholds of the mode logic. The
+ *   lowest failing input is shortened to the step that fails, printed and
+ *   written to -o; -r replays such a file.
+ *
+ *   usage: control-fuzz [-n inputs] [-l steps] [-S seed] [-j workers] [-o crash]
+ *          control-fuzz -r crash
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "control.h"
+
+#define FUZZ_STEP 4                  /* bytes per step */
+
+/* Bits of the mode byte */
+#define FUZZ_SCHEDULE     0x1        /* control_schedule_lab */
+#define FUZZ_FEED_FORWARD 0x2        /* control_offsets_lab */
+#define FUZZ_MPC          0x4        /* control_mpc_lab */
+
+struct fuzz_failure {
+  const char *what;
+  size_t      step;
+};
+
+static const char *fuzz_check(const struct control_state *state,
+                              const struct control_inputs *in,
+                              const struct control_outputs *out)
+{
+  if (state->cruise_control == on && state->top_gear != on)
+    return "cruise control on without top gear";
+  if (state->cruise_control == on && !(in->switches & TOP_GEAR_FLAG))
+    return "cruise control on with the top gear switch off";
+  if (out->throttle > MAX_THROTTLE || state->throttle > MAX_THROTTLE)
+    return "throttle out of [0, MAX_THROTTLE]";
+  if ((in->buttons & BRAKE_PEDAL_FLAG) &&
+      (out->brake != on || out->throttle != 0 || state->cruise_control == on))
+    return "brake pedal does not dominate";
+  if (out->engine == off && in->velocity != 0)
+    return "engine stopped while moving";
+  return NULL;
+}
+
+/* Runs the steps of an input; returns 0, or -1 and what failed where */
+static int fuzz_run(const uint8_t *data, size_t size, struct fuzz_failure *failure)
+{
+  struct control_state   state;
+  struct control_inputs  in;
+  struct control_outputs out;
+  const char            *what;
+  size_t                 k;
+
+  if (size == 0)
+    return 0;
+  control_init(&state);
+  state.schedule     = data[0] & FUZZ_SCHEDULE ? &control_schedule_lab : NULL;
+  state.feed_forward = data[0] & FUZZ_FEED_FORWARD ? &control_offsets_lab : NULL;
+  state.mpc          = data[0] & FUZZ_MPC ? &control_mpc_lab : NULL;
+  for (k = 1; k + FUZZ_STEP <= size; k += FUZZ_STEP) {
+    in.velocity = (INT16S) (data[k] | data[k + 1] << 8);
+    in.buttons  = data[k + 2];
+    in.switches = data[k + 3];
+    control_step(&state, &in, &out);
+    if ((what = fuzz_check(&state, &in, &out)) != NULL) {
+      failure->what = what;
+      failure->step = (k - 1) / FUZZ_STEP;
+      return -1;
+    }
+  }
+  return 0;
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+  struct fuzz_failure failure;
+
+  if (fuzz_run(data, size, &failure) < 0) {
+    fprintf(stderr, "step %zu: %s\n", failure.step, failure.what);
+    abort();
+  }
+  return 0;
+}
+
+#ifndef CONTROL_FUZZ_LIBFUZZER
+
+#include "parallel.h"
+#include "philox.h"
+#include "bench.h"
+
+#define FUZZ_MAX_STEPS 256
+#define FUZZ_MAX_SIZE  (1 + FUZZ_MAX_STEPS * FUZZ_STEP)
+#define FUZZ_CHUNK     4096
+
+/* Velocities the mode logic compares against, and the ends of the range */
+static const INT16S fuzz_edges[] = {
+  0, 1, -1, 19, 20, 21, 24, 25, 26, MAXIMUM_TARGET_VELOCITY - 1, MAXIMUM_TARGET_VELOCITY,
+  MAXIMUM_TARGET_VELOCITY + 1, 2 * MAXIMUM_TARGET_VELOCITY, INT16_MAX, INT16_MIN,
+};
+
+struct fuzz_job {
+  uint64_t seed;
+  size_t   steps;                    /* at most, per input */
+  size_t   first_failure;            /* lowest failing input, SIZE_MAX if none */
+  size_t   executed_steps;
+};
+
+/* splitmix64, seeded per input from Philox */
+static inline uint64_t fuzz_next(uint64_t *x)
+{
+  uint64_t z = (*x += 0x9E3779B97F4A7C15ull);
+
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  return z ^ (z >> 31);
+}
+
+/*
+ * Writes input i of the job to 'data' and returns its size. Philox keyed
+ * by the seed gives the mode, the length and the state of a splitmix64
+ * stream that draws the steps: the velocity is an edge, near the last one or anything,
+ * the buttons mostly the four keys, the switches mostly the engine and top
+ * gear.
+ */
+static size_t fuzz_input(const struct fuzz_job *job, size_t i, uint8_t *data)
+{
+  uint32_t ctr[4] = {(uint32_t) i, (uint32_t) ((uint64_t) i >> 32), 0, 0};
+  uint32_t u[4];
+  uint64_t x, r;
+  size_t   n, k;
+  INT16S   v = 0;
+
+  philox4x32(ctr, job->seed, u);
+  n = 1 + u[0] % job->steps;
+  x = (uint64_t) u[1] << 32 | u[2];
+  data[0] = (uint8_t) (u[3] & (FUZZ_SCHEDULE | FUZZ_FEED_FORWARD | FUZZ_MPC));
+  data++;
+  for (k = 0; k < n; k++) {
+    r = fuzz_next(&x);
+    switch (r & 3) {
+    case 0:  v = fuzz_edges[(r >> 2 & 0xFF) % (sizeof(fuzz_edges) / sizeof(fuzz_edges[0]))]; break;
+    case 1:
+    case 2:  v = (INT16S) (v + (INT32S) ((r >> 2 & 0xFF) % 7) - 3); break;
+    default: v = (INT16S) (r >> 16); break;
+    }
+    data[k * FUZZ_STEP]     = (uint8_t) v;
+    data[k * FUZZ_STEP + 1] = (uint8_t) ((uint16_t) v >> 8);
+    data[k * FUZZ_STEP + 2] = (uint8_t) ((r & 0x7ull << 32) ? r >> 40 & 0xF : r >> 40);
+    data[k * FUZZ_STEP + 3] = (uint8_t) ((r & 0x7ull << 35) ? r >> 48 & 0x3 : r >> 48);
+  }
+  return 1 + n * FUZZ_STEP;
+}
+
+static void fuzz_chunk(size_t begin, size_t end, int worker, void *arg)
+{
+  struct fuzz_job    *job = arg;
+  struct fuzz_failure failure;
+  uint8_t             data[FUZZ_MAX_SIZE];
+  size_t              i, size, steps = 0, first;
+
+  /* Past a failure only a lower one matters */
+  if (begin > __atomic_load_n(&job->first_failure, __ATOMIC_RELAXED))
+    return;
+  for (i = begin; i < end; i++) {
+    size   = fuzz_input(job, i, data);
+    steps += size / FUZZ_STEP;
+    if (fuzz_run(data, size, &failure) == 0)
+      continue;
+    first = __atomic_load_n(&job->first_failure, __ATOMIC_RELAXED);
+    while (i < first && !__atomic_compare_exchange_n(&job->first_failure, &first, i, 0,
+                                                     __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+      ;
+    break;
+  }
+  __atomic_fetch_add(&job->executed_steps, steps, __ATOMIC_RELAXED);
+}
+
+static int fuzz_replay(const char *path)
+{
+  struct fuzz_failure failure;
+  uint8_t            *data;
+  FILE               *f = fopen(path, "rb");
+  long                size;
+
+  if (f == NULL || fseek(f, 0, SEEK_END) != 0 || (size = ftell(f)) < 0) {
+    perror(path);
+    return 2;
+  }
+  rewind(f);
+  data = malloc(size ? (size_t) size : 1);
+  if (data == NULL || fread(data, 1, (size_t) size, f) != (size_t) size) {
+    perror(path);
+    return 2;
+  }
+  fclose(f);
+  if (fuzz_run(data, (size_t) size, &failure) == 0) {
+    printf("%s: %ld steps, no violation\n", path, size ? (size - 1) / FUZZ_STEP : 0);
+    free(data);
+    return 0;
+  }
+  printf("%s: step %zu: %s\n", path, failure.step, failure.what);
+  free(data);
+  return 1;
+}
+
+static void fuzz_report(const struct fuzz_job *job, const char *out)
+{
+  struct fuzz_failure failure;
+  uint8_t             data[FUZZ_MAX_SIZE];
+  size_t              size = fuzz_input(job, job->first_failure, data), k;
+  FILE               *f;
+
+  fuzz_run(data, size, &failure);
+  size = 1 + (failure.step + 1) * FUZZ_STEP;
+  printf("input %zu fails at step %zu: %s\n", job->first_failure, failure.step, failure.what);
+  printf("mode 0x%x: schedule %s, feed-forward %s, mpc %s\n", data[0],
+         data[0] & FUZZ_SCHEDULE ? "on" : "off", data[0] & FUZZ_FEED_FORWARD ? "on" : "off",
+         data[0] & FUZZ_MPC ? "on" : "off");
+  printf("step  velocity  buttons  switches\n");
+  for (k = 1; k < size; k += FUZZ_STEP)
+    printf("%4zu  %8d     0x%02x      0x%02x\n", (k - 1) / FUZZ_STEP,
+           (INT16S) (data[k] | data[k + 1] << 8), data[k + 2], data[k + 3]);
+  if (out == NULL)
+    return;
+  if ((f = fopen(out, "wb")) == NULL || fwrite(data, 1, size, f) != size || fclose(f) != 0)
+    perror(out);
+  else
+    printf("written to %s, replay with -r\n", out);
+}
+
+int main(int argc, char **argv)
+{
+  struct fuzz_job job = {0x5EED, 16, SIZE_MAX, 0};
+  const char     *out = NULL;
+  size_t          n = 10000000;
+  double          t0, t1;
+  int             opt, workers = 0;
+
+  while ((opt = getopt(argc, argv, "n:l:S:j:o:r:")) != -1) {
+    switch (opt) {
+    case 'n': n = strtoull(optarg, NULL, 0); break;
+    case 'l': job.steps = strtoull(optarg, NULL, 0); break;
+    case 'S': job.seed = strtoull(optarg, NULL, 0); break;
+    case 'j': workers = atoi(optarg); break;
+    case 'o': out = optarg; break;
+    case 'r': return fuzz_replay(optarg);
+    default:
+      goto usage;
+    }
+  }
+  if (job.steps < 1 || job.steps > FUZZ_MAX_STEPS)
+    goto usage;
+  workers = parallel_workers(workers);
+
+  t0 = bench_now();
+  if (parallel_for(n, FUZZ_CHUNK, workers, fuzz_chunk, &job) < 0) {
+    fprintf(stderr, "%s: out of memory\n", argv[0]);
+    return 2;
+  }
+  t1 = bench_now();
+  fprintf(stderr, "[fuzz] %zu steps on %d workers: %.3f s, %.1f M steps/s\n",
+          job.executed_steps, workers, t1 - t0, job.executed_steps / (t1 - t0) / 1e6);
+  if (job.first_failure == SIZE_MAX) {
+    fprintf(stderr, "[fuzz] %zu inputs, %.2f M inputs/s, no violation\n", n,
+            n / (t1 - t0) / 1e6);
+    return 0;
+  }
+  fuzz_report(&job, out);
+  return 1;
+
+usage:
+  fprintf(stderr, "usage: %s [-n inputs] [-l steps] [-S seed] [-j workers] [-o crash]\n"
+          "       %s -r crash\n", argv[0], argv[0]);
+  return 2;
+}
+
+#endif /* CONTROL_FUZZ_LIBFUZZER */
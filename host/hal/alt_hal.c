@@ -0,0 +1,418 @@
+/* Altera HAL services for the POSIX host port
+ *
+ * Description:
+ *
+ *   The PIO register file, the system clock alarms, the performance counter
+ *   and the start-up code that initializes the kernel before main() (on the
+ *   board alt_main() does this). The system clock also records and replays
+ *   the input traces of alt_host.h.
+ *
+ *   UCOS_HOST_BOARD=file maps the PIO registers onto a file before main()
+ *   (alt_host_board()), for board-io or any other process to press the
+ *   keys and watch the LEDs and the displays of the running program.
+ */
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "system.h"
+#include "includes.h"
+#include "altera_avalon_performance_counter.h"
+#include "alt_host.h"
+#include "os_port.h"
+#include "sys/alt_alarm.h"
+#include "sys/alt_irq.h"
+
+volatile alt_u32 alt_host_pio[ALT_HOST_PIO_PAGE / sizeof(alt_u32)]
+  __attribute__((aligned(ALT_HOST_PIO_PAGE))) = {
+  [ALT_HOST_PIO_KEYS * 4] = 0xF,      /* KEY0-3 released (active low) */
+};
+
+static int alt_host_mapped;           /* alt_host_pio[] is a board file */
+
+struct alt_host_perf alt_host_perf;
+
+static alt_alarm *alt_alarm_list;
+static alt_u32    alt_host_nticks;
+
+static void alt_host_trace_tick(void);
+
+/*
+ * Start-up
+ */
+void alt_host_reset(void)
+{
+  alt_alarm *alarm;
+  alt_u32    keys = 0xF, toggles = 0;
+
+  for (alarm = alt_alarm_list; alarm != NULL; alarm = alarm->next)
+    alarm->running = 0;
+  alt_alarm_list  = NULL;
+  alt_host_nticks = 0;
+  if (alt_host_mapped) {              /* the inputs stay as the outside left them */
+    keys    = alt_host_pio[ALT_HOST_PIO_KEYS * 4];
+    toggles = alt_host_pio[ALT_HOST_PIO_TOGGLES * 4];
+  }
+  memset((void *) alt_host_pio, 0, ALT_HOST_PIO_COUNT * 4 * sizeof(alt_host_pio[0]));
+  alt_host_pio[ALT_HOST_PIO_KEYS * 4]    = keys;
+  alt_host_pio[ALT_HOST_PIO_TOGGLES * 4] = toggles;
+  memset(&alt_host_perf, 0, sizeof(alt_host_perf));
+  OSInit();
+}
+
+int alt_host_board(const char *path)
+{
+  struct stat st;
+  long        page = sysconf(_SC_PAGESIZE);
+  void       *map;
+  int         fd;
+
+  if (page <= 0 || sizeof(alt_host_pio) % (unsigned long) page != 0) {
+    fprintf(stderr, "%s: pages of %ld bytes do not fit the %u bytes of PIO registers\n", path,
+            page, ALT_HOST_PIO_PAGE);
+    return -1;
+  }
+  if ((fd = open(path, O_RDWR | O_CREAT, 0666)) < 0 || fstat(fd, &st) < 0) {
+    perror(path);
+    if (fd >= 0)
+      close(fd);
+    return -1;
+  }
+  /* a new board starts with the registers as they are */
+  if (st.st_size < (off_t) sizeof(alt_host_pio) &&
+      (ftruncate(fd, sizeof(alt_host_pio)) < 0 ||
+       pwrite(fd, (const void *) alt_host_pio, sizeof(alt_host_pio), 0) !=
+         (ssize_t) sizeof(alt_host_pio))) {
+    perror(path);
+    close(fd);
+    return -1;
+  }
+  map = mmap((void *) alt_host_pio, sizeof(alt_host_pio), PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_FIXED, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    perror(path);
+    return -1;
+  }
+  alt_host_mapped = 1;
+  return 0;
+}
+
+static void __attribute__((constructor)) alt_host_main(void)
+{
+  const char *board = getenv("UCOS_HOST_BOARD");
+
+  if (board != NULL && alt_host_board(board) < 0)
+    exit(1);
+  alt_host_reset();
+}
+
+/*
+ * System clock and alarms
+ */
+
+alt_u32 alt_ticks_per_second(void)
+{
+  return ALT_SYS_CLK_TICKS_PER_SEC;
+}
+
+alt_u32 alt_nticks(void)
+{
+  return alt_host_nticks;
+}
+
+int alt_alarm_start(alt_alarm *alarm, alt_u32 nticks,
+                    alt_u32 (*callback)(void *context), void *context)
+{
+  alt_irq_context irq;
+
+  if (alarm == NULL || callback == NULL)
+    return -1;
+
+  irq = alt_irq_disable_all();
+  alarm->callback = callback;
+  alarm->context  = context;
+  alarm->time     = alt_host_nticks + nticks + 1;   /* At least nticks full ticks */
+  if (!alarm->running) {
+    alarm->next    = alt_alarm_list;
+    alt_alarm_list = alarm;
+    alarm->running = 1;
+  }
+  alt_irq_enable_all(irq);
+  return 0;
+}
+
+void alt_alarm_stop(alt_alarm *alarm)
+{
+  alt_irq_context irq = alt_irq_disable_all();
+  alt_alarm     **link;
+
+  for (link = &alt_alarm_list; *link != NULL; link = &(*link)->next) {
+    if (*link == alarm) {
+      *link = alarm->next;
+      alarm->running = 0;
+      break;
+    }
+  }
+  alt_irq_enable_all(irq);
+}
+
+void alt_tick(void)
+{
+  alt_alarm **link = &alt_alarm_list;
+  alt_alarm  *alarm;
+  alt_u32     next;
+
+  alt_host_nticks++;
+  alt_host_trace_tick();
+  while ((alarm = *link) != NULL) {
+    if ((alt_32) (alt_host_nticks - alarm->time) >= 0) {
+      next = alarm->callback(alarm->context);
+      if (next == 0) {
+        *link = alarm->next;
+        alarm->running = 0;
+        continue;
+      }
+      alarm->time += next;
+    }
+    link = &alarm->next;
+  }
+  OSTimeTick();
+}
+
+/*
+ * Input traces
+ */
+
+/* Trace PIO number -> register file */
+static const int        alt_host_trace_pio[2] = {ALT_HOST_PIO_KEYS, ALT_HOST_PIO_TOGGLES};
+
+static struct alt_trace alt_host_rec;
+static FILE            *alt_host_rec_file;
+
+static struct alt_trace alt_host_play;
+static int              alt_host_playing;   /* the record below is pending */
+static alt_u32          alt_host_play_time;
+static int              alt_host_play_pio;
+static alt_u32          alt_host_play_value;
+
+static void alt_host_rec_put(int pio, alt_u32 value)
+{
+  /* Written through, so that a killed program still leaves its trace */
+  if (alt_trace_put(&alt_host_rec, alt_host_nticks, pio, value) == 0) {
+    fwrite(alt_host_rec.data, 1, alt_host_rec.used, alt_host_rec_file);
+    fflush(alt_host_rec_file);
+    alt_host_rec.used = 0;
+  }
+}
+
+static void alt_host_trace_tick(void)
+{
+  alt_u32 value;
+  int     pio;
+
+  while (alt_host_playing && (alt_32) (alt_host_nticks - alt_host_play_time) >= 0) {
+    alt_host_pio[alt_host_trace_pio[alt_host_play_pio] * 4] = alt_host_play_value;
+    alt_host_playing = alt_trace_get(&alt_host_play, &alt_host_play_time, &alt_host_play_pio,
+                                     &alt_host_play_value) == 0;
+  }
+  if (alt_host_rec_file == NULL)
+    return;
+  for (pio = 0; pio < 2; pio++) {
+    value = alt_host_pio[alt_host_trace_pio[pio] * 4];
+    if (value != alt_host_rec.value[pio])
+      alt_host_rec_put(pio, value);
+  }
+}
+
+int alt_host_record(const char *path)
+{
+  alt_u8 header[ALT_TRACE_HEADER];
+  int    pio;
+
+  if (alt_host_rec_file != NULL)
+    fclose(alt_host_rec_file);
+  alt_host_rec_file = NULL;
+  alt_trace_free(&alt_host_rec);
+  if (path == NULL)
+    return 0;
+
+  alt_host_rec_file = fopen(path, "wb");
+  if (alt_host_rec_file == NULL) {
+    perror(path);
+    return -1;
+  }
+  alt_trace_header(header);
+  fwrite(header, 1, sizeof(header), alt_host_rec_file);
+  /* The trace starts with the inputs as they are */
+  for (pio = 0; pio < 2; pio++)
+    alt_host_rec_put(pio, alt_host_pio[alt_host_trace_pio[pio] * 4]);
+  return 0;
+}
+
+int alt_host_replay(const char *path, alt_u32 *end)
+{
+  alt_host_playing = 0;
+  alt_trace_free(&alt_host_play);
+  if (alt_trace_load(&alt_host_play, path) < 0)
+    return -1;
+
+  *end = 0;
+  while (alt_trace_get(&alt_host_play, &alt_host_play_time, &alt_host_play_pio,
+                       &alt_host_play_value) == 0)
+    *end = alt_host_play_time;
+  alt_trace_rewind(&alt_host_play);
+  alt_host_playing = alt_trace_get(&alt_host_play, &alt_host_play_time, &alt_host_play_pio,
+                                   &alt_host_play_value) == 0;
+  alt_host_trace_tick();
+  return 0;
+}
+
+alt_u32 alt_alarm_next(void)
+{
+  alt_alarm *alarm;
+  alt_u32    next = 0xFFFFFFFFu;
+  alt_32     left;
+
+  for (alarm = alt_alarm_list; alarm != NULL; alarm = alarm->next) {
+    left = (alt_32) (alarm->time - alt_host_nticks);
+    if (left < 1)
+      left = 1;
+    if ((alt_u32) left < next)
+      next = (alt_u32) left;
+  }
+  /* A replayed input change is an event as well */
+  if (alt_host_playing) {
+    left = (alt_32) (alt_host_play_time - alt_host_nticks);
+    if (left < 1)
+      left = 1;
+    if ((alt_u32) left < next)
+      next = (alt_u32) left;
+  }
+  return next;
+}
+
+void alt_tick_skip(alt_u32 nticks)
+{
+  alt_host_nticks += nticks;
+  OSTimeTickN(nticks);
+  alt_host_trace_tick();
+}
+
+/*
+ * Performance counter
+ */
+
+static alt_u64 alt_host_now_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (alt_u64) ts.tv_sec * 1000000000ull + (alt_u64) ts.tv_nsec;
+}
+
+static alt_u64 alt_host_ns2cycles(alt_u64 ns)
+{
+  return ns * (ALT_CPU_FREQ / 1000000u) / 1000u;
+}
+
+void alt_host_perf_reset(void *base)
+{
+  struct alt_host_perf *perf = base;
+
+  memset(perf, 0, sizeof(*perf));
+}
+
+void alt_host_perf_start(void *base)
+{
+  struct alt_host_perf *perf = base;
+
+  if (perf->start == 0)
+    perf->start = alt_host_now_ns();
+}
+
+void alt_host_perf_stop(void *base)
+{
+  struct alt_host_perf *perf = base;
+  alt_u64               now  = alt_host_now_ns();
+
+  if (perf->start != 0) {
+    perf->total += now - perf->start;
+    perf->start  = 0;
+    perf->stop   = now;
+  }
+}
+
+void alt_host_perf_begin(void *base, int section)
+{
+  struct alt_host_perf *perf = base;
+
+  if (section < 0 || section >= ALT_HOST_PERF_SECTIONS || perf->start == 0)
+    return;
+  perf->begin[section] = alt_host_now_ns();
+  perf->starts[section]++;
+}
+
+void alt_host_perf_end(void *base, int section)
+{
+  struct alt_host_perf *perf = base;
+  alt_u64               end  = alt_host_now_ns();
+
+  if (section < 0 || section >= ALT_HOST_PERF_SECTIONS || perf->begin[section] == 0)
+    return;
+  /* A section stops counting together with the global counter */
+  if (perf->start == 0)
+    end = perf->stop > perf->begin[section] ? perf->stop : perf->begin[section];
+  perf->time[section] += end - perf->begin[section];
+  perf->begin[section] = 0;
+}
+
+alt_u64 perf_get_total_time(void *hw_base_address)
+{
+  struct alt_host_perf *perf = hw_base_address;
+  alt_u64               ns   = perf->total;
+
+  if (perf->start != 0)
+    ns += alt_host_now_ns() - perf->start;
+  return alt_host_ns2cycles(ns);
+}
+
+alt_u64 perf_get_section_time(void *hw_base_address, int which_section)
+{
+  struct alt_host_perf *perf = hw_base_address;
+
+  if (which_section < 0 || which_section >= ALT_HOST_PERF_SECTIONS)
+    return 0;
+  return alt_host_ns2cycles(perf->time[which_section]);
+}
+
+alt_u32 perf_get_num_starts(void *hw_base_address, int which_section)
+{
+  struct alt_host_perf *perf = hw_base_address;
+
+  if (which_section < 0 || which_section >= ALT_HOST_PERF_SECTIONS)
+    return 0;
+  return perf->starts[which_section];
+}
+
+alt_u32 alt_get_cpu_freq(void)
+{
+  return ALT_CPU_FREQ;
+}
+
+/*
+ * Console
+ */
+void alt_printf(const char *fmt, ...)
+{
+  va_list args;
+
+  va_start(args, fmt);
+  vprintf(fmt, args);
+  va_end(args);
+}
@@ -0,0 +1,165 @@
+/* Input traces of the host HAL, see alt_host.h
+ *
+ * File layout: "ITR1", the ticks per second as a little-endian 32 bit
+ * word, then one record per change, each two LEB128 numbers: the ticks
+ * since the previous record shifted left by one with the PIO (0 keys,
+ * 1 toggles) in bit 0, and the new value XOR the last one of that PIO.
+ * A key press or a switch flip costs two to four bytes.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "system.h"
+#include "alt_host.h"
+
+static const char alt_trace_magic[4] = {'I', 'T', 'R', '1'};
+
+static int alt_trace_grow(struct alt_trace *t)
+{
+  alt_u8 *data = realloc(t->data, t->size * 2 + 64);
+
+  if (data == NULL)
+    return -1;
+  t->data = data;
+  t->size = t->size * 2 + 64;
+  return 0;
+}
+
+static int alt_trace_byte(struct alt_trace *t, alt_u8 byte)
+{
+  if (t->used == t->size && alt_trace_grow(t) < 0)
+    return -1;
+  t->data[t->used++] = byte;
+  return 0;
+}
+
+static int alt_trace_uleb(struct alt_trace *t, alt_u64 x)
+{
+  while (x >= 0x80) {
+    if (alt_trace_byte(t, (alt_u8) (x | 0x80)) < 0)
+      return -1;
+    x >>= 7;
+  }
+  return alt_trace_byte(t, (alt_u8) x);
+}
+
+static int alt_trace_read_uleb(struct alt_trace *t, alt_u64 *x)
+{
+  int shift;
+
+  *x = 0;
+  for (shift = 0; t->pos < t->used && shift < 64; shift += 7) {
+    *x |= (alt_u64) (t->data[t->pos] & 0x7F) << shift;
+    if (!(t->data[t->pos++] & 0x80))
+      return 0;
+  }
+  return -1;
+}
+
+int alt_trace_put(struct alt_trace *t, alt_u32 time, int pio, alt_u32 value)
+{
+  size_t used = t->used;
+
+  if (alt_trace_uleb(t, ((alt_u64) (time - t->time) << 1) | (pio & 1)) < 0 ||
+      alt_trace_uleb(t, value ^ t->value[pio & 1]) < 0) {
+    t->used = used;
+    return -1;
+  }
+  t->time           = time;
+  t->value[pio & 1] = value;
+  return 0;
+}
+
+int alt_trace_get(struct alt_trace *t, alt_u32 *time, int *pio, alt_u32 *value)
+{
+  alt_u64 dt, x;
+
+  if (t->pos >= t->used || alt_trace_read_uleb(t, &dt) < 0 || alt_trace_read_uleb(t, &x) < 0)
+    return -1;
+  *pio   = (int) (dt & 1);
+  *time  = t->time += (alt_u32) (dt >> 1);
+  *value = t->value[*pio] ^= (alt_u32) x;
+  return 0;
+}
+
+void alt_trace_rewind(struct alt_trace *t)
+{
+  t->pos      = 0;
+  t->time     = 0;
+  t->value[0] = 0;
+  t->value[1] = 0;
+}
+
+void alt_trace_free(struct alt_trace *t)
+{
+  free(t->data);
+  memset(t, 0, sizeof(*t));
+}
+
+void alt_trace_header(alt_u8 header[ALT_TRACE_HEADER])
+{
+  alt_u32 tps = ALT_SYS_CLK_TICKS_PER_SEC;
+  int     i;
+
+  memcpy(header, alt_trace_magic, sizeof(alt_trace_magic));
+  for (i = 0; i < 4; i++)
+    header[4 + i] = (alt_u8) (tps >> (8 * i));
+}
+
+int alt_trace_load(struct alt_trace *t, const char *path)
+{
+  alt_u8 header[ALT_TRACE_HEADER], expect[ALT_TRACE_HEADER];
+  FILE  *f = fopen(path, "rb");
+  size_t n;
+
+  memset(t, 0, sizeof(*t));
+  if (f == NULL) {
+    perror(path);
+    return -1;
+  }
+  alt_trace_header(expect);
+  if (fread(header, 1, sizeof(header), f) != sizeof(header) ||
+      memcmp(header, expect, sizeof(header)) != 0) {
+    fprintf(stderr, "%s: not an input trace of this clock\n", path);
+    fclose(f);
+    return -1;
+  }
+  for (;;) {
+    if (t->used == t->size && alt_trace_grow(t) < 0) {
+      fprintf(stderr, "%s: out of memory\n", path);
+      break;
+    }
+    n = fread(t->data + t->used, 1, t->size - t->used, f);
+    if (n == 0)
+      break;
+    t->used += n;
+  }
+  if (ferror(f) || !feof(f)) {
+    fclose(f);
+    alt_trace_free(t);
+    return -1;
+  }
+  fclose(f);
+  return 0;
+}
+
+int alt_trace_save(const struct alt_trace *t, const char *path)
+{
+  alt_u8 header[ALT_TRACE_HEADER];
+  FILE  *f = fopen(path, "wb");
+  int    err;
+
+  if (f == NULL) {
+    perror(path);
+    return -1;
+  }
+  alt_trace_header(header);
+  err = fwrite(header, 1, sizeof(header), f) != sizeof(header) ||
+        fwrite(t->data, 1, t->used, f) != t->used;
+  if (fclose(f) != 0 || err) {
+    perror(path);
+    return -1;
+  }
+  return 0;
+}
@@ -0,0 +1,140 @@
+/* Frames between a cruise controller and the vehicle server, see hil.h */
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "hil.h"
+
+/* Fills in the address of 'where'; returns its length, 0 if not valid */
+static socklen_t hil_address(const char *where, struct sockaddr_storage *addr)
+{
+  struct sockaddr_un *un  = (struct sockaddr_un *) addr;
+  struct sockaddr_in *in  = (struct sockaddr_in *) addr;
+  char               *end;
+  long                port;
+
+  memset(addr, 0, sizeof(*addr));
+  if (where[0] == ':') {
+    port = strtol(where + 1, &end, 10);
+    if (end == where + 1 || *end != '\0' || port <= 0 || port > 65535)
+      return 0;
+    in->sin_family      = AF_INET;
+    in->sin_port        = htons((uint16_t) port);
+    in->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    return sizeof(*in);
+  }
+  if (strlen(where) >= sizeof(un->sun_path))
+    return 0;
+  un->sun_family = AF_UNIX;
+  strcpy(un->sun_path, where);
+  return sizeof(*un);
+}
+
+/* Small frames go out at once instead of waiting for more (Nagle) */
+static void hil_nodelay(int fd, const struct sockaddr_storage *addr)
+{
+  int one = 1;
+
+  if (addr->ss_family == AF_INET)
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+int hil_listen(const char *where)
+{
+  struct sockaddr_storage addr;
+  socklen_t               len = hil_address(where, &addr);
+  int                     fd, one = 1;
+
+  if (len == 0) {
+    fprintf(stderr, "%s: not a socket path or :port\n", where);
+    return -1;
+  }
+  if ((fd = socket(addr.ss_family, SOCK_STREAM, 0)) < 0) {
+    perror("socket");
+    return -1;
+  }
+  if (addr.ss_family == AF_UNIX)
+    unlink(where);
+  else
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  if (bind(fd, (struct sockaddr *) &addr, len) < 0 || listen(fd, 16) < 0) {
+    fprintf(stderr, "%s: %s\n", where, strerror(errno));
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+int hil_connect(const char *where)
+{
+  struct sockaddr_storage addr;
+  socklen_t               len = hil_address(where, &addr);
+  int                     fd;
+
+  if (len == 0) {
+    fprintf(stderr, "%s: not a socket path or :port\n", where);
+    return -1;
+  }
+  if ((fd = socket(addr.ss_family, SOCK_STREAM, 0)) < 0) {
+    perror("socket");
+    return -1;
+  }
+  if (connect(fd, (struct sockaddr *) &addr, len) < 0) {
+    fprintf(stderr, "%s: %s\n", where, strerror(errno));
+    close(fd);
+    return -1;
+  }
+  hil_nodelay(fd, &addr);
+  return fd;
+}
+
+int hil_accept(int fd)
+{
+  struct sockaddr_storage addr;
+  socklen_t               len = sizeof(addr);
+  int                     client;
+
+  if ((client = accept(fd, (struct sockaddr *) &addr, &len)) >= 0)
+    hil_nodelay(client, &addr);
+  return client;
+}
+
+int hil_read(int fd, void *buf, size_t size)
+{
+  char   *p = buf;
+  ssize_t n;
+
+  while (size > 0) {
+    n = read(fd, p, size);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return -1;
+    p    += n;
+    size -= (size_t) n;
+  }
+  return 0;
+}
+
+int hil_write(int fd, const void *buf, size_t size)
+{
+  const char *p = buf;
+  ssize_t     n;
+
+  while (size > 0) {
+    n = write(fd, p, size);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n < 0)
+      return -1;
+    p    += n;
+    size -= (size_t) n;
+  }
+  return 0;
+}
@@ -0,0 +1,83 @@
+/* Frames between a cruise controller and the vehicle server
+ *
+ * Description:
+ *
+ *   vehicle-server hosts the physics of VehicleTask (vehicle_step() of
+ *   model/vehicle.c) in a process of its own, the way the plant would be
+ *   a separate piece of hardware, and vehicle-client runs the ControlTask
+ *   logic against it. They talk over a Unix socket or loopback TCP in
+ *   frames of a header and 'count' fixed-size items, in host byte order
+ *   since both ends run on the same machine:
+ *
+ *     HIL_RESET  client -> server, 1 hil_reset: start a new vehicle
+ *     HIL_STEP   client -> server, count hil_input: one per period
+ *     HIL_STATE  server -> client, count hil_state: after every period
+ *
+ *   A step frame batches up to HIL_BATCH_MAX periods, which the server
+ *   simulates one after the other with the inputs given for each; the
+ *   reply to it carries the state after every one of them, the sequence
+ *   number of the request and the time the server spent on it, so that
+ *   the client can tell the transport from the simulation in the round
+ *   trip. A reset is answered with a HIL_STATE of one item.
+ */
+#ifndef HIL_H
+#define HIL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define HIL_MAGIC     0x4C48         /* "HL" */
+#define HIL_BATCH_MAX 64
+#define HIL_SOCKET    "/tmp/cruise-vehicle.sock"
+
+enum hil_type {
+  HIL_RESET = 1,
+  HIL_STEP,
+  HIL_STATE
+};
+
+struct hil_header {
+  uint16_t magic;
+  uint8_t  type;                     /* enum hil_type */
+  uint8_t  count;                    /* items that follow */
+  uint32_t seq;                      /* echoed in the reply */
+  uint32_t server_ns;                /* replies: time spent in the server */
+};
+
+struct hil_reset {
+  uint32_t position;                 /* m */
+  int16_t  velocity;                 /* m/s */
+  uint16_t pad;
+};
+
+struct hil_input {
+  uint8_t throttle;
+  uint8_t brake;                     /* enum active */
+  uint8_t engine;                    /* enum active */
+  uint8_t pad;
+};
+
+struct hil_state {
+  uint32_t position;                 /* m */
+  int16_t  velocity;                 /* m/s */
+  uint16_t pad;
+};
+
+/* Largest frame: a header and HIL_BATCH_MAX items of either kind */
+#define HIL_FRAME_MAX (sizeof(struct hil_header) + HIL_BATCH_MAX * sizeof(struct hil_state))
+
+/*
+ * 'where' is a path for a Unix socket, or :PORT for TCP on the loopback
+ * interface. Both return a socket, or -1 after printing why not.
+ */
+int hil_listen(const char *where);
+int hil_connect(const char *where);
+
+/* The next client of a listening socket, or -1 */
+int hil_accept(int fd);
+
+/* Whole buffers over a stream socket; return 0, or -1 on error or end of stream */
+int hil_read(int fd, void *buf, size_t size);
+int hil_write(int fd, const void *buf, size_t size);
+
+#endif /* HIL_H */
@@ -0,0 +1,201 @@
+/* Cruise controller against the vehicle server
+ *
+ * Description:
+ *
+ *   Runs the ControlTask logic (control_step() of model/control.c) against
+ *   a vehicle hosted by vehicle-server, as it would run against the plant
+ *   on the board: the controller only sees the velocity and position the
+ *   server sends back. The driver starts the engine in top gear, holds
+ *   the gas until -v m/s and presses the cruise button; the rest of the -n
+ *   periods are cruising.
+ *
+ *   For every batch size of -k the run is repeated with that many periods
+ *   per frame: the controller computes its outputs once per frame and the
+ *   server applies them for each period of the batch, so a batch of k is
+ *   a controller running k times slower with 1/k of the round trips. The
+ *   report gives per batch size the round-trip time of a frame (median and
+ *   99th percentile), the part of it the server spent simulating, the
+ *   rest being the transport, the frames per second the transport allows
+ *   (the highest control rate) and the mean velocity error while cruising
+ *   (the price of the slower controller).
+ *
+ *   usage: vehicle-client [-k batch,...] [-n periods] [-v velocity] [-t track]
+ *                         [socket|:port]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "control.h"
+#include "hil.h"
+#include "track_file.h"
+#include "bench.h"
+
+#define CLIENT_BATCHES 16
+
+struct client_run {
+  uint64_t frames;
+  uint64_t server_ns;
+  uint64_t cruising;                 /* periods */
+  uint64_t error;                    /* sum of |target - velocity| while cruising */
+  double   seconds;
+  uint32_t *rtt;                     /* ns, per frame */
+};
+
+static int client_cmp(const void *a, const void *b)
+{
+  uint32_t x = *(const uint32_t *) a, y = *(const uint32_t *) b;
+
+  return (x > y) - (x < y);
+}
+
+/* Sends a frame and reads the reply into 'state'; returns 0 or -1 */
+static int client_exchange(int fd, int type, uint32_t seq, const void *items, size_t size,
+                           int count, struct hil_header *reply, struct hil_state *state)
+{
+  unsigned char      frame[HIL_FRAME_MAX] __attribute__((aligned(8)));
+  struct hil_header *h = (struct hil_header *) frame;
+
+  h->magic     = HIL_MAGIC;
+  h->type      = (uint8_t) type;
+  h->count     = (uint8_t) count;
+  h->seq       = seq;
+  h->server_ns = 0;
+  memcpy(h + 1, items, size);
+  if (hil_write(fd, frame, sizeof(*h) + size) < 0 || hil_read(fd, reply, sizeof(*reply)) < 0 ||
+      reply->magic != HIL_MAGIC || reply->type != HIL_STATE || reply->seq != seq ||
+      reply->count != (type == HIL_RESET ? 1 : count) ||
+      hil_read(fd, state, reply->count * sizeof(*state)) < 0)
+    return -1;
+  return 0;
+}
+
+static int client_drive(int fd, int batch, INT32U periods, INT16S cruise, struct client_run *run)
+{
+  static const struct hil_reset start = {0, 0, 0};
+  struct control_state   ctrl;
+  struct control_inputs  in = {0, 0, ENGINE_FLAG | TOP_GEAR_FLAG};
+  struct control_outputs out;
+  struct hil_header      reply;
+  struct hil_state       state[HIL_BATCH_MAX];
+  struct hil_input       input[HIL_BATCH_MAX];
+  uint8_t                engine = off;
+  INT32U                 done;
+  double                 t0, t1, begin;
+  int                    k, n, pressed = 0;
+
+  memset(run, 0, sizeof(*run));
+  run->rtt = malloc((periods / batch + 1) * sizeof(*run->rtt));
+  if (run->rtt == NULL || client_exchange(fd, HIL_RESET, 0, &start, sizeof(start), 1, &reply,
+                                          state) < 0)
+    return -1;
+  control_init(&ctrl);
+  ctrl.track = track_default;
+  in.velocity = state[0].velocity;
+
+  begin = bench_now();
+  for (done = 0; done < periods; done += n) {
+    /* the driver: gas up to the cruise velocity, then the cruise button once */
+    in.buttons = 0;
+    if (!pressed && in.velocity < cruise)
+      in.buttons = GAS_PEDAL_FLAG;
+    else if (!pressed++)
+      in.buttons = CRUISE_CONTROL_FLAG;
+
+    control_step(&ctrl, &in, &out);
+    if (out.engine != 0)
+      engine = out.engine;
+    n = periods - done < (INT32U) batch ? (int) (periods - done) : batch;
+    for (k = 0; k < n; k++) {
+      input[k].throttle = out.throttle;
+      input[k].brake    = out.brake;
+      input[k].engine   = engine;
+      input[k].pad      = 0;
+    }
+
+    t0 = bench_now();
+    if (client_exchange(fd, HIL_STEP, (uint32_t) run->frames + 1, input, n * sizeof(input[0]), n,
+                        &reply, state) < 0)
+      return -1;
+    t1 = bench_now();
+    run->rtt[run->frames++] = (uint32_t) ((t1 - t0) * 1e9);
+    run->server_ns += reply.server_ns;
+
+    for (k = 0; k < n; k++) {
+      if (ctrl.cruise_control != on)
+        continue;
+      run->cruising++;
+      run->error += abs(ctrl.target_velocity - state[k].velocity);
+    }
+    /* what the plant measured replaces the dead reckoning */
+    in.velocity   = state[n - 1].velocity;
+    ctrl.position = state[n - 1].position;
+  }
+  run->seconds = bench_now() - begin;
+  return 0;
+}
+
+int main(int argc, char **argv)
+{
+  struct client_run run;
+  struct track     *track = NULL;
+  const char       *where = HIL_SOCKET, *list = "1,2,4,8,16,32,64";
+  INT32U            periods = 100000;
+  INT16S            cruise = 40;
+  char             *end;
+  int               batch[CLIENT_BATCHES], batches = 0, opt, fd, i;
+
+  while ((opt = getopt(argc, argv, "k:n:v:t:")) != -1) {
+    switch (opt) {
+    case 'k': list = optarg; break;
+    case 'n': periods = strtoul(optarg, NULL, 0); break;
+    case 'v': cruise = (INT16S) atoi(optarg); break;
+    case 't':
+      if ((track = track_load(optarg)) == NULL)
+        return 1;
+      track_default = track;
+      break;
+    default:
+      goto usage;
+    }
+  }
+  if (optind < argc)
+    where = argv[optind++];
+  if (optind != argc || periods == 0)
+    goto usage;
+  for (end = (char *) list; batches < CLIENT_BATCHES && *end != '\0'; batches++) {
+    batch[batches] = (int) strtol(end, &end, 10);
+    if (batch[batches] < 1 || batch[batches] > HIL_BATCH_MAX || (*end != ',' && *end != '\0'))
+      goto usage;
+    end += *end == ',';
+  }
+  if ((fd = hil_connect(where)) < 0)
+    return 1;
+
+  printf("batch   frames  rtt_p50_us  rtt_p99_us  server_us  transport_us  control_hz  "
+         "periods_per_s  mean_error\n");
+  for (i = 0; i < batches; i++) {
+    if (client_drive(fd, batch[i], periods, cruise, &run) < 0) {
+      fprintf(stderr, "%s: %s: the server went away or answered nonsense\n", argv[0], where);
+      return 1;
+    }
+    qsort(run.rtt, run.frames, sizeof(*run.rtt), client_cmp);
+    printf("%5d  %7llu  %10.1f  %10.1f  %9.2f  %12.1f  %10.0f  %13.0f  %10.3f\n", batch[i],
+           (unsigned long long) run.frames, run.rtt[run.frames / 2] / 1e3,
+           run.rtt[run.frames * 99 / 100] / 1e3, run.server_ns / 1e3 / run.frames,
+           (run.seconds * 1e9 / run.frames - run.server_ns / (double) run.frames) / 1e3,
+           run.frames / run.seconds, periods / run.seconds,
+           run.cruising ? (double) run.error / run.cruising : 0.0);
+    free(run.rtt);
+  }
+  printf("(the board runs ControlTask at %.1f Hz)\n", 1000.0 / CONTROL_STEP_MS);
+  close(fd);
+  track_free(track);
+  return 0;
+
+usage:
+  fprintf(stderr, "usage: %s [-k batch,...] [-n periods] [-v velocity] [-t track] "
+          "[socket|:port]\n", argv[0]);
+  return 2;
+}
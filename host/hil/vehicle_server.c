@@ -0,0 +1,230 @@
+/* Vehicle server of the cruise control lab
+ *
+ * Description:
+ *
+ *   Hosts the VehicleTask physics (vehicle_step() of model/vehicle.c) for
+ *   controllers in other processes, standing in for the plant on the
+ *   board: every connection is a vehicle of its own, stepped period by
+ *   period with the inputs the frames of hil.h bring. The connections are
+ *   served from one poll() loop on non-blocking sockets, so a slow client
+ *   holds up no other: the replies it does not read wait in its output
+ *   buffer, and once that is full the server stops reading its frames
+ *   until it catches up.
+ *
+ *   The server listens on a Unix socket (HIL_SOCKET by default) or, for
+ *   :PORT, on TCP port PORT of the loopback interface. -n ends it after
+ *   that many sessions, for scripts.
+ *
+ *   usage: vehicle-server [-n sessions] [-t track] [socket|:port]
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "vehicle.h"
+#include "hil.h"
+#include "track_file.h"
+#include "bench.h"
+
+#define SERVER_CLIENTS 64
+
+/* Replies not written to a client yet, bytes */
+#define SERVER_OUT     (4 * HIL_FRAME_MAX)
+
+struct server_client {
+  int                  fd;
+  struct vehicle_state car;
+  unsigned char        buf[HIL_FRAME_MAX] __attribute__((aligned(8)));
+  size_t               have;          /* bytes of the frame read so far */
+  unsigned char        out[SERVER_OUT];
+  size_t               queued;        /* bytes of out[] to write */
+  uint64_t             frames;
+  uint64_t             periods;
+};
+
+static size_t server_item(int type)
+{
+  return type == HIL_RESET ? sizeof(struct hil_reset) : sizeof(struct hil_input);
+}
+
+/* Room for the largest reply in the output buffer */
+static int server_room(const struct server_client *c)
+{
+  return SERVER_OUT - c->queued >= HIL_FRAME_MAX;
+}
+
+/* Handles the complete frame at the start of c->buf and queues the reply */
+static void server_frame(struct server_client *c, const struct hil_header *h)
+{
+  unsigned char           reply[HIL_FRAME_MAX] __attribute__((aligned(8)));
+  struct hil_header      *r     = (struct hil_header *) reply;
+  struct hil_state       *state = (struct hil_state *) (r + 1);
+  const struct hil_input *in    = (const struct hil_input *) (h + 1);
+  const struct hil_reset *reset = (const struct hil_reset *) (h + 1);
+  struct vehicle_inputs   drive;
+  double                  t0 = bench_now();
+  int                     k;
+
+  r->magic = HIL_MAGIC;
+  r->type  = HIL_STATE;
+  r->count = h->type == HIL_RESET ? 1 : h->count;
+  r->seq   = h->seq;
+  if (h->type == HIL_RESET) {
+    vehicle_init(&c->car);
+    c->car.position = reset->position % c->car.track->length;
+    c->car.velocity = reset->velocity;
+    state[0].position = c->car.position;
+    state[0].velocity = c->car.velocity;
+    state[0].pad      = 0;
+  } else {
+    for (k = 0; k < h->count; k++) {
+      drive.throttle    = in[k].throttle;
+      drive.brake_pedal = in[k].brake == on ? on : off;
+      drive.engine      = in[k].engine == on ? on : off;
+      vehicle_step(&c->car, &drive);
+      state[k].position = c->car.position;
+      state[k].velocity = c->car.velocity;
+      state[k].pad      = 0;
+    }
+    c->periods += h->count;
+  }
+  r->server_ns = (uint32_t) ((bench_now() - t0) * 1e9);
+  c->frames++;
+  memcpy(c->out + c->queued, reply, sizeof(*r) + r->count * sizeof(*state));
+  c->queued += sizeof(*r) + r->count * sizeof(*state);
+}
+
+/* Writes what the socket takes of the replies; returns 0, -1 to drop the client */
+static int server_flush(struct server_client *c)
+{
+  ssize_t n;
+
+  while (c->queued > 0) {
+    n = write(c->fd, c->out, c->queued);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n < 0)
+      return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+    memmove(c->out, c->out + n, c->queued - (size_t) n);
+    c->queued -= (size_t) n;
+  }
+  return 0;
+}
+
+/* Answers the complete frames in c->buf while the replies fit, then sends them */
+static int server_serve(struct server_client *c)
+{
+  const struct hil_header *h = (const struct hil_header *) c->buf;
+  size_t need;
+
+  while (c->have >= sizeof(*h) && server_room(c)) {
+    if (h->magic != HIL_MAGIC || (h->type != HIL_RESET && h->type != HIL_STEP) ||
+        h->count > HIL_BATCH_MAX || (h->type == HIL_RESET && h->count != 1))
+      return -1;
+    need = sizeof(*h) + h->count * server_item(h->type);
+    if (c->have < need)
+      break;
+    server_frame(c, h);
+    memmove(c->buf, c->buf + need, c->have - need);
+    c->have -= need;
+  }
+  return server_flush(c);
+}
+
+/* Reads what the client sent and answers the frames it completes */
+static int server_read(struct server_client *c)
+{
+  ssize_t n;
+
+  n = read(c->fd, c->buf + c->have, sizeof(c->buf) - c->have);
+  if (n < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK))
+    return 0;
+  if (n <= 0)
+    return -1;
+  c->have += (size_t) n;
+  return server_serve(c);
+}
+
+int main(int argc, char **argv)
+{
+  static struct server_client client[SERVER_CLIENTS];
+  struct pollfd  pfd[SERVER_CLIENTS + 1];
+  struct track  *track = NULL;
+  const char    *where = HIL_SOCKET;
+  long           sessions = -1;
+  int            opt, listener, clients = 0, i, fd, err;
+
+  while ((opt = getopt(argc, argv, "n:t:")) != -1) {
+    switch (opt) {
+    case 'n': sessions = strtol(optarg, NULL, 0); break;
+    case 't':
+      if ((track = track_load(optarg)) == NULL)
+        return 1;
+      track_default = track;
+      break;
+    default:
+      goto usage;
+    }
+  }
+  if (optind < argc)
+    where = argv[optind++];
+  if (optind != argc)
+    goto usage;
+  signal(SIGPIPE, SIG_IGN);
+  if ((listener = hil_listen(where)) < 0)
+    return 1;
+  fprintf(stderr, "[server] vehicles on %s\n", where);
+
+  while (sessions != 0) {
+    pfd[0].fd     = listener;
+    pfd[0].events = clients < SERVER_CLIENTS ? POLLIN : 0;
+    /* a client whose replies fill its buffer is not read until it takes them */
+    for (i = 0; i < clients; i++) {
+      pfd[i + 1].fd     = client[i].fd;
+      pfd[i + 1].events = (server_room(&client[i]) ? POLLIN : 0) |
+                          (client[i].queued > 0 ? POLLOUT : 0);
+    }
+    if (poll(pfd, clients + 1, -1) < 0)
+      continue;
+    for (i = clients - 1; i >= 0; i--) {
+      err = 0;
+      if (pfd[i + 1].revents & (POLLOUT | POLLHUP | POLLERR))
+        err = server_flush(&client[i]) < 0 || server_serve(&client[i]) < 0;
+      if (!err && (pfd[i + 1].revents & (POLLIN | POLLHUP | POLLERR)) && server_room(&client[i]))
+        err = server_read(&client[i]) < 0;
+      if (!err)
+        continue;
+      fprintf(stderr, "[server] session ended: %llu frames, %llu periods\n",
+              (unsigned long long) client[i].frames, (unsigned long long) client[i].periods);
+      close(client[i].fd);
+      client[i] = client[--clients];
+      if (sessions > 0)
+        sessions--;
+    }
+    if ((pfd[0].revents & POLLIN) && (fd = hil_accept(listener)) >= 0) {
+      if (fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) < 0) {
+        perror("fcntl");
+        close(fd);
+        continue;
+      }
+      memset(&client[clients], 0, sizeof(client[clients]));
+      client[clients].fd = fd;
+      vehicle_init(&client[clients].car);
+      clients++;
+    }
+  }
+  close(listener);
+  if (where[0] != ':')
+    unlink(where);
+  track_free(track);
+  return 0;
+
+usage:
+  fprintf(stderr, "usage: %s [-n sessions] [-t track] [socket|:port]\n", argv[0]);
+  return 2;
+}
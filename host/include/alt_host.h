@@ -0,0 +1,76 @@
+/* Host-only extensions of the Altera HAL port
+ *
+ * Not part of the board BSP: used by the simulation port and the host
+ * tools to reset the system between runs and to skip idle ticks.
+ */
+#ifndef ALT_HOST_H
+#define ALT_HOST_H
+
+#include <stddef.h>
+
+#include "alt_types.h"
+
+/* Clears the PIO registers and alarms and re-initializes the kernel; the
+   keys and switches of a board file keep their value */
+void    alt_host_reset(void);
+
+/*
+ * Maps the PIO registers onto the file 'path' (MAP_SHARED), created with
+ * the current registers if it is new, so that every process mapping it
+ * shares them: the register accesses stay plain loads and stores. The
+ * file holds alt_host_pio[] as system.h lays it out. Returns -1 after
+ * printing why not.
+ */
+int     alt_host_board(const char *path);
+
+/* Ticks until the next alarm fires (0xFFFFFFFF if none is running) */
+alt_u32 alt_alarm_next(void);
+
+/* Advances the system clock by 'nticks' ticks in which nothing expires */
+void    alt_tick_skip(alt_u32 nticks);
+
+/*
+ * Input traces
+ *
+ * The values of the keys and the toggle switches, stored as the changes
+ * seen at the system clock ticks (alt_trace.c gives the encoding). While
+ * a trace is recorded every tick compares both registers with their last
+ * recorded value; a trace replayed into the registers changes them at the
+ * same ticks, so that every read of the program sees what it saw when it
+ * was recorded.
+ */
+
+#define ALT_TRACE_HEADER 8
+
+struct alt_trace {
+  alt_u8 *data;                      /* records, without the file header */
+  size_t  used;
+  size_t  size;
+  size_t  pos;                       /* read position */
+  alt_u32 time;                      /* ticks of the last record put or got */
+  alt_u32 value[2];                  /* last value of the keys and toggles */
+};
+
+/* Appends a record; -1 if out of memory */
+int     alt_trace_put(struct alt_trace *t, alt_u32 time, int pio, alt_u32 value);
+
+/* Reads the next record; -1 at the end */
+int     alt_trace_get(struct alt_trace *t, alt_u32 *time, int *pio, alt_u32 *value);
+void    alt_trace_rewind(struct alt_trace *t);
+void    alt_trace_free(struct alt_trace *t);
+
+void    alt_trace_header(alt_u8 header[ALT_TRACE_HEADER]);
+int     alt_trace_load(struct alt_trace *t, const char *path);
+int     alt_trace_save(const struct alt_trace *t, const char *path);
+
+/*
+ * Records the inputs from now on, writing every change to 'path' as it
+ * happens; NULL stops. Returns -1 if the file cannot be written.
+ */
+int     alt_host_record(const char *path);
+
+/* Replays a trace into the registers from now on and sets *end to the
+   tick of its last record; returns -1 if it cannot be read */
+int     alt_host_replay(const char *path, alt_u32 *end);
+
+#endif /* ALT_HOST_H */
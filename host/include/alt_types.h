@@ -0,0 +1,14 @@
+/* Altera HAL fixed width types for the POSIX host port */
+#ifndef ALT_TYPES_H
+#define ALT_TYPES_H
+
+typedef signed char        alt_8;
+typedef unsigned char      alt_u8;
+typedef signed short       alt_16;
+typedef unsigned short     alt_u16;
+typedef signed int         alt_32;
+typedef unsigned int       alt_u32;
+typedef long long          alt_64;
+typedef unsigned long long alt_u64;
+
+#endif /* ALT_TYPES_H */
@@ -0,0 +1,41 @@
+/* Avalon performance counter for the POSIX host port
+ *
+ * Sections are timed with CLOCK_MONOTONIC and reported in ALT_CPU_FREQ
+ * cycles, so 'perf_get_section_time() / alt_get_cpu_freq()' still gives
+ * seconds. As on the hardware, sections only count while the global
+ * counter runs (between PERF_START_MEASURING and PERF_STOP_MEASURING).
+ */
+#ifndef ALTERA_AVALON_PERFORMANCE_COUNTER_H
+#define ALTERA_AVALON_PERFORMANCE_COUNTER_H
+
+#include "alt_types.h"
+
+#define ALT_HOST_PERF_SECTIONS 8
+
+struct alt_host_perf {
+  alt_u64 start;                             /* ns, 0 while stopped */
+  alt_u64 stop;                              /* ns of the last stop  */
+  alt_u64 total;
+  alt_u64 begin[ALT_HOST_PERF_SECTIONS];
+  alt_u64 time[ALT_HOST_PERF_SECTIONS];
+  alt_u32 starts[ALT_HOST_PERF_SECTIONS];
+};
+
+void    alt_host_perf_reset(void *base);
+void    alt_host_perf_start(void *base);
+void    alt_host_perf_stop(void *base);
+void    alt_host_perf_begin(void *base, int section);
+void    alt_host_perf_end(void *base, int section);
+
+alt_u64 perf_get_total_time(void *hw_base_address);
+alt_u64 perf_get_section_time(void *hw_base_address, int which_section);
+alt_u32 perf_get_num_starts(void *hw_base_address, int which_section);
+alt_u32 alt_get_cpu_freq(void);
+
+#define PERF_RESET(p)             alt_host_perf_reset(p)
+#define PERF_START_MEASURING(p)   alt_host_perf_start(p)
+#define PERF_STOP_MEASURING(p)    alt_host_perf_stop(p)
+#define PERF_BEGIN(p, n)          alt_host_perf_begin((p), (n))
+#define PERF_END(p, n)            alt_host_perf_end((p), (n))
+
+#endif /* ALTERA_AVALON_PERFORMANCE_COUNTER_H */
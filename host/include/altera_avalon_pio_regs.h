@@ -0,0 +1,21 @@
+/* Register map of the Avalon PIO core for the POSIX host port */
+#ifndef ALTERA_AVALON_PIO_REGS_H
+#define ALTERA_AVALON_PIO_REGS_H
+
+#include "alt_types.h"
+
+#define IOADDR_ALTERA_AVALON_PIO_DATA(base)        ((volatile alt_u32 *) (base) + 0)
+#define IOADDR_ALTERA_AVALON_PIO_DIRECTION(base)   ((volatile alt_u32 *) (base) + 1)
+#define IOADDR_ALTERA_AVALON_PIO_IRQ_MASK(base)    ((volatile alt_u32 *) (base) + 2)
+#define IOADDR_ALTERA_AVALON_PIO_EDGE_CAP(base)    ((volatile alt_u32 *) (base) + 3)
+
+#define IORD_ALTERA_AVALON_PIO_DATA(base)          (*IOADDR_ALTERA_AVALON_PIO_DATA(base))
+#define IOWR_ALTERA_AVALON_PIO_DATA(base, data)    (*IOADDR_ALTERA_AVALON_PIO_DATA(base) = (alt_u32) (data))
+#define IORD_ALTERA_AVALON_PIO_DIRECTION(base)     (*IOADDR_ALTERA_AVALON_PIO_DIRECTION(base))
+#define IOWR_ALTERA_AVALON_PIO_DIRECTION(base, data) (*IOADDR_ALTERA_AVALON_PIO_DIRECTION(base) = (alt_u32) (data))
+#define IORD_ALTERA_AVALON_PIO_IRQ_MASK(base)      (*IOADDR_ALTERA_AVALON_PIO_IRQ_MASK(base))
+#define IOWR_ALTERA_AVALON_PIO_IRQ_MASK(base, data) (*IOADDR_ALTERA_AVALON_PIO_IRQ_MASK(base) = (alt_u32) (data))
+#define IORD_ALTERA_AVALON_PIO_EDGE_CAP(base)      (*IOADDR_ALTERA_AVALON_PIO_EDGE_CAP(base))
+#define IOWR_ALTERA_AVALON_PIO_EDGE_CAP(base, data) (*IOADDR_ALTERA_AVALON_PIO_EDGE_CAP(base) = (alt_u32) (data))
+
+#endif /* ALTERA_AVALON_PIO_REGS_H */
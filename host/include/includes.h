@@ -0,0 +1,11 @@
+/* Master include file of the POSIX host port of the il2206 BSP */
+#ifndef INCLUDES_H
+#define INCLUDES_H
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "ucos_ii.h"
+
+#endif /* INCLUDES_H */
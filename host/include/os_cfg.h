@@ -0,0 +1,20 @@
+/* uC/OS-II configuration of the POSIX host port
+ *
+ * The values mirror the il2206 uC/OS-II BSP used on the DE2 board so that
+ * the lab sources build unmodified.
+ */
+#ifndef OS_CFG_H
+#define OS_CFG_H
+
+#define OS_LOWEST_PRIO        63   /* Reserved for the (implicit) idle task     */
+#define OS_MAX_TASKS          32   /* Task control blocks available to the app  */
+#define OS_MAX_EVENTS         64   /* Semaphores + mailboxes                    */
+#define OS_TMR_CFG_MAX        16   /* Software timers                           */
+#define OS_TICKS_PER_SEC    1000   /* Rate of the system clock timer            */
+#define OS_TMR_CFG_NAME_SIZE  16
+
+#define OS_HOST_STK_SIZE  (256u * 1024u) /* Host stack of each task in bytes, the
+                                            board sized OS_STK arrays are too
+                                            small for glibc's printf            */
+
+#endif /* OS_CFG_H */
@@ -0,0 +1,37 @@
+/* uC/OS-II processor port for a POSIX host
+ *
+ * Description:
+ *
+ *   Data types and critical section primitives of the host port. On the DE2
+ *   board these come from the Nios II port of the BSP; here a critical section
+ *   is a process wide kernel lock that is owned by at most one task or by the
+ *   tick "interrupt" at a time (OS_CRITICAL_METHOD 3 semantics: the saved
+ *   status tells whether the lock was taken by this call).
+ */
+#ifndef OS_CPU_H
+#define OS_CPU_H
+
+typedef unsigned char      BOOLEAN;
+typedef unsigned char      INT8U;
+typedef signed   char      INT8S;
+typedef unsigned short     INT16U;
+typedef signed   short     INT16S;
+typedef unsigned int       INT32U;
+typedef signed   int       INT32S;
+typedef float              FP32;
+typedef double             FP64;
+
+typedef INT32U             OS_STK;     /* Each stack entry is 32-bit wide */
+typedef INT32U             OS_CPU_SR;  /* Saved "interrupt" status         */
+
+#define OS_CRITICAL_METHOD 3
+
+#define OS_ENTER_CRITICAL() { cpu_sr = OS_CPU_SR_Save(); }
+#define OS_EXIT_CRITICAL()  { OS_CPU_SR_Restore(cpu_sr); }
+
+#define OS_STK_GROWTH      1           /* Stack grows from HIGH to LOW memory */
+
+OS_CPU_SR OS_CPU_SR_Save(void);
+void      OS_CPU_SR_Restore(OS_CPU_SR cpu_sr);
+
+#endif /* OS_CPU_H */
@@ -0,0 +1,31 @@
+/* Altera HAL alarms for the POSIX host port
+ *
+ * An alarm calls its callback from the system clock "interrupt" once
+ * 'nticks' ticks have elapsed; the value the callback returns is the number
+ * of ticks to the next call, 0 stops the alarm.
+ */
+#ifndef ALT_ALARM_H
+#define ALT_ALARM_H
+
+#include "alt_types.h"
+
+typedef struct alt_alarm_s alt_alarm;
+
+struct alt_alarm_s {
+  alt_alarm *next;
+  alt_u32    time;       /* Value of alt_nticks() at which the alarm fires */
+  alt_u32  (*callback)(void *context);
+  void      *context;
+  alt_u8     running;
+};
+
+int     alt_alarm_start(alt_alarm *alarm, alt_u32 nticks,
+                        alt_u32 (*callback)(void *context), void *context);
+void    alt_alarm_stop(alt_alarm *alarm);
+alt_u32 alt_ticks_per_second(void);
+alt_u32 alt_nticks(void);
+
+/* System clock ISR: fires the due alarms and ticks the kernel */
+void    alt_tick(void);
+
+#endif /* ALT_ALARM_H */
@@ -0,0 +1,24 @@
+/* Altera HAL interrupt control for the POSIX host port
+ *
+ * The only interrupt on the host is the system clock, which takes the
+ * kernel lock; disabling interrupts therefore means holding that lock.
+ */
+#ifndef ALT_IRQ_H
+#define ALT_IRQ_H
+
+#include "alt_types.h"
+#include "os_cpu.h"
+
+typedef OS_CPU_SR alt_irq_context;
+
+static inline alt_irq_context alt_irq_disable_all(void)
+{
+  return OS_CPU_SR_Save();
+}
+
+static inline void alt_irq_enable_all(alt_irq_context context)
+{
+  OS_CPU_SR_Restore(context);
+}
+
+#endif /* ALT_IRQ_H */
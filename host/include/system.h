@@ -0,0 +1,48 @@
+/* System description of the DE2 Nios II system for the POSIX host port
+ *
+ * Description:
+ *
+ *   On the board nios2-bsp generates this file from the .sopcinfo and the
+ *   *_BASE symbols are bus addresses. On the host every PIO is a block of
+ *   four 32-bit registers (data, direction, interrupt mask, edge capture)
+ *   in alt_host_pio[], so the lab sources may keep dereferencing the bases
+ *   directly. The keys are active low and read as released (0xF) at reset.
+ *
+ *   alt_host_pio[] fills a page of its own, so that alt_host_board() can
+ *   map a file over it and other processes see and drive the registers
+ *   (word n*4 is the data register of PIO n).
+ */
+#ifndef SYSTEM_H
+#define SYSTEM_H
+
+#include "alt_types.h"
+
+#define ALT_CPU_FREQ              50000000u
+#define ALT_SYS_CLK_TICKS_PER_SEC 1000u
+
+#define ALT_HOST_PIO_KEYS          0
+#define ALT_HOST_PIO_TOGGLES       1
+#define ALT_HOST_PIO_GREENLED      2
+#define ALT_HOST_PIO_REDLED        3
+#define ALT_HOST_PIO_HEX_LOW       4
+#define ALT_HOST_PIO_HEX_HIGH      5
+#define ALT_HOST_PIO_COUNT         6
+
+#define ALT_HOST_PIO_PAGE         4096u   /* bytes of alt_host_pio[] */
+
+extern volatile alt_u32 alt_host_pio[ALT_HOST_PIO_PAGE / sizeof(alt_u32)];
+
+#define ALT_HOST_PIO_BASE(n)      ((void *) &alt_host_pio[(n) * 4])
+
+#define D2_PIO_KEYS4_BASE         ALT_HOST_PIO_BASE(ALT_HOST_PIO_KEYS)
+#define DE2_PIO_TOGGLES18_BASE    ALT_HOST_PIO_BASE(ALT_HOST_PIO_TOGGLES)
+#define DE2_PIO_GREENLED9_BASE    ALT_HOST_PIO_BASE(ALT_HOST_PIO_GREENLED)
+#define DE2_PIO_REDLED18_BASE     ALT_HOST_PIO_BASE(ALT_HOST_PIO_REDLED)
+#define DE2_PIO_HEX_LOW28_BASE    ALT_HOST_PIO_BASE(ALT_HOST_PIO_HEX_LOW)
+#define DE2_PIO_HEX_HIGH28_BASE   ALT_HOST_PIO_BASE(ALT_HOST_PIO_HEX_HIGH)
+
+extern struct alt_host_perf alt_host_perf;
+
+#define PERFORMANCE_COUNTER_BASE  ((void *) &alt_host_perf)
+
+#endif /* SYSTEM_H */
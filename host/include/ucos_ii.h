@@ -0,0 +1,227 @@
+/* uC/OS-II kernel services for the POSIX host port
+ *
+ * Description:
+ *
+ *   The subset of the uC/OS-II API that the IL2206 lab sources use
+ *   (tasks, semaphores, mailboxes, software timers and time management),
+ *   with the same names, error codes and blocking semantics as the kernel
+ *   in the il2206 BSP. The kernel core (os_core.c) is independent of how
+ *   tasks are executed; the port layer (os_port.h) provides the context
+ *   switch and the tick source.
+ */
+#ifndef UCOS_II_H
+#define UCOS_II_H
+
+#include <stdint.h>
+
+#include "os_cpu.h"
+#include "os_cfg.h"
+
+#define OS_VERSION            286u
+
+#ifndef FALSE
+#define FALSE                   0u
+#endif
+#ifndef TRUE
+#define TRUE                    1u
+#endif
+
+#define OS_PRIO_SELF         0xFFu  /* Indicate SELF priority                     */
+#define OS_TASK_IDLE_PRIO    (OS_LOWEST_PRIO)
+#define OS_N_PRIOS           (OS_LOWEST_PRIO + 1u)
+
+/* Task status (OSTCBStat) */
+#define OS_STAT_RDY          0x00u  /* Ready to run                              */
+#define OS_STAT_SEM          0x01u  /* Pending on semaphore                      */
+#define OS_STAT_MBOX         0x02u  /* Pending on mailbox                        */
+#define OS_STAT_SUSPEND      0x08u  /* Task is suspended                         */
+#define OS_STAT_PEND_ANY     (OS_STAT_SEM | OS_STAT_MBOX)
+
+/* Pend status (OSTCBStatPend) */
+#define OS_STAT_PEND_OK         0u  /* Pending status OK, not pending, or pending complete */
+#define OS_STAT_PEND_TO         1u  /* Pending timed out                         */
+
+/* Event types */
+#define OS_EVENT_TYPE_UNUSED    0u
+#define OS_EVENT_TYPE_MBOX      1u
+#define OS_EVENT_TYPE_SEM       3u
+
+/* Task options (see OSTaskCreateExt()) */
+#define OS_TASK_OPT_NONE     0x0000u
+#define OS_TASK_OPT_STK_CHK  0x0001u  /* Enable stack checking for the task      */
+#define OS_TASK_OPT_STK_CLR  0x0002u  /* Clear the stack when the task is created */
+#define OS_TASK_OPT_SAVE_FP  0x0004u  /* Save the contents of any floating-point registers */
+
+/* Timer options and states */
+#define OS_TMR_OPT_NONE         0u
+#define OS_TMR_OPT_ONE_SHOT     1u
+#define OS_TMR_OPT_PERIODIC     2u
+#define OS_TMR_OPT_CALLBACK     3u
+#define OS_TMR_OPT_CALLBACK_ARG 4u
+
+#define OS_TMR_STATE_UNUSED     0u
+#define OS_TMR_STATE_STOPPED    1u
+#define OS_TMR_STATE_COMPLETED  2u
+#define OS_TMR_STATE_RUNNING    3u
+
+#define OS_TMR_TYPE           100u
+
+/* Error codes */
+#define OS_ERR_NONE                  0u
+#define OS_ERR_EVENT_TYPE            1u
+#define OS_ERR_PEND_ISR              2u
+#define OS_ERR_POST_NULL_PTR         3u
+#define OS_ERR_PEVENT_NULL           4u
+#define OS_ERR_PDATA_NULL            9u
+#define OS_ERR_INVALID_OPT           7u
+#define OS_ERR_TIMEOUT              10u
+#define OS_ERR_MBOX_FULL            20u
+#define OS_ERR_TIME_INVALID_MINUTES 81u
+#define OS_ERR_TIME_INVALID_SECONDS 82u
+#define OS_ERR_TIME_INVALID_MS      83u
+#define OS_ERR_TIME_ZERO_DLY        84u
+#define OS_ERR_TASK_CREATE_ISR      60u
+#define OS_ERR_TASK_DEL_ISR         64u
+#define OS_ERR_TASK_NO_MORE_TCB     66u
+#define OS_ERR_TASK_NOT_EXIST       67u
+#define OS_ERR_TASK_OPT             69u
+#define OS_ERR_PRIO_EXIST           40u
+#define OS_ERR_PRIO                 41u
+#define OS_ERR_PRIO_INVALID         42u
+#define OS_ERR_SEM_OVF              50u
+#define OS_ERR_TMR_INVALID_DLY     130u
+#define OS_ERR_TMR_INVALID_PERIOD  131u
+#define OS_ERR_TMR_INVALID_OPT     132u
+#define OS_ERR_TMR_INVALID         138u
+#define OS_ERR_TMR_INACTIVE        140u
+#define OS_ERR_TMR_INVALID_STATE   141u
+#define OS_ERR_TMR_NON_AVAIL       143u
+
+/* Pre-2.84 aliases still used by the lab sources */
+#define OS_NO_ERR                  OS_ERR_NONE
+#define OS_TIMEOUT                 OS_ERR_TIMEOUT
+#define OS_MBOX_FULL               OS_ERR_MBOX_FULL
+#define OS_SEM_OVF                 OS_ERR_SEM_OVF
+#define OS_PRIO_EXIST              OS_ERR_PRIO_EXIST
+#define OS_PRIO_INVALID            OS_ERR_PRIO_INVALID
+#define OS_TASK_NOT_EXIST          OS_ERR_TASK_NOT_EXIST
+
+/*
+ * Event control block - semaphores and mailboxes
+ */
+typedef struct os_event {
+  INT8U     OSEventType;      /* OS_EVENT_TYPE_xxx                             */
+  void     *OSEventPtr;       /* Message of a mailbox, free list link otherwise */
+  INT16U    OSEventCnt;       /* Semaphore count                               */
+  uint64_t  OSEventWaitMask;  /* Bit p is set when the task at priority p waits */
+} OS_EVENT;
+
+/*
+ * Software timers
+ */
+typedef void (*OS_TMR_CALLBACK)(void *ptmr, void *parg);
+
+typedef struct os_tmr {
+  INT8U            OSTmrType;
+  OS_TMR_CALLBACK  OSTmrCallback;
+  void            *OSTmrCallbackArg;
+  struct os_tmr   *OSTmrNext;
+  INT32U           OSTmrMatch;   /* Fires when OSTmrTime reaches this value  */
+  INT32U           OSTmrDly;
+  INT32U           OSTmrPeriod;
+  INT8U           *OSTmrName;
+  INT8U            OSTmrOpt;
+  INT8U            OSTmrState;
+} OS_TMR;
+
+/*
+ * Stack checking
+ */
+typedef struct os_stk_data {
+  INT32U  OSFree;           /* Number of free bytes on the stack */
+  INT32U  OSUsed;           /* Number of bytes used on the stack */
+} OS_STK_DATA;
+
+/*
+ * Task control block
+ */
+struct os_port_tcb;
+
+typedef struct os_tcb {
+  void          (*OSTCBTask)(void *pdata);
+  void           *OSTCBTaskData;
+  INT8U           OSTCBPrio;
+  INT16U          OSTCBId;
+  INT16U          OSTCBOpt;
+  INT8U           OSTCBStat;       /* OS_STAT_xxx                              */
+  INT8U           OSTCBStatPend;   /* OS_STAT_PEND_xxx                         */
+  INT32U          OSTCBDly;        /* Ticks to delay task or timeout of a pend */
+  OS_EVENT       *OSTCBEventPtr;   /* Event the task is pending on             */
+  void           *OSTCBMsg;        /* Message received from OSMboxPost()       */
+  void           *OSTCBExtPtr;
+  INT8U          *OSTCBStkBase;    /* Lowest address of the host stack         */
+  INT32U          OSTCBStkSize;    /* Size of the host stack in bytes          */
+  INT32U          OSTCBCtxSwCtr;   /* Number of times the task was switched in */
+  struct os_port_tcb *OSTCBPort;   /* Port specific context                    */
+} OS_TCB;
+
+/*
+ * Global kernel state
+ */
+extern volatile INT32U OSTime;          /* Current value of the system tick counter */
+extern INT32U          OSTmrTime;       /* Number of OSTmrSignal() calls            */
+extern BOOLEAN         OSRunning;
+extern INT8U           OSIntNesting;
+extern INT8U           OSLockNesting;
+extern INT8U           OSPrioCur;
+extern INT8U           OSPrioHighRdy;
+extern uint64_t        OSRdyMask;       /* Bit p is set when priority p is ready    */
+extern INT32U          OSCtxSwCtr;
+extern INT8U           OSCPUUsage;
+extern OS_TCB         *OSTCBCur;        /* NULL while the CPU idles                 */
+extern OS_TCB         *OSTCBHighRdy;
+extern OS_TCB         *OSTCBPrioTbl[OS_N_PRIOS];
+
+/*
+ * Kernel services
+ */
+void      OSInit(void);
+void      OSStart(void);
+void      OSStatInit(void);
+void      OSIntEnter(void);
+void      OSIntExit(void);
+void      OSSchedLock(void);
+void      OSSchedUnlock(void);
+INT16U    OSVersion(void);
+
+INT8U     OSTaskCreate(void (*task)(void *p_arg), void *p_arg, OS_STK *ptos, INT8U prio);
+INT8U     OSTaskCreateExt(void (*task)(void *p_arg), void *p_arg, OS_STK *ptos, INT8U prio,
+                          INT16U id, OS_STK *pbos, INT32U stk_size, void *pext, INT16U opt);
+INT8U     OSTaskDel(INT8U prio);
+INT8U     OSTaskStkChk(INT8U prio, OS_STK_DATA *p_stk_data);
+
+OS_EVENT *OSSemCreate(INT16U cnt);
+void      OSSemPend(OS_EVENT *pevent, INT32U timeout, INT8U *perr);
+INT8U     OSSemPost(OS_EVENT *pevent);
+INT16U    OSSemAccept(OS_EVENT *pevent);
+
+OS_EVENT *OSMboxCreate(void *pmsg);
+void     *OSMboxPend(OS_EVENT *pevent, INT32U timeout, INT8U *perr);
+INT8U     OSMboxPost(OS_EVENT *pevent, void *pmsg);
+void     *OSMboxAccept(OS_EVENT *pevent);
+
+OS_TMR   *OSTmrCreate(INT32U dly, INT32U period, INT8U opt, OS_TMR_CALLBACK callback,
+                      void *callback_arg, INT8U *pname, INT8U *perr);
+BOOLEAN   OSTmrDel(OS_TMR *ptmr, INT8U *perr);
+BOOLEAN   OSTmrStart(OS_TMR *ptmr, INT8U *perr);
+BOOLEAN   OSTmrStop(OS_TMR *ptmr, INT8U opt, void *callback_arg, INT8U *perr);
+INT32U    OSTmrRemainGet(OS_TMR *ptmr, INT8U *perr);
+INT8U     OSTmrSignal(void);
+
+void      OSTimeDly(INT32U ticks);
+INT8U     OSTimeDlyHMSM(INT8U hours, INT8U minutes, INT8U seconds, INT16U ms);
+INT32U    OSTimeGet(void);
+void      OSTimeSet(INT32U ticks);
+void      OSTimeTick(void);
+
+#endif /* UCOS_II_H */
@@ -0,0 +1,408 @@
+/* Discrete-event schedule simulator of the cruise control task sets
+ *
+ * Description:
+ *
+ *   Predicts the response times of a task set under the fixed-priority
+ *   preemptive scheduling of uC/OS-II without running it. The task table
+ *   (the .tasks files in sched/) lists what StartTask creates, one task per line:
+ *
+ *     periodic   NAME PRIO PERIOD_MS WCET_US [DEADLINE_MS [OFFSET_MS]]
+ *     extra      NAME PRIO SLEEP_MS WCET_US
+ *     background NAME PRIO
+ *     watchdog   NAME PRIO TIMEOUT_MS
+ *
+ *   A periodic task is released by its software timer; a release that
+ *   finds the previous job unfinished is queued (the semaphore counts it).
+ *   'extra' is extra_task of src-merlijn: it spins until OSTimeGet() has
+ *   advanced by the work the switches SW4 to SW9 ask for (-s), preempted
+ *   or not, then sleeps SLEEP_MS. The spin is work * HYPER_PERIOD / 100 as
+ *   the lab intends; -l computes it as the lab code does, (work / 100) *
+ *   HYPER_PERIOD in integers, which spins 0 ms below 100 %. 'background' is a task that never waits
+ *   (helper_task), and 'watchdog' the task it keeps from timing out: every
+ *   TIMEOUT_MS the background task does not get the CPU is one overload
+ *   warning. A second task at a priority already taken is not created, as
+ *   OSTaskCreateExt() refuses it.
+ *
+ *   Time advances from event to event (releases, completions, the end of
+ *   a spin) in microseconds over -H hyperperiods of the periodic tasks;
+ *   -c charges every context switch. The report gives per task the jobs,
+ *   the worst and mean response times and the deadline misses; -T prints
+ *   the execution timeline of the first milliseconds.
+ *
+ *   usage: sched-sim [-l] [-H hyperperiods] [-s switches] [-c switch_us] [-T ms] table
+ */
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define SCHED_TASKS   64
+#define SCHED_NAME    32
+#define SCHED_LINE    256
+#define SCHED_NEVER   INT64_MAX
+
+/* extra_task of src-merlijn: the work is a share of HYPER_PERIOD */
+#define SCHED_HYPER_PERIOD_MS 300
+
+enum sched_kind {
+  SCHED_PERIODIC,
+  SCHED_EXTRA,
+  SCHED_BACKGROUND,
+  SCHED_WATCHDOG
+};
+
+struct sched_task {
+  char    name[SCHED_NAME];
+  int     kind;                      /* enum sched_kind */
+  int     prio;
+  int64_t period;                    /* us; sleep of extra, timeout of watchdog */
+  int64_t wcet;                      /* us */
+  int64_t deadline;                  /* us, relative */
+  int64_t offset;                    /* us, first release */
+
+  int64_t next;                      /* us, next release or wake-up */
+  int64_t release;                   /* us, release of the current job */
+  int64_t remaining;                 /* us of CPU the job still needs */
+  int64_t spin_end;                  /* extra: end of the spin, -1 before it starts */
+  int     ready;
+  int     backlog;                   /* releases queued behind the current job */
+
+  uint64_t jobs;
+  uint64_t misses;
+  int64_t  wcrt;
+  int64_t  response;                 /* sum */
+  int64_t  cpu;
+};
+
+struct sched {
+  struct sched_task task[SCHED_TASKS];
+  int      tasks;
+  int64_t  hyper;                    /* us */
+  int64_t  cost;                     /* us per context switch */
+  int      switches;                 /* SW0..SW17 */
+  int64_t  timeline;                 /* us of timeline to print */
+
+  struct sched_task *background;
+  struct sched_task *watchdog;
+  int64_t  starved;                  /* us, start of the current wait of the background */
+  int64_t  longest;                  /* us, longest such wait */
+  uint64_t warnings;
+  uint64_t ctx_switches;
+};
+
+static int64_t sched_gcd(int64_t a, int64_t b)
+{
+  while (b != 0) {
+    int64_t t = a % b;
+
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+static int sched_number(const char *s, int64_t *value)
+{
+  char *end;
+
+  if (s == NULL)
+    return -1;
+  errno  = 0;
+  *value = strtoll(s, &end, 0);
+  return end == s || *end != '\0' || errno != 0 || *value < 0 ? -1 : 0;
+}
+
+static int sched_load(struct sched *s, const char *path)
+{
+  FILE              *f = fopen(path, "r");
+  char               line[SCHED_LINE], *w[8], *save, *hash;
+  struct sched_task *t;
+  unsigned           lineno = 0;
+  int64_t            v[6];
+  int                n, i, k;
+
+  if (f == NULL) {
+    fprintf(stderr, "%s: %s\n", path, strerror(errno));
+    return -1;
+  }
+  while (fgets(line, sizeof(line), f) != NULL) {
+    lineno++;
+    if ((hash = strchr(line, '#')) != NULL)
+      *hash = '\0';
+    for (n = 0; n < 8 && (w[n] = strtok_r(n ? NULL : line, " \t\r\n", &save)) != NULL; n++)
+      ;
+    if (n == 0)
+      continue;
+    for (k = 2; k < n; k++)
+      if (sched_number(w[k], &v[k - 2]) < 0)
+        goto bad;
+    if (n < 3 || strlen(w[1]) >= SCHED_NAME || v[0] > 63)
+      goto bad;
+    for (i = 0; i < s->tasks; i++)
+      if (s->task[i].prio == v[0])
+        break;
+    if (i < s->tasks) {
+      fprintf(stderr, "%s:%u: priority %d is taken by %s, %s is not created\n", path, lineno,
+              (int) v[0], s->task[i].name, w[1]);
+      continue;
+    }
+    if (s->tasks == SCHED_TASKS) {
+      fprintf(stderr, "%s:%u: more than %d tasks\n", path, lineno, SCHED_TASKS);
+      fclose(f);
+      return -1;
+    }
+    t = memset(&s->task[s->tasks], 0, sizeof(*t));
+    strcpy(t->name, w[1]);
+    t->prio = (int) v[0];
+    if (strcmp(w[0], "periodic") == 0 && n >= 5 && n <= 7) {
+      t->kind     = SCHED_PERIODIC;
+      t->period   = v[1] * 1000;
+      t->wcet     = v[2];
+      t->deadline = n > 5 ? v[3] * 1000 : t->period;
+      t->offset   = n > 6 ? v[4] * 1000 : 0;
+      if (t->period == 0)
+        goto bad;
+    } else if (strcmp(w[0], "extra") == 0 && n == 5) {
+      t->kind   = SCHED_EXTRA;
+      t->period = v[1] * 1000;
+      t->wcet   = v[2];
+    } else if (strcmp(w[0], "background") == 0 && n == 3) {
+      t->kind = SCHED_BACKGROUND;
+    } else if (strcmp(w[0], "watchdog") == 0 && n == 4) {
+      t->kind   = SCHED_WATCHDOG;
+      t->period = v[1] * 1000;
+      if (t->period == 0)
+        goto bad;
+    } else {
+      goto bad;
+    }
+    if ((t->kind == SCHED_BACKGROUND && s->background) ||
+        (t->kind == SCHED_WATCHDOG && s->watchdog)) {
+      fprintf(stderr, "%s:%u: only one %s task\n", path, lineno, w[0]);
+      fclose(f);
+      return -1;
+    }
+    s->tasks++;
+    if (t->kind == SCHED_BACKGROUND)
+      s->background = t;
+    if (t->kind == SCHED_WATCHDOG)
+      s->watchdog = t;
+  }
+  fclose(f);
+
+  s->hyper = 0;
+  for (i = 0; i < s->tasks; i++)
+    if (s->task[i].kind == SCHED_PERIODIC)
+      s->hyper = s->hyper ? s->hyper / sched_gcd(s->hyper, s->task[i].period) * s->task[i].period
+                          : s->task[i].period;
+  if (s->hyper == 0) {
+    fprintf(stderr, "%s: no periodic task\n", path);
+    return -1;
+  }
+  return 0;
+
+bad:
+  fprintf(stderr, "%s:%u: expected 'periodic NAME PRIO PERIOD_MS WCET_US [DEADLINE_MS "
+          "[OFFSET_MS]]', 'extra NAME PRIO SLEEP_MS WCET_US', 'background NAME PRIO' or "
+          "'watchdog NAME PRIO TIMEOUT_MS'\n", path, lineno);
+  fclose(f);
+  return -1;
+}
+
+/* The spin of extra_task: its percentage of HYPER_PERIOD, with the integer
+ * truncation of the lab code when 'lab' is set */
+static int64_t sched_extra_spin(int switches, int lab, int *percent)
+{
+  int work = (switches >> 4) & 0x3F;
+
+  work     = work > 50 ? 100 : work * 2;
+  *percent = work;
+  if (lab)
+    return (int64_t) (work / 100) * SCHED_HYPER_PERIOD_MS * 1000;
+  return (int64_t) work * SCHED_HYPER_PERIOD_MS * 1000 / 100;
+}
+
+static void sched_start(struct sched_task *t, int64_t now)
+{
+  t->ready     = 1;
+  t->release   = now;
+  t->remaining = t->wcet;
+  t->spin_end  = -1;
+}
+
+static void sched_finish(struct sched *s, struct sched_task *t, int64_t now)
+{
+  int64_t r = now - t->release;
+
+  t->jobs++;
+  t->response += r;
+  if (r > t->wcrt)
+    t->wcrt = r;
+  if (t->kind == SCHED_PERIODIC && r > t->deadline)
+    t->misses++;
+  t->ready = 0;
+  if (t->kind == SCHED_EXTRA) {
+    t->next = now + t->period;
+  } else if (t->backlog > 0) {
+    t->backlog--;
+    sched_start(t, t->release + t->period);
+  }
+}
+
+/* The background task gets the CPU again after waiting since s->starved */
+static void sched_fed(struct sched *s, int64_t now)
+{
+  int64_t wait = now - s->starved;
+
+  if (wait > s->longest)
+    s->longest = wait;
+  if (s->watchdog != NULL)
+    s->warnings += (uint64_t) (wait / s->watchdog->period);
+}
+
+static void sched_run(struct sched *s, int64_t end, int64_t spin)
+{
+  struct sched_task *t, *run, *last = NULL;
+  int64_t now = 0, next, stop, dt, seg_start = 0;
+  int     i;
+
+  for (i = 0; i < s->tasks; i++) {
+    t = &s->task[i];
+    t->next  = t->kind == SCHED_PERIODIC || t->kind == SCHED_EXTRA ? t->offset : SCHED_NEVER;
+    t->ready = t->kind == SCHED_BACKGROUND;
+  }
+  s->starved = 0;
+
+  while (now < end) {
+    /* releases and wake-ups due now */
+    next = end;
+    for (i = 0; i < s->tasks; i++) {
+      t = &s->task[i];
+      while (t->next <= now) {
+        if (t->kind == SCHED_EXTRA) {
+          sched_start(t, t->next);
+          t->next = SCHED_NEVER;
+        } else if (t->ready) {
+          t->backlog++;
+          t->next += t->period;
+        } else {
+          sched_start(t, t->next);
+          t->next += t->period;
+        }
+      }
+      if (t->next < next)
+        next = t->next;
+    }
+
+    /* highest priority ready task */
+    run = NULL;
+    for (i = 0; i < s->tasks; i++) {
+      t = &s->task[i];
+      if (t->ready && t->kind != SCHED_WATCHDOG && (run == NULL || t->prio < run->prio))
+        run = t;
+    }
+    if (run != last) {
+      if (last != NULL && last->kind == SCHED_BACKGROUND)
+        s->starved = now;
+      if (run != NULL && run->kind == SCHED_BACKGROUND)
+        sched_fed(s, now);
+      if (s->timeline > seg_start && last != NULL && now > seg_start)
+        printf("timeline %10.3f %10.3f  %s\n", seg_start / 1000.0, now / 1000.0, last->name);
+      seg_start = now;
+      if (run != NULL) {
+        s->ctx_switches++;
+        if (run->kind == SCHED_PERIODIC || (run->kind == SCHED_EXTRA && run->spin_end < 0))
+          run->remaining += s->cost;
+      }
+      last = run;
+    }
+    if (run == NULL) {
+      now = next;
+      continue;
+    }
+
+    /* run it up to the next event */
+    if (run->kind == SCHED_EXTRA && run->spin_end < 0)
+      run->spin_end = now + spin;
+    stop = next;
+    if (run->kind == SCHED_PERIODIC ||
+        (run->kind == SCHED_EXTRA && now >= run->spin_end))
+      stop = now + run->remaining < stop ? now + run->remaining : stop;
+    else if (run->kind == SCHED_EXTRA)
+      stop = run->spin_end < stop ? run->spin_end : stop;
+    dt = stop - now;
+    run->cpu += dt;
+    now = stop;
+    if (run->kind == SCHED_PERIODIC ||
+        (run->kind == SCHED_EXTRA && now - dt >= run->spin_end)) {
+      run->remaining -= dt;
+      if (run->remaining == 0)
+        sched_finish(s, run, now);
+    }
+  }
+  if (s->timeline > seg_start && last != NULL)
+    printf("timeline %10.3f %10.3f  %s\n", seg_start / 1000.0, end / 1000.0, last->name);
+  if (last == NULL || last->kind != SCHED_BACKGROUND)
+    sched_fed(s, end);
+}
+
+int main(int argc, char **argv)
+{
+  static struct sched s;
+  struct sched_task  *t;
+  int64_t hyperperiods = 1000, spin, busy = 0;
+  int     opt, i, percent, lab = 0;
+
+  while ((opt = getopt(argc, argv, "lH:s:c:T:")) != -1) {
+    switch (opt) {
+    case 'l': lab = 1; break;
+    case 'H': hyperperiods = strtoll(optarg, NULL, 0); break;
+    case 's': s.switches = (int) strtol(optarg, NULL, 0); break;
+    case 'c': s.cost = strtoll(optarg, NULL, 0); break;
+    case 'T': s.timeline = strtoll(optarg, NULL, 0) * 1000; break;
+    default:
+      goto usage;
+    }
+  }
+  if (optind + 1 != argc || hyperperiods < 1)
+    goto usage;
+  if (sched_load(&s, argv[optind]) < 0)
+    return 1;
+
+  spin = sched_extra_spin(s.switches, lab, &percent);
+  sched_run(&s, hyperperiods * s.hyper, spin);
+
+  printf("task              prio  period_ms  wcet_us       jobs  wcrt_ms  mean_ms  misses  cpu_%%\n");
+  for (i = 0; i < s.tasks; i++) {
+    t = &s.task[i];
+    if (t->kind == SCHED_WATCHDOG)
+      continue;
+    busy += t->kind == SCHED_BACKGROUND ? 0 : t->cpu;
+    printf("%-16s  %4d  %9.0f  %7lld  %9llu  %7.3f  %7.3f  %6llu  %5.1f\n", t->name, t->prio,
+           t->period / 1000.0, (long long) t->wcet, (unsigned long long) t->jobs,
+           t->wcrt / 1000.0, t->jobs ? (double) t->response / t->jobs / 1000.0 : 0.0,
+           (unsigned long long) t->misses, 100.0 * t->cpu / (hyperperiods * s.hyper));
+  }
+  printf("hyperperiod %.0f ms x %lld, %llu context switches, %.1f %% busy without the "
+         "background task\n", s.hyper / 1000.0, (long long) hyperperiods,
+         (unsigned long long) s.ctx_switches, 100.0 * busy / (hyperperiods * s.hyper));
+  for (i = 0; i < s.tasks; i++)
+    if (s.task[i].kind == SCHED_EXTRA)
+      printf("extra work: switches 0x%x, SW4-SW9 ask for %d %%, %s spins %lld ms\n",
+             s.switches, percent, s.task[i].name, (long long) (spin / 1000));
+  if (s.background != NULL)
+    printf("%s waits up to %.3f ms for the CPU", s.background->name, s.longest / 1000.0);
+  if (s.background != NULL && s.watchdog != NULL)
+    printf(", %s warns %llu times (timeout %.0f ms)", s.watchdog->name,
+           (unsigned long long) s.warnings, s.watchdog->period / 1000.0);
+  if (s.background != NULL)
+    printf("\n");
+  return 0;
+
+usage:
+  fprintf(stderr, "usage: %s [-l] [-H hyperperiods] [-s switches] [-c switch_us] [-T ms] table\n",
+          argv[0]);
+  return 2;
+}
@@ -0,0 +1,180 @@
+/* Keys, switches and displays of a running program
+ *
+ * Description:
+ *
+ *   Opens the board file of a program started with UCOS_HOST_BOARD=file
+ *   (alt_host_board() in hal/alt_hal.c) and maps it, so that the keys and
+ *   switches it sets are what the tasks read at their next IORD and the
+ *   LEDs and displays it prints are what they last wrote: no copy, no
+ *   message, no system call on either side.
+ *
+ *   -p and -r press and release a key, -s and -o turn a switch on and off
+ *   (by name, as in the scenario files, or keyN / swN), -k and -t set all
+ *   keys (active low) or switches at once; the options are applied in
+ *   their order. Then the registers are printed, or with -w polled every
+ *   that many ms and printed whenever the outputs change, -n times.
+ *
+ *   usage: board-io [-p key] [-r key] [-s switch] [-o switch] [-k keys] [-t switches]
+ *                   [-w ms [-n changes]] board
+ */
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "system.h"
+#include "control.h"
+#include "scenario.h"
+
+struct board_name {
+  const char *name;
+  alt_u32     mask;
+};
+
+static const struct board_name board_keys[] = {
+  {"gas", GAS_PEDAL_FLAG}, {"brake", BRAKE_PEDAL_FLAG}, {"cruise", CRUISE_CONTROL_FLAG},
+  {"increase", INCREASE_CRUISE_CONTROL_FLAG}, {NULL, 0}
+};
+
+static const struct board_name board_switches[] = {
+  {"engine", ENGINE_FLAG}, {"top_gear", TOP_GEAR_FLAG}, {NULL, 0}
+};
+
+/* The bit of a name of 'table' or of prefixN; 0 if neither */
+static alt_u32 board_bit(const char *s, const struct board_name *table, const char *prefix,
+                         int n)
+{
+  char *end;
+  long  i;
+
+  for (; table->name != NULL; table++)
+    if (strcmp(s, table->name) == 0)
+      return table->mask;
+  if (strncmp(s, prefix, strlen(prefix)) != 0)
+    return 0;
+  i = strtol(s + strlen(prefix), &end, 10);
+  return end != s + strlen(prefix) && *end == '\0' && i >= 0 && i < n ? 1u << i : 0;
+}
+
+static void board_print(volatile const alt_u32 *pio, double t)
+{
+  alt_u32 hex = pio[ALT_HOST_PIO_HEX_LOW * 4];
+  INT32S  v;
+
+  if (t >= 0)
+    printf("%9.3f  ", t);
+  printf("keys 0x%X  switches 0x%05X  green 0x%03X  red 0x%05X  ",
+         pio[ALT_HOST_PIO_KEYS * 4], pio[ALT_HOST_PIO_TOGGLES * 4],
+         pio[ALT_HOST_PIO_GREENLED * 4], pio[ALT_HOST_PIO_REDLED * 4]);
+  if (scenario_velocity(hex, &v) == 0)
+    printf("velocity %d\n", (int) v);
+  else
+    printf("hex 0x%07X\n", hex);
+  fflush(stdout);
+}
+
+static double board_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv)
+{
+  volatile alt_u32 *pio;
+  struct stat       st;
+  const char       *path;
+  struct timespec   poll;
+  alt_u32           bit, last[3];
+  long              watch = -1, changes = -1;
+  double            start;
+  void             *map;
+  int               opt, fd;
+
+  /* the options change the registers in their order, once the file is mapped */
+  while ((opt = getopt(argc, argv, "p:r:s:o:k:t:w:n:")) != -1) {
+    if (opt == '?')
+      goto usage;
+    if (opt == 'w')
+      watch = strtol(optarg, NULL, 0);
+    if (opt == 'n')
+      changes = strtol(optarg, NULL, 0);
+  }
+  if (optind != argc - 1 || (watch < 0 && changes >= 0))
+    goto usage;
+  path = argv[optind];
+  if ((fd = open(path, O_RDWR)) < 0 || fstat(fd, &st) < 0) {
+    perror(path);
+    return 1;
+  }
+  if (st.st_size < (off_t) ALT_HOST_PIO_PAGE) {
+    fprintf(stderr, "%s: not a board file\n", path);
+    return 1;
+  }
+  map = mmap(NULL, ALT_HOST_PIO_PAGE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    perror(path);
+    return 1;
+  }
+  pio = map;
+
+  optind = 1;
+  while ((opt = getopt(argc, argv, "p:r:s:o:k:t:w:n:")) != -1) {
+    switch (opt) {
+    case 'p':
+    case 'r':
+      if ((bit = board_bit(optarg, board_keys, "key", 4)) == 0)
+        goto usage;
+      if (opt == 'p')
+        pio[ALT_HOST_PIO_KEYS * 4] &= ~bit;
+      else
+        pio[ALT_HOST_PIO_KEYS * 4] |= bit;
+      break;
+    case 's':
+    case 'o':
+      if ((bit = board_bit(optarg, board_switches, "sw", 18)) == 0)
+        goto usage;
+      if (opt == 's')
+        pio[ALT_HOST_PIO_TOGGLES * 4] |= bit;
+      else
+        pio[ALT_HOST_PIO_TOGGLES * 4] &= ~bit;
+      break;
+    case 'k': pio[ALT_HOST_PIO_KEYS * 4] = strtoul(optarg, NULL, 0) & 0xF; break;
+    case 't': pio[ALT_HOST_PIO_TOGGLES * 4] = strtoul(optarg, NULL, 0) & 0x3FFFF; break;
+    }
+  }
+
+  if (watch < 0) {
+    board_print(pio, -1);
+    return 0;
+  }
+  poll.tv_sec  = watch / 1000;
+  poll.tv_nsec = watch % 1000 * 1000000L;
+  start = board_now();
+  memset(last, 0xFF, sizeof(last));
+  while (changes != 0) {
+    if (pio[ALT_HOST_PIO_GREENLED * 4] != last[0] || pio[ALT_HOST_PIO_REDLED * 4] != last[1] ||
+        pio[ALT_HOST_PIO_HEX_LOW * 4] != last[2]) {
+      last[0] = pio[ALT_HOST_PIO_GREENLED * 4];
+      last[1] = pio[ALT_HOST_PIO_REDLED * 4];
+      last[2] = pio[ALT_HOST_PIO_HEX_LOW * 4];
+      board_print(pio, board_now() - start);
+      if (changes > 0)
+        changes--;
+    }
+    nanosleep(&poll, NULL);
+  }
+  return 0;
+
+usage:
+  fprintf(stderr, "usage: %s [-p key] [-r key] [-s switch] [-o switch] [-k keys] [-t switches]\n"
+          "       %*s [-w ms [-n changes]] board\n", argv[0], (int) strlen(argv[0]), "");
+  return 2;
+}
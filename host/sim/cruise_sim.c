@@ -0,0 +1,246 @@
+/* Faster-than-real-time driver for the cruise control lab
+ *
+ * Description:
+ *
+ *   Links one of the cruise.c programs (its main() renamed app_main()) with
+ *   the simulation port and runs it for a number of control periods of
+ *   virtual time. The board inputs are set once before the start; a trace
+ *   hash of the LED and seven-segment registers, sampled every control
+ *   period, makes it easy to check that runs are bit-identical.
+ *
+ *   Busy tasks (the helper task of src-merlijn) are charged one tick every
+ *   -c scheduling points, see os_port_sim.c; once the helper is the only
+ *   task ready the time jumps to the next event, so cruise-merlijn-sim
+ *   runs close to the speed of cruise-sim.
+ *
+ *   -t loads the track the vehicle drives on from a file (sim/track_file.h)
+ *   instead of the lab track.
+ *
+ *   With -b the run stops after that many periods and takes a checkpoint
+ *   (OSSimCheckpoint()); every -x keys:switches then starts a branch from
+ *   it with these board inputs, run to the end on -j worker processes.
+ *   The shared prefix is simulated once, and the trace of a branch is the
+ *   one a full run would give with the inputs changed at that period.
+ *
+ *   -r replays an input trace (alt_host.h) into the keys and switches,
+ *   by default for as many periods as it lasts; -R records one.
+ *
+ *   usage: cruise-sim [-p periods] [-s switches] [-k keys] [-c calls] [-t track]
+ *                     [-r trace] [-R trace] [-b periods -x keys:switches ... [-j workers]]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "system.h"
+#include "includes.h"
+#include "altera_avalon_pio_regs.h"
+#include "sys/alt_alarm.h"
+#include "alt_host.h"
+#include "os_sim.h"
+#include "track_file.h"
+
+#define SIM_CONTROL_PERIOD 300   /* ms, CONTROL_PERIOD of cruise.c */
+
+#define SIM_BRANCHES       256
+
+struct sim_branch {
+  unsigned long keys;
+  unsigned long switches;
+  alt_u64       hash;            /* trace at the end, written by the worker */
+};
+
+int app_main(void);
+
+static alt_alarm sim_probe;
+static alt_u64   sim_hash = 0xcbf29ce484222325ull;   /* FNV-1a */
+
+static void sim_hash_word(alt_u32 word)
+{
+  int i;
+
+  for (i = 0; i < 4; i++) {
+    sim_hash ^= (word >> (8 * i)) & 0xFF;
+    sim_hash *= 0x100000001b3ull;
+  }
+}
+
+static alt_u32 sim_probe_cb(void *context)
+{
+  sim_hash_word(IORD_ALTERA_AVALON_PIO_DATA(DE2_PIO_GREENLED9_BASE));
+  sim_hash_word(IORD_ALTERA_AVALON_PIO_DATA(DE2_PIO_REDLED18_BASE));
+  sim_hash_word(IORD_ALTERA_AVALON_PIO_DATA(DE2_PIO_HEX_LOW28_BASE));
+  sim_hash_word(IORD_ALTERA_AVALON_PIO_DATA(DE2_PIO_HEX_HIGH28_BASE));
+  return SIM_CONTROL_PERIOD * alt_ticks_per_second() / 1000;
+}
+
+static double sim_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static INT32U sim_ticks(unsigned long periods)
+{
+  return (INT32U) (periods * SIM_CONTROL_PERIOD * OS_TICKS_PER_SEC / 1000);
+}
+
+static void sim_branches(const void *ckpt, size_t size, struct sim_branch *branch, int n,
+                         int first, int step, unsigned long periods)
+{
+  int b;
+
+  for (b = first; b < n; b += step) {
+    if (OSSimRestore(ckpt, size) != OS_ERR_NONE) {
+      fprintf(stderr, "[sim] cannot restore the checkpoint\n");
+      exit(1);
+    }
+    IOWR_ALTERA_AVALON_PIO_DATA(DE2_PIO_TOGGLES18_BASE, branch[b].switches);
+    IOWR_ALTERA_AVALON_PIO_DATA(D2_PIO_KEYS4_BASE, branch[b].keys);
+    OSSimRun(sim_ticks(periods));
+    branch[b].hash = sim_hash;
+  }
+}
+
+/* Runs the branches from the checkpoint, on 'workers' forked processes */
+static int sim_fork(unsigned long at, unsigned long periods, struct sim_branch *branch, int n,
+                    int workers)
+{
+  size_t size = OSSimCheckpoint(NULL, 0);
+  void  *ckpt = malloc(size);
+  double t0, t1;
+  pid_t  pid;
+  int    w, status, failed = 0;
+
+  if (ckpt == NULL) {
+    fprintf(stderr, "[sim] out of memory\n");
+    return 1;
+  }
+  OSSimCheckpoint(ckpt, size);
+  fprintf(stderr, "[sim] checkpoint at period %lu: %zu bytes\n", at, size);
+
+  fflush(stdout);
+  t0 = sim_now();
+  if (workers <= 1) {
+    sim_branches(ckpt, size, branch, n, 0, 1, periods);
+  } else {
+    for (w = 0; w < workers; w++) {
+      if ((pid = fork()) == 0) {
+        sim_branches(ckpt, size, branch, n, w, workers, periods);
+        fflush(stdout);
+        _exit(0);
+      }
+      if (pid < 0) {
+        perror("fork");
+        failed = 1;
+        break;
+      }
+    }
+    while (wait(&status) > 0)
+      failed |= !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+  }
+  t1 = sim_now();
+  free(ckpt);
+
+  fflush(stdout);
+  for (w = 0; w < n; w++)
+    printf("branch %d keys 0x%lx switches 0x%lx trace %016llx\n", w, branch[w].keys,
+           branch[w].switches, branch[w].hash);
+  fprintf(stderr, "[sim] %d branches of %lu periods on %d workers: %.3f s wall\n", n,
+          periods - at, workers, t1 - t0);
+  return failed;
+}
+
+int main(int argc, char **argv)
+{
+  unsigned long periods  = 0;       /* default 10^6 or the length of the trace */
+  unsigned long switches = 0;
+  unsigned long keys     = 0xF;
+  unsigned long at = 0;
+  const char   *replay = NULL, *record = NULL;
+  alt_u32       end;
+  struct track *track = NULL;
+  struct sim_branch *branch;
+  double        t0, t1;
+  int           opt, branches = 0, workers = 1;
+
+  /* Shared with the worker processes, which write the traces */
+  branch = mmap(NULL, SIM_BRANCHES * sizeof(*branch), PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (branch == MAP_FAILED) {
+    perror("mmap");
+    return 1;
+  }
+  while ((opt = getopt(argc, argv, "p:s:k:c:t:r:R:b:x:j:")) != -1) {
+    switch (opt) {
+    case 'p': periods  = strtoul(optarg, NULL, 0); break;
+    case 's': switches = strtoul(optarg, NULL, 0); break;
+    case 'k': keys     = strtoul(optarg, NULL, 0); break;
+    case 'c': OSSimSetCallsPerTick((INT32U) strtoul(optarg, NULL, 0)); break;
+    case 't':
+      track_free(track);
+      if ((track = track_load(optarg)) == NULL)
+        return 1;
+      track_default = track;
+      break;
+    case 'r': replay = optarg; break;
+    case 'R': record = optarg; break;
+    case 'b': at = strtoul(optarg, NULL, 0); break;
+    case 'x':
+      if (branches == SIM_BRANCHES ||
+          sscanf(optarg, "%li:%li", (long *) &branch[branches].keys,
+                 (long *) &branch[branches].switches) != 2)
+        goto usage;
+      branches++;
+      break;
+    case 'j': workers = atoi(optarg); break;
+    default:
+      goto usage;
+    }
+  }
+
+  alt_host_reset();
+  IOWR_ALTERA_AVALON_PIO_DATA(DE2_PIO_TOGGLES18_BASE, switches);
+  IOWR_ALTERA_AVALON_PIO_DATA(D2_PIO_KEYS4_BASE, keys);
+  if (replay != NULL) {
+    if (alt_host_replay(replay, &end) < 0)
+      return 1;
+    if (periods == 0)
+      periods = end * 1000ul / OS_TICKS_PER_SEC / SIM_CONTROL_PERIOD + 1;
+  }
+  if (record != NULL && alt_host_record(record) < 0)
+    return 1;
+  if (periods == 0)
+    periods = 1000000;
+  if ((at != 0) != (branches != 0) || at >= periods)
+    goto usage;
+  alt_alarm_start(&sim_probe, SIM_CONTROL_PERIOD * alt_ticks_per_second() / 1000,
+                  sim_probe_cb, NULL);
+  OSSimStopAt(sim_ticks(branches ? at : periods));
+
+  t0 = sim_now();
+  app_main();
+  t1 = sim_now();
+  if (branches) {
+    fprintf(stderr, "[sim] prefix of %lu periods: %.3f s wall\n", at, t1 - t0);
+    return sim_fork(at, periods, branch, branches, workers);
+  }
+
+  fflush(stdout);
+  fprintf(stderr, "[sim] %lu control periods, %u ticks, %u context switches\n",
+          periods, OSTime, OSCtxSwCtr);
+  fprintf(stderr, "[sim] %.3f s wall, %.0f periods/s, trace %016llx\n",
+          t1 - t0, periods / (t1 - t0), sim_hash);
+  return 0;
+
+usage:
+  fprintf(stderr, "usage: %s [-p periods] [-s switches] [-k keys] [-c calls] [-t track]\n"
+          "       [-r trace] [-R trace] [-b periods -x keys:switches ... [-j workers]]\n",
+          argv[0]);
+  return 2;
+}
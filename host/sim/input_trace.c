@@ -0,0 +1,135 @@
+/* Input trace tool
+ *
+ * Description:
+ *
+ *   Prints the changes of an input trace (alt_host.h) with their time, or
+ *   with -g writes a random drive of that many hours: the engine started,
+ *   then every 5 to 60 s the driver presses the gas pedal or the brake
+ *   for a while, taps the cruise control button or changes gear. The
+ *   drives serve to replay long runs in the simulator (cruise-sim -r).
+ *
+ *   usage: input-trace [-q] trace
+ *          input-trace -g hours [-S seed] -o trace
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "system.h"
+#include "alt_host.h"
+
+/* Bits of the keys (active low) and switches, as in the lab programs */
+#define TRACE_GAS      0x08
+#define TRACE_BRAKE    0x04
+#define TRACE_CRUISE   0x02
+#define TRACE_TOP_GEAR 0x02
+#define TRACE_ENGINE   0x01
+
+static unsigned long long trace_seed = 1;
+
+static alt_u32 trace_rand(alt_u32 lo, alt_u32 hi)
+{
+  trace_seed = trace_seed * 6364136223846793005ull + 1442695040888963407ull;
+  return lo + (alt_u32) ((trace_seed >> 33) % (hi - lo + 1));
+}
+
+/* ms -> ticks */
+static alt_u32 trace_ticks(alt_u32 ms)
+{
+  return (alt_u32) ((alt_u64) ms * ALT_SYS_CLK_TICKS_PER_SEC / 1000);
+}
+
+static int trace_generate(struct alt_trace *t, double hours)
+{
+  alt_u32 end = trace_ticks((alt_u32) (hours * 3600000));
+  alt_u32 now = 0, keys = 0xF, switches = TRACE_ENGINE, hold;
+  int     err;
+
+  err  = alt_trace_put(t, now, 0, keys);
+  err |= alt_trace_put(t, now, 1, switches);
+  while (!err) {
+    now += trace_ticks(trace_rand(5000, 60000));
+    if (now >= end)
+      break;
+    switch (trace_rand(0, 9)) {
+    case 0: case 1: case 2: case 3:
+      hold = trace_ticks(trace_rand(1000, 20000));
+      err |= alt_trace_put(t, now, 0, keys & ~TRACE_GAS);
+      err |= alt_trace_put(t, now + hold, 0, keys);
+      now += hold;
+      break;
+    case 4: case 5:
+      hold = trace_ticks(trace_rand(500, 3000));
+      err |= alt_trace_put(t, now, 0, keys & ~TRACE_BRAKE);
+      err |= alt_trace_put(t, now + hold, 0, keys);
+      now += hold;
+      break;
+    case 6: case 7:
+      hold = trace_ticks(trace_rand(100, 400));
+      err |= alt_trace_put(t, now, 0, keys & ~TRACE_CRUISE);
+      err |= alt_trace_put(t, now + hold, 0, keys);
+      now += hold;
+      break;
+    default:
+      switches ^= TRACE_TOP_GEAR;
+      err |= alt_trace_put(t, now, 1, switches);
+      break;
+    }
+  }
+  return err ? -1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+  struct alt_trace t = {0};
+  const char      *out = NULL;
+  double           hours = 0;
+  alt_u32          time, value, records = 0;
+  int              opt, pio, quiet = 0;
+
+  while ((opt = getopt(argc, argv, "g:S:o:q")) != -1) {
+    switch (opt) {
+    case 'g': hours      = atof(optarg); break;
+    case 'S': trace_seed = strtoull(optarg, NULL, 0); break;
+    case 'o': out        = optarg; break;
+    case 'q': quiet      = 1; break;
+    default:
+      goto usage;
+    }
+  }
+
+  if (hours > 0) {
+    if (out == NULL || optind != argc)
+      goto usage;
+    if (trace_generate(&t, hours) < 0) {
+      fprintf(stderr, "%s: out of memory\n", argv[0]);
+      return 1;
+    }
+    if (alt_trace_save(&t, out) < 0)
+      return 1;
+  } else {
+    if (optind + 1 != argc)
+      goto usage;
+    if (alt_trace_load(&t, argv[optind]) < 0)
+      return 1;
+  }
+
+  alt_trace_rewind(&t);
+  time = 0;
+  while (alt_trace_get(&t, &time, &pio, &value) == 0) {
+    records++;
+    if (!quiet && hours == 0)
+      printf("%12.3f s  %-8s 0x%x\n", (double) time / ALT_SYS_CLK_TICKS_PER_SEC,
+             pio ? "switches" : "keys", value);
+  }
+  fprintf(stderr, "[trace] %u changes over %.1f s, %zu bytes (%.2f per change)\n", records,
+          (double) time / ALT_SYS_CLK_TICKS_PER_SEC, t.used + ALT_TRACE_HEADER,
+          records ? (double) t.used / records : 0.0);
+  alt_trace_free(&t);
+  return 0;
+
+usage:
+  fprintf(stderr, "usage: %s [-q] trace\n       %s -g hours [-S seed] -o trace\n", argv[0],
+          argv[0]);
+  return 2;
+}
@@ -0,0 +1,413 @@
+/* Drive scenarios of the host simulator, see scenario.h */
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "scenario.h"
+#include "control.h"
+
+#define SCENARIO_LINE 256
+
+/* Seven-segment codes of b2sLUT in cruise.c, the last one is '-' */
+static const INT8U scenario_seven[] = {0x40, 0x79, 0x24, 0x30, 0x19, 0x12, 0x02, 0x78, 0x00,
+                                       0x18, 0x3F};
+
+static const char *const scenario_ops[] = {"<", "<=", ">", ">=", "==", "!="};
+
+struct scenario_parser {
+  struct scenario_set *set;
+  const char          *path;
+  unsigned             line;
+  size_t               cap_scenarios;
+  size_t               cap_events;
+  int                  fixed;        /* the scenario has a 'for' length */
+};
+
+static int scenario_error(struct scenario_parser *p, const char *msg, const char *token)
+{
+  fprintf(stderr, "%s:%u: %s%s%s\n", p->path, p->line, msg, token ? " " : "",
+          token ? token : "");
+  return -1;
+}
+
+static int scenario_grow(void **array, size_t *cap, size_t used, size_t elem)
+{
+  size_t n = *cap ? 2 * *cap : 64;
+  void  *a;
+
+  if (used < *cap)
+    return 0;
+  if ((a = realloc(*array, n * elem)) == NULL)
+    return -1;
+  *array = a;
+  *cap   = n;
+  return 0;
+}
+
+/* "250ms", "30s", "1.5s", "2min" */
+static int scenario_time(const char *s, INT32U *ms)
+{
+  char  *end;
+  double t = strtod(s, &end);
+
+  if (end == s || t < 0)
+    return -1;
+  if (strcmp(end, "ms") == 0)
+    ;
+  else if (strcmp(end, "s") == 0)
+    t *= 1000;
+  else if (strcmp(end, "min") == 0)
+    t *= 60000;
+  else
+    return -1;
+  if (t > 4e9)
+    return -1;
+  *ms = (INT32U) (t + 0.5);
+  return 0;
+}
+
+static int scenario_number(const char *s, long *value)
+{
+  char *end;
+
+  if (s == NULL)
+    return -1;
+  errno  = 0;
+  *value = strtol(s, &end, 0);
+  return end == s || *end != '\0' || errno != 0 ? -1 : 0;
+}
+
+/* 'prefix' followed by an index below 'n' (key2, sw17) as a bit mask */
+static int scenario_bit(const char *s, const char *prefix, int n, long *mask)
+{
+  long i;
+
+  if (s == NULL || strncmp(s, prefix, strlen(prefix)) != 0 ||
+      scenario_number(s + strlen(prefix), &i) < 0 || i < 0 || i >= n)
+    return -1;
+  *mask = 1L << i;
+  return 0;
+}
+
+static int scenario_key(const char *s, long *mask)
+{
+  if (s == NULL)
+    return -1;
+  if (strcmp(s, "gas") == 0)
+    *mask = GAS_PEDAL_FLAG;
+  else if (strcmp(s, "brake") == 0)
+    *mask = BRAKE_PEDAL_FLAG;
+  else if (strcmp(s, "cruise") == 0)
+    *mask = CRUISE_CONTROL_FLAG;
+  else if (strcmp(s, "increase") == 0)
+    *mask = INCREASE_CRUISE_CONTROL_FLAG;
+  else
+    return scenario_bit(s, "key", 4, mask);
+  return 0;
+}
+
+static int scenario_switch(const char *s, long *mask)
+{
+  if (s == NULL)
+    return -1;
+  if (strcmp(s, "engine") == 0)
+    *mask = ENGINE_FLAG;
+  else if (strcmp(s, "top_gear") == 0)
+    *mask = TOP_GEAR_FLAG;
+  else
+    return scenario_bit(s, "sw", 18, mask);
+  return 0;
+}
+
+static int scenario_parse_action(struct scenario_parser *p, const char *verb, char **save,
+                                 struct scenario_event *e)
+{
+  char *arg = strtok_r(NULL, " \t", save);
+  char *state;
+  long  mask;
+
+  if (verb == NULL)
+    return scenario_error(p, "missing action", NULL);
+  if (strcmp(verb, "press") == 0 || strcmp(verb, "release") == 0 || strcmp(verb, "tap") == 0) {
+    if (scenario_key(arg, &mask) < 0)
+      return scenario_error(p, "unknown key", arg);
+    e->action = verb[0] == 'p' ? SCENARIO_PRESS : verb[0] == 'r' ? SCENARIO_RELEASE : SCENARIO_TAP;
+  } else if (strcmp(verb, "switch") == 0) {
+    if (scenario_switch(arg, &mask) < 0)
+      return scenario_error(p, "unknown switch", arg);
+    state = strtok_r(NULL, " \t", save);
+    if (state != NULL && strcmp(state, "on") == 0)
+      e->action = SCENARIO_SWITCH_ON;
+    else if (state != NULL && strcmp(state, "off") == 0)
+      e->action = SCENARIO_SWITCH_OFF;
+    else
+      return scenario_error(p, "expected on or off after", arg);
+  } else {
+    return scenario_error(p, "unknown action", verb);
+  }
+  e->mask = (INT32U) mask;
+  return 0;
+}
+
+static int scenario_parse_cond(struct scenario_parser *p, char **save,
+                               struct scenario_event *e)
+{
+  char *what = strtok_r(NULL, " \t", save);
+  char *op   = strtok_r(NULL, " \t", save);
+  char *arg  = strtok_r(NULL, " \t", save);
+  long  value;
+  int   i;
+
+  if (what == NULL)
+    return scenario_error(p, "missing condition", NULL);
+  if (strcmp(what, "velocity") == 0) {
+    e->cond = SCENARIO_VELOCITY;
+    for (i = 0; i < SCENARIO_NE + 1; i++)
+      if (op != NULL && strcmp(op, scenario_ops[i]) == 0)
+        break;
+    if (i > SCENARIO_NE)
+      return scenario_error(p, "unknown comparison", op);
+    if (scenario_number(arg, &value) < 0 || value < -128 || value > 127)
+      return scenario_error(p, "expected a velocity instead of", arg);
+    e->test = (INT8U) i;
+  } else if (strcmp(what, "green") == 0 || strcmp(what, "red") == 0) {
+    e->cond = what[0] == 'g' ? SCENARIO_GREEN : SCENARIO_RED;
+    /* the mask comes first: green 0x1 on */
+    if (scenario_number(op, &value) < 0 || value <= 0 || value >= 1L << 18)
+      return scenario_error(p, "expected a LED mask instead of", op);
+    if (arg != NULL && strcmp(arg, "on") == 0)
+      e->test = SCENARIO_ON;
+    else if (arg != NULL && strcmp(arg, "off") == 0)
+      e->test = SCENARIO_OFF;
+    else
+      return scenario_error(p, "expected on or off after", op);
+  } else {
+    return scenario_error(p, "unknown condition", what);
+  }
+  e->value = (INT32S) value;
+  return 0;
+}
+
+static struct scenario_event *scenario_event_add(struct scenario_parser *p)
+{
+  struct scenario_set *set = p->set;
+
+  if (scenario_grow((void **) &set->event, &p->cap_events, set->events, sizeof(*set->event)) < 0)
+    return NULL;
+  set->scenario[set->scenarios - 1].events++;
+  return memset(&set->event[set->events++], 0, sizeof(*set->event));
+}
+
+static int scenario_parse_statement(struct scenario_parser *p, char *first, char **save)
+{
+  struct scenario       *s = &p->set->scenario[p->set->scenarios - 1];
+  struct scenario_event  e, *out;
+  char                  *range = strstr(first, "..");
+  char                  *verb;
+  INT32U                 end;
+
+  memset(&e, 0, sizeof(e));
+  e.line = (INT16U) p->line;
+  if (range != NULL)
+    *range = '\0';
+  if (scenario_time(first, &e.time) < 0)
+    return scenario_error(p, "expected a time instead of", first);
+  e.until = e.time;
+  if (range != NULL && (scenario_time(range + 2, &e.until) < 0 || e.until < e.time))
+    return scenario_error(p, "expected the end of the interval instead of", range + 2);
+
+  verb = strtok_r(NULL, " \t", save);
+  if (verb == NULL)
+    return scenario_error(p, "missing statement", NULL);
+  if (range != NULL && strcmp(verb, "expect") != 0)
+    return scenario_error(p, "only expect takes an interval:", verb);
+  if (strcmp(verb, "expect") == 0) {
+    if (scenario_parse_cond(p, save, &e) < 0)
+      return -1;
+  } else if (strcmp(verb, "when") == 0) {
+    if (scenario_parse_cond(p, save, &e) < 0 ||
+        scenario_parse_action(p, strtok_r(NULL, " \t", save), save, &e) < 0)
+      return -1;
+  } else if (scenario_parse_action(p, verb, save, &e) < 0) {
+    return -1;
+  }
+  if (strtok_r(NULL, " \t", save) != NULL)
+    return scenario_error(p, "trailing text", NULL);
+
+  if ((out = scenario_event_add(p)) == NULL)
+    return scenario_error(p, "out of memory", NULL);
+  *out = e;
+  end = e.until;
+  if (e.action == SCENARIO_TAP && e.cond == SCENARIO_ALWAYS) {
+    out->action = SCENARIO_PRESS;
+    e.action    = SCENARIO_RELEASE;
+    e.time = e.until = end = e.time + SCENARIO_TAP_MS;
+    if ((out = scenario_event_add(p)) == NULL)
+      return scenario_error(p, "out of memory", NULL);
+    *out = e;
+  }
+  if (e.action == SCENARIO_TAP)
+    end += SCENARIO_TAP_MS;
+  if (p->fixed && end > s->length)
+    return scenario_error(p, "statement past the end of the scenario", NULL);
+  if (!p->fixed && s->length < end + SCENARIO_TAIL_MS)
+    s->length = end + SCENARIO_TAIL_MS;
+  return 0;
+}
+
+static int scenario_parse_header(struct scenario_parser *p, char **save)
+{
+  struct scenario_set *set = p->set;
+  struct scenario     *s;
+  char                *name = strtok_r(NULL, " \t", save);
+  char                *word = strtok_r(NULL, " \t", save);
+  char                *len  = strtok_r(NULL, " \t", save);
+
+  if (name == NULL || strlen(name) >= SCENARIO_NAME)
+    return scenario_error(p, "expected a name of at most 47 characters after scenario", NULL);
+  if (scenario_grow((void **) &set->scenario, &p->cap_scenarios, set->scenarios,
+                    sizeof(*set->scenario)) < 0)
+    return scenario_error(p, "out of memory", NULL);
+  s = memset(&set->scenario[set->scenarios++], 0, sizeof(*s));
+  strcpy(s->name, name);
+  s->first  = (INT32U) set->events;
+  s->length = SCENARIO_TAIL_MS;
+  p->fixed  = word != NULL;
+  if (word == NULL)
+    return 0;
+  if (strcmp(word, "for") != 0 || len == NULL || scenario_time(len, &s->length) < 0 ||
+      strtok_r(NULL, " \t", save) != NULL)
+    return scenario_error(p, "expected 'for TIME' after the name instead of", word);
+  return 0;
+}
+
+/* Orders by time, then by line (a tap's release comes after its press) */
+static int scenario_cmp(const void *a, const void *b)
+{
+  const struct scenario_event *x = a, *y = b;
+
+  if (x->time != y->time)
+    return x->time < y->time ? -1 : 1;
+  return (x->line > y->line) - (x->line < y->line);
+}
+
+int scenario_load(struct scenario_set *set, const char *path)
+{
+  struct scenario_parser p = {set, path, 0, set->scenarios, set->events, 0};
+  FILE                  *f = fopen(path, "r");
+  char                   line[SCENARIO_LINE], *word, *save, *hash;
+  size_t                 first = set->scenarios, i;
+  int                    rc = 0;
+
+  if (f == NULL) {
+    fprintf(stderr, "%s: %s\n", path, strerror(errno));
+    return -1;
+  }
+  while (rc == 0 && fgets(line, sizeof(line), f) != NULL) {
+    p.line++;
+    if (strchr(line, '\n') == NULL && !feof(f)) {
+      rc = scenario_error(&p, "line too long", NULL);
+      break;
+    }
+    if ((hash = strchr(line, '#')) != NULL)
+      *hash = '\0';
+    line[strcspn(line, "\r\n")] = '\0';
+    if ((word = strtok_r(line, " \t", &save)) == NULL)
+      continue;
+    if (p.line > 0xFFFF)
+      rc = scenario_error(&p, "file too long", NULL);
+    else if (strcmp(word, "scenario") == 0)
+      rc = scenario_parse_header(&p, &save);
+    else if (set->scenarios == first)
+      rc = scenario_error(&p, "statement before the first scenario:", word);
+    else
+      rc = scenario_parse_statement(&p, word, &save);
+  }
+  fclose(f);
+  if (rc < 0)
+    return -1;
+
+  for (i = first; i < set->scenarios; i++)
+    qsort(&set->event[set->scenario[i].first], set->scenario[i].events, sizeof(*set->event),
+          scenario_cmp);
+  return 0;
+}
+
+void scenario_free(struct scenario_set *set)
+{
+  free(set->scenario);
+  free(set->event);
+  memset(set, 0, sizeof(*set));
+}
+
+/*
+ * Conditions
+ */
+
+static int scenario_digit(INT32U code)
+{
+  int i;
+
+  for (i = 0; i < (int) sizeof(scenario_seven); i++)
+    if (scenario_seven[i] == code)
+      return i;
+  return -1;
+}
+
+int scenario_velocity(INT32U hex_low, INT32S *velocity)
+{
+  int sign = scenario_digit((hex_low >> 14) & 0x7F);
+  int high = scenario_digit((hex_low >> 7) & 0x7F);
+  int low  = scenario_digit(hex_low & 0x7F);
+
+  /* 100 to 109 show the code of '-', the 11th of the table, as tens digit */
+  if ((sign != 0 && sign != 10) || high < 0 || low < 0 || low == 10)
+    return -1;
+  *velocity = (sign == 10 ? -1 : 1) * (high * 10 + low);
+  return 0;
+}
+
+int scenario_holds(const struct scenario_event *e, INT32U green, INT32U red, INT32U hex_low,
+                   INT32S *seen)
+{
+  INT32S v;
+  INT32U leds;
+
+  switch (e->cond) {
+  case SCENARIO_VELOCITY:
+    if (scenario_velocity(hex_low, &v) < 0) {
+      *seen = INT32_MIN;
+      return 0;
+    }
+    *seen = v;
+    switch (e->test) {
+    case SCENARIO_LT: return v <  e->value;
+    case SCENARIO_LE: return v <= e->value;
+    case SCENARIO_GT: return v >  e->value;
+    case SCENARIO_GE: return v >= e->value;
+    case SCENARIO_EQ: return v == e->value;
+    default:          return v != e->value;
+    }
+  case SCENARIO_GREEN:
+  case SCENARIO_RED:
+    leds  = e->cond == SCENARIO_GREEN ? green : red;
+    *seen = (INT32S) leds;
+    leds &= (INT32U) e->value;
+    return e->test == SCENARIO_ON ? leds == (INT32U) e->value : leds == 0;
+  default:
+    return 1;
+  }
+}
+
+void scenario_cond_text(const struct scenario_event *e, char *buf, size_t size)
+{
+  if (e->cond == SCENARIO_VELOCITY)
+    snprintf(buf, size, "velocity %s %d", scenario_ops[e->test], (int) e->value);
+  else if (e->cond == SCENARIO_GREEN || e->cond == SCENARIO_RED)
+    snprintf(buf, size, "%s 0x%x %s", e->cond == SCENARIO_GREEN ? "green" : "red",
+             (unsigned) e->value, e->test == SCENARIO_ON ? "on" : "off");
+  else
+    snprintf(buf, size, "always");
+}
@@ -0,0 +1,125 @@
+/* Drive scenarios of the host simulator
+ *
+ * Description:
+ *
+ *   A scenario file describes runs of a cruise program as timed board
+ *   inputs and the outputs expected meanwhile, one statement per line
+ *   ('#' starts a comment):
+ *
+ *     scenario NAME [for TIME]
+ *     TIME ACTION
+ *     TIME when COND ACTION       ACTION once COND holds, checked from TIME on
+ *     TIME[..TIME] expect COND    at TIME, or during the whole interval
+ *
+ *     ACTION := press KEY | release KEY | tap KEY | switch SWITCH on|off
+ *     COND   := velocity OP NUMBER | green MASK on|off | red MASK on|off
+ *     KEY    := gas | brake | cruise | increase | key0 .. key3
+ *     SWITCH := engine | top_gear | sw0 .. sw17
+ *     OP     := < | <= | > | >= | == | !=
+ *     TIME   := NUMBER followed by ms, s or min, from the start of the run
+ *
+ *   for example
+ *
+ *     scenario cruise-on-the-flat
+ *       0s       switch engine on
+ *       0s       switch top_gear on
+ *       0s       press gas
+ *       0s       when velocity >= 25 release gas
+ *       30s      tap cruise
+ *       35s      expect green 0x1 on
+ *       40s..60s expect velocity >= 20
+ *
+ *   'tap' holds a key for SCENARIO_TAP_MS, longer than the period of the
+ *   button task. The velocity is the one on the seven-segment display
+ *   (HEX_LOW), the masks select green or red LEDs that must all be on or
+ *   all be off. A run lasts until 1 s after its last statement unless
+ *   'for' gives its length.
+ *
+ *   scenario_load() compiles a file into one array of events, each
+ *   scenario a slice sorted by time (statements at the same time keep
+ *   their order), which the runner walks with a single index.
+ */
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include <stddef.h>
+
+#include "includes.h"
+
+#define SCENARIO_NAME    48
+#define SCENARIO_TAP_MS  1000
+#define SCENARIO_TAIL_MS 1000
+
+enum scenario_action {
+  SCENARIO_NONE,                     /* expect */
+  SCENARIO_PRESS,
+  SCENARIO_RELEASE,
+  SCENARIO_TAP,                      /* only after 'when', plain taps are compiled
+                                        into a press and a release */
+  SCENARIO_SWITCH_ON,
+  SCENARIO_SWITCH_OFF
+};
+
+enum scenario_cond {
+  SCENARIO_ALWAYS,
+  SCENARIO_VELOCITY,
+  SCENARIO_GREEN,
+  SCENARIO_RED
+};
+
+enum scenario_test {
+  SCENARIO_LT,
+  SCENARIO_LE,
+  SCENARIO_GT,
+  SCENARIO_GE,
+  SCENARIO_EQ,
+  SCENARIO_NE,
+  SCENARIO_ON,
+  SCENARIO_OFF
+};
+
+struct scenario_event {
+  INT32U time;                       /* ms from the start */
+  INT32U until;                      /* last ms of an interval expect, else time */
+  INT32U mask;                       /* keys or switches of the action */
+  INT32S value;                      /* velocity or LED mask of the condition */
+  INT16U line;
+  INT8U  action;                     /* enum scenario_action */
+  INT8U  cond;                       /* enum scenario_cond */
+  INT8U  test;                       /* enum scenario_test */
+};
+
+struct scenario {
+  char   name[SCENARIO_NAME];
+  INT32U first;                      /* slice of the event array */
+  INT32U events;
+  INT32U length;                     /* ms */
+};
+
+struct scenario_set {
+  struct scenario       *scenario;
+  size_t                 scenarios;
+  struct scenario_event *event;
+  size_t                 events;
+};
+
+/* Appends the scenarios of 'path' to the set; returns -1 after printing
+   the first error */
+int  scenario_load(struct scenario_set *set, const char *path);
+void scenario_free(struct scenario_set *set);
+
+/*
+ * Velocity shown by a HEX_LOW value written by show_velocity_on_sevenseg(),
+ * or -1 if the display does not show a number (before the first write)
+ */
+int  scenario_velocity(INT32U hex_low, INT32S *velocity);
+
+/* Whether the condition of 'e' holds for these registers; *seen gets the
+   velocity or the LEDs it tested */
+int  scenario_holds(const struct scenario_event *e, INT32U green, INT32U red, INT32U hex_low,
+                    INT32S *seen);
+
+/* The condition of 'e' as written in a scenario, for messages */
+void scenario_cond_text(const struct scenario_event *e, char *buf, size_t size);
+
+#endif /* SCENARIO_H */
@@ -0,0 +1,377 @@
+/* Batch runner of drive scenarios for the cruise control lab
+ *
+ * Description:
+ *
+ *   Links one of the cruise.c programs (its main() renamed app_main()) with
+ *   the simulation port like cruise_sim.c, and runs every scenario of the
+ *   given files (sim/scenario.h) from a fresh start of the program.
+ *
+ *   The fresh start is a checkpoint of the system taken before app_main()
+ *   created any task (OSSimCheckpoint()), restored before each scenario.
+ *   An alarm then walks the events of the scenario: it sets the keys and
+ *   switches when they are due, checks the expectations against the LED
+ *   and seven-segment registers, and while a 'when' or an interval is
+ *   pending polls them every SCENARIO_POLL_MS.
+ *
+ *   The scenarios are handed out to -j worker processes (all CPUs by
+ *   default) from a counter in shared memory, and the results are written
+ *   to a shared array, so the report is the same for any number of
+ *   workers. The exit status is 1 if a scenario failed. -q only reports
+ *   the failures, -v keeps the messages the program prints.
+ *
+ *   Restarting the program must not cost memory: a worker whose mappings
+ *   grew between its first and its last scenario reports it and fails.
+ *
+ *   usage: cruise-scenario [-j workers] [-c calls] [-t track] [-q] [-v] file...
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "system.h"
+#include "includes.h"
+#include "altera_avalon_pio_regs.h"
+#include "sys/alt_alarm.h"
+#include "alt_host.h"
+#include "os_sim.h"
+#include "scenario.h"
+#include "track_file.h"
+
+#define SCENARIO_POLL_MS 10
+#define SCENARIO_ARMED   32
+
+enum scenario_failure {
+  SCENARIO_PASSED,
+  SCENARIO_EXPECT_FAILED,
+  SCENARIO_NEVER_HELD,               /* a 'when' waited until the end */
+  SCENARIO_TOO_MANY                  /* more than SCENARIO_ARMED pending */
+};
+
+struct scenario_result {
+  INT32U failures;
+  INT32U event;                      /* index of the first failure */
+  INT32U time;                       /* ms */
+  INT32S seen;                       /* velocity or LEDs at that time */
+  INT32U failure;                    /* enum scenario_failure */
+};
+
+struct scenario_armed {
+  const struct scenario_event *e;
+  INT32U                       release;   /* ms, key release of a tap that fired */
+};
+
+struct scenario_shared {
+  size_t                 next;       /* next scenario to run */
+  struct scenario_result result[];
+};
+
+int app_main(void);
+
+/*
+ * State of the running scenario. It lives in the data segment, which the
+ * checkpoint restores: it is set up after the restore.
+ */
+static struct {
+  const struct scenario_set *set;
+  const struct scenario_event *next, *end;
+  struct scenario_result    *result;
+  struct scenario_armed      armed[SCENARIO_ARMED];
+  int                        armed_n;
+} scn;
+
+static alt_alarm scn_alarm;
+
+static double scn_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static INT32U scn_ticks(INT32U ms)
+{
+  return (INT32U) ((uint64_t) ms * alt_ticks_per_second() / 1000);
+}
+
+static void scn_fail(const struct scenario_event *e, INT32U now, INT32S seen,
+                     enum scenario_failure failure)
+{
+  struct scenario_result *r = scn.result;
+
+  if (r->failures++ != 0)
+    return;
+  r->event   = (INT32U) (e - scn.set->event);
+  r->time    = now;
+  r->seen    = seen;
+  r->failure = failure;
+}
+
+static void scn_act(INT8U action, INT32U mask)
+{
+  alt_u32 keys     = IORD_ALTERA_AVALON_PIO_DATA(D2_PIO_KEYS4_BASE);
+  alt_u32 switches = IORD_ALTERA_AVALON_PIO_DATA(DE2_PIO_TOGGLES18_BASE);
+
+  /* the keys are active low */
+  switch (action) {
+  case SCENARIO_PRESS:
+  case SCENARIO_TAP:        keys &= ~mask;    break;
+  case SCENARIO_RELEASE:    keys |= mask;     break;
+  case SCENARIO_SWITCH_ON:  switches |= mask; break;
+  case SCENARIO_SWITCH_OFF: switches &= ~mask; break;
+  }
+  IOWR_ALTERA_AVALON_PIO_DATA(D2_PIO_KEYS4_BASE, keys);
+  IOWR_ALTERA_AVALON_PIO_DATA(DE2_PIO_TOGGLES18_BASE, switches);
+}
+
+static alt_u32 scn_alarm_cb(void *context)
+{
+  INT32U green = IORD_ALTERA_AVALON_PIO_DATA(DE2_PIO_GREENLED9_BASE);
+  INT32U red   = IORD_ALTERA_AVALON_PIO_DATA(DE2_PIO_REDLED18_BASE);
+  INT32U hex   = IORD_ALTERA_AVALON_PIO_DATA(DE2_PIO_HEX_LOW28_BASE);
+  INT32U now   = (INT32U) ((uint64_t) alt_nticks() * 1000 / alt_ticks_per_second());
+  INT32U next  = 0xFFFFFFFFu;
+  const struct scenario_event *e;
+  struct scenario_armed       *a;
+  INT32S seen;
+  int    i;
+
+  while (scn.next < scn.end && scn_ticks(scn.next->time) <= alt_nticks()) {
+    e = scn.next++;
+    if (e->action == SCENARIO_NONE && e->until == e->time) {
+      if (!scenario_holds(e, green, red, hex, &seen))
+        scn_fail(e, now, seen, SCENARIO_EXPECT_FAILED);
+    } else if (e->cond == SCENARIO_ALWAYS) {
+      scn_act(e->action, e->mask);
+    } else if (scn.armed_n == SCENARIO_ARMED) {
+      scn_fail(e, now, 0, SCENARIO_TOO_MANY);
+    } else {
+      scn.armed[scn.armed_n].e         = e;
+      scn.armed[scn.armed_n++].release = 0;
+    }
+  }
+
+  for (i = 0; i < scn.armed_n; i++) {
+    a = &scn.armed[i];
+    e = a->e;
+    if (a->release != 0) {
+      if (now < a->release) {
+        if (a->release - now < next)
+          next = a->release - now;
+        continue;
+      }
+      scn_act(SCENARIO_RELEASE, e->mask);
+    } else if (e->action == SCENARIO_NONE) {
+      if (scenario_holds(e, green, red, hex, &seen)) {
+        if (now < e->until) {
+          next = next < SCENARIO_POLL_MS ? next : SCENARIO_POLL_MS;
+          continue;
+        }
+      } else {
+        scn_fail(e, now, seen, SCENARIO_EXPECT_FAILED);
+      }
+    } else if (!scenario_holds(e, green, red, hex, &seen)) {
+      next = next < SCENARIO_POLL_MS ? next : SCENARIO_POLL_MS;
+      continue;
+    } else {
+      scn_act(e->action, e->mask);
+      if (e->action == SCENARIO_TAP) {
+        a->release = now + SCENARIO_TAP_MS;
+        next = next < SCENARIO_TAP_MS ? next : SCENARIO_TAP_MS;
+        continue;
+      }
+    }
+    scn.armed[i--] = scn.armed[--scn.armed_n];
+  }
+
+  if (scn.next < scn.end && scn.next->time - now < next)
+    next = scn.next->time - now;
+  return next == 0xFFFFFFFFu ? 0 : scn_ticks(next);
+}
+
+/* Size of the mappings and the resident memory of the process, pages */
+static int scn_memory(unsigned long *size, unsigned long *resident)
+{
+  FILE *f = fopen("/proc/self/statm", "r");
+  int   n = f != NULL ? fscanf(f, "%lu %lu", size, resident) : 0;
+
+  if (f != NULL)
+    fclose(f);
+  return n == 2 ? 0 : -1;
+}
+
+static void scn_run(const struct scenario_set *set, const void *ckpt, size_t size,
+                    struct scenario_shared *shared)
+{
+  const struct scenario *s;
+  unsigned long mapped[2], resident[2], page;
+  size_t  k, runs = 0;
+  INT32U  first;
+  int     i;
+
+  while ((k = __atomic_fetch_add(&shared->next, 1, __ATOMIC_RELAXED)) < set->scenarios) {
+    if (OSSimRestore(ckpt, size) != OS_ERR_NONE) {
+      fprintf(stderr, "[scenario] cannot restore the checkpoint\n");
+      exit(1);
+    }
+    s = &set->scenario[k];
+    scn.set     = set;
+    scn.next    = &set->event[s->first];
+    scn.end     = scn.next + s->events;
+    scn.result  = &shared->result[k];
+    scn.armed_n = 0;
+
+    /* the inputs at 0 ms are in place before the program starts */
+    if ((first = scn_alarm_cb(NULL)) != 0)
+      alt_alarm_start(&scn_alarm, first - 1, scn_alarm_cb, NULL);
+    OSSimStopAt(scn_ticks(s->length));
+    app_main();
+
+    for (i = 0; i < scn.armed_n; i++)
+      if (scn.armed[i].release == 0 && scn.armed[i].e->action != SCENARIO_NONE)
+        scn_fail(scn.armed[i].e, s->length, 0, SCENARIO_NEVER_HELD);
+    if (runs++ == 0 && scn_memory(&mapped[0], &resident[0]) < 0)
+      runs = 0;
+  }
+
+  if (runs > 1 && scn_memory(&mapped[1], &resident[1]) == 0 && mapped[1] > mapped[0]) {
+    page = (unsigned long) sysconf(_SC_PAGESIZE) / 1024;
+    fprintf(stderr, "[scenario] worker %d grew over %zu scenarios: %lu to %lu KB mapped, "
+            "%lu to %lu KB resident\n", (int) getpid(), runs, mapped[0] * page, mapped[1] * page,
+            resident[0] * page, resident[1] * page);
+    exit(1);
+  }
+}
+
+static void scn_report(const struct scenario_set *set, const struct scenario_result *r,
+                       int quiet)
+{
+  const struct scenario_event *e = &set->event[r->event];
+  char cond[64];
+
+  scenario_cond_text(e, cond, sizeof(cond));
+  switch (r->failure) {
+  case SCENARIO_EXPECT_FAILED:
+    printf(": line %u: %s at %.3f s, ", e->line, cond, r->time / 1000.0);
+    if (e->cond != SCENARIO_VELOCITY)
+      printf("%s 0x%x\n", e->cond == SCENARIO_GREEN ? "green" : "red", (unsigned) r->seen);
+    else if (r->seen == INT32_MIN)
+      printf("display blank\n");
+    else
+      printf("velocity %d\n", (int) r->seen);
+    break;
+  case SCENARIO_NEVER_HELD:
+    printf(": line %u: %s never held\n", e->line, cond);
+    break;
+  default:
+    printf(": line %u: more than %d conditions pending\n", e->line, SCENARIO_ARMED);
+    break;
+  }
+  if (r->failures > 1 && !quiet)
+    printf("  and %u more failures\n", r->failures - 1);
+}
+
+int main(int argc, char **argv)
+{
+  struct scenario_set     set = {NULL, 0, NULL, 0};
+  struct scenario_shared *shared;
+  struct track           *track = NULL;
+  size_t  size, bytes, k, failed = 0;
+  void   *ckpt;
+  double  t0, t1;
+  pid_t   pid;
+  int     opt, w, status, workers = 0, quiet = 0, verbose = 0, crashed = 0;
+
+  while ((opt = getopt(argc, argv, "j:c:t:qv")) != -1) {
+    switch (opt) {
+    case 'j': workers = atoi(optarg); break;
+    case 'c': OSSimSetCallsPerTick((INT32U) strtoul(optarg, NULL, 0)); break;
+    case 't':
+      track_free(track);
+      if ((track = track_load(optarg)) == NULL)
+        return 1;
+      track_default = track;
+      break;
+    case 'q': quiet = 1; break;
+    case 'v': verbose = 1; break;
+    default:
+      goto usage;
+    }
+  }
+  if (optind == argc)
+    goto usage;
+  for (; optind < argc; optind++)
+    if (scenario_load(&set, argv[optind]) < 0)
+      return 1;
+  if (workers <= 0)
+    workers = (int) sysconf(_SC_NPROCESSORS_ONLN);
+  if (workers <= 0)
+    workers = 1;
+
+  bytes  = sizeof(*shared) + set.scenarios * sizeof(shared->result[0]);
+  shared = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (shared == MAP_FAILED) {
+    perror("mmap");
+    return 1;
+  }
+
+  /* A fresh program: the system right after the reset, before any task */
+  alt_host_reset();
+  size = OSSimCheckpoint(NULL, 0);
+  if ((ckpt = malloc(size)) == NULL) {
+    fprintf(stderr, "[scenario] out of memory\n");
+    return 1;
+  }
+  OSSimCheckpoint(ckpt, size);
+
+  fflush(stdout);
+  t0 = scn_now();
+  for (w = 0; w < workers; w++) {
+    if ((pid = fork()) == 0) {
+      /* the messages of the program, unless -v */
+      if (!verbose && freopen("/dev/null", "w", stdout) == NULL)
+        _exit(1);
+      scn_run(&set, ckpt, size, shared);
+      fflush(stdout);
+      _exit(0);
+    }
+    if (pid < 0) {
+      perror("fork");
+      crashed = 1;
+      break;
+    }
+  }
+  while (wait(&status) > 0)
+    crashed |= !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+  t1 = scn_now();
+  if (crashed) {
+    fprintf(stderr, "[scenario] a worker failed\n");
+    return 1;
+  }
+
+  for (k = 0; k < set.scenarios; k++) {
+    if (shared->result[k].failures == 0) {
+      if (!quiet)
+        printf("PASS %s\n", set.scenario[k].name);
+      continue;
+    }
+    failed++;
+    printf("FAIL %s", set.scenario[k].name);
+    scn_report(&set, &shared->result[k], quiet);
+  }
+  fflush(stdout);
+  fprintf(stderr, "[scenario] %zu passed, %zu failed, %zu events on %d workers: %.3f s wall, "
+          "%.1f scenarios/s\n", set.scenarios - failed, failed, set.events, workers, t1 - t0,
+          set.scenarios / (t1 - t0));
+  free(ckpt);
+  scenario_free(&set);
+  return failed != 0;
+
+usage:
+  fprintf(stderr, "usage: %s [-j workers] [-c calls] [-t track] [-q] [-v] file...\n", argv[0]);
+  return 2;
+}
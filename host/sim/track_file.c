@@ -0,0 +1,102 @@
+/* Track files of the host programs, see track_file.h */
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "track_file.h"
+
+#define TRACK_FILE_MAGIC "TRK1"
+
+struct track_file_segment {
+  INT32U start;
+  INT32S gradient;
+};
+
+struct track *track_load(const char *path)
+{
+  FILE                     *f = fopen(path, "rb");
+  struct track             *track = NULL;
+  struct track_segment     *segment = NULL;
+  struct track_file_segment rec;
+  INT32U                    hdr[2], i, n, shift;
+  INT32U                   *bucket;
+  char                      magic[4];
+
+  if (f == NULL) {
+    fprintf(stderr, "%s: %s\n", path, strerror(errno));
+    return NULL;
+  }
+  if (fread(magic, 1, 4, f) != 4 || memcmp(magic, TRACK_FILE_MAGIC, 4) != 0 ||
+      fread(hdr, sizeof(INT32U), 2, f) != 2)
+    goto bad;
+  segment = malloc(hdr[1] * sizeof(*segment));
+  if (hdr[1] == 0 || segment == NULL)
+    goto bad;
+  for (i = 0; i < hdr[1]; i++) {
+    if (fread(&rec, sizeof(rec), 1, f) != 1 || rec.gradient < -32768 || rec.gradient > 32767)
+      goto bad;
+    segment[i].start    = rec.start;
+    segment[i].gradient = (INT16S) rec.gradient;
+  }
+  n = track_buckets(segment, hdr[1], hdr[0], &shift);
+  if (n == 0)
+    goto bad;
+  track  = malloc(sizeof(*track));
+  bucket = malloc(n * sizeof(*bucket));
+  if (track == NULL || bucket == NULL) {
+    free(bucket);
+    goto bad;
+  }
+  fclose(f);
+  track->length   = hdr[0];
+  track->segments = hdr[1];
+  track->segment  = segment;
+  track->shift    = shift;
+  track_index(track, bucket);
+  return track;
+
+bad:
+  fprintf(stderr, "%s: not a valid track file\n", path);
+  fclose(f);
+  free(segment);
+  free(track);
+  return NULL;
+}
+
+int track_save(const char *path, const struct track *track)
+{
+  FILE                     *f = fopen(path, "wb");
+  struct track_file_segment rec;
+  INT32U                    i;
+  int                       ok;
+
+  if (f == NULL) {
+    fprintf(stderr, "%s: %s\n", path, strerror(errno));
+    return -1;
+  }
+  ok = fwrite(TRACK_FILE_MAGIC, 1, 4, f) == 4 &&
+       fwrite(&track->length, sizeof(INT32U), 1, f) == 1 &&
+       fwrite(&track->segments, sizeof(INT32U), 1, f) == 1;
+  for (i = 0; ok && i < track->segments; i++) {
+    rec.start    = track->segment[i].start;
+    rec.gradient = track->segment[i].gradient;
+    ok = fwrite(&rec, sizeof(rec), 1, f) == 1;
+  }
+  if (fclose(f) != 0)
+    ok = 0;
+  if (!ok) {
+    fprintf(stderr, "%s: %s\n", path, strerror(errno));
+    return -1;
+  }
+  return 0;
+}
+
+void track_free(struct track *track)
+{
+  if (track == NULL)
+    return;
+  free((void *) track->segment);
+  free((void *) track->bucket);
+  free(track);
+}
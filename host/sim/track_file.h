@@ -0,0 +1,27 @@
+/* Track files of the host programs
+ *
+ * Description:
+ *
+ *   A track file holds a track of model/track.h in host byte order:
+ *
+ *     "TRK1"                  magic
+ *     INT32U length           m
+ *     INT32U segments
+ *     segments x { INT32U start; INT32S gradient; }
+ *
+ *   The bucket index is rebuilt when the file is read.
+ */
+#ifndef TRACK_FILE_H
+#define TRACK_FILE_H
+
+#include "track.h"
+
+/* Returns the track of 'path', NULL after printing why it is not valid */
+struct track *track_load(const char *path);
+
+/* Returns 0, or -1 after printing why the file could not be written */
+int           track_save(const char *path, const struct track *track);
+
+void          track_free(struct track *track);
+
+#endif /* TRACK_FILE_H */
@@ -0,0 +1,105 @@
+/* Headless cruise scenario, see cruise_run.h */
+#include <stdlib.h>
+#include <string.h>
+
+#include "cruise_run.h"
+
+#define CRUISE_DT (CONTROL_STEP_MS / 1000.0)
+
+void cruise_run_init(struct cruise_run *run, const struct cruise_case *c, double kp, double ki,
+                     double kd)
+{
+  struct pid_fx *pid = &run->ctrl.pid;
+
+  memset(run, 0, sizeof(*run));
+  run->control = control_step;
+  vehicle_init(&run->car);
+  if (c->track != NULL)
+    run->car.track = c->track;
+  run->car.position = c->position;
+  run->car.velocity = c->v0;
+
+  control_init(&run->ctrl);
+  run->ctrl.track           = run->car.track;
+  run->ctrl.position        = c->position;
+  run->ctrl.engine_state    = 1;
+  run->ctrl.top_gear        = on;
+  run->ctrl.cruise_control  = on;
+  run->ctrl.target_velocity = c->setpoint;
+  pid->kp = PID_FX_C(kp, pid->q);
+  pid->ki = PID_FX_C(ki, pid->q);
+  pid->kd = PID_FX_C(kd, pid->q);
+  pid_fx_reset(pid, (int32_t) STATIONARY_THROTTLE << pid->q);
+
+  run->in.buttons  = 0;
+  run->in.switches = ENGINE_FLAG | TOP_GEAR_FLAG;
+  run->setpoint    = c->setpoint;
+  run->v0          = c->v0;
+}
+
+int cruise_run_step(struct cruise_run *run, INT32U periods, INT32U bound)
+{
+  static const struct vehicle_inputs cruising = {0, off, on};
+  struct vehicle_inputs  drive = cruising;
+  struct control_outputs out;
+  INT32S band = run->setpoint * CRUISE_BAND;
+  INT32S error, past;
+  INT32U k, slot;
+
+  if (run->aborted)
+    return -1;
+  if (band < 1)
+    band = 1;
+  for (k = 0; k < periods; k++) {
+    run->in.velocity = run->car.velocity;
+    run->control(&run->ctrl, &run->in, &out);
+    drive.throttle = out.throttle;
+    vehicle_step(&run->car, &drive);
+
+    error = run->setpoint - run->car.velocity;
+    past  = run->setpoint >= run->v0 ? -error : error;
+    if (past > run->overshoot)
+      run->overshoot = past;
+    run->period++;
+    if (abs(error) > band)
+      run->unsettled = run->period;
+    run->iae      += abs(error);
+    run->ise      += (uint64_t) (error * error);
+    run->throttle += out.throttle;
+    slot = run->period & (CRUISE_SS_PERIODS - 1);
+    run->recent_sum += abs(error) - run->recent[slot];
+    run->recent[slot] = abs(error);
+    if (bound != 0 && (INT32U) abs(error) > bound) {
+      run->aborted = 1;
+      return -1;
+    }
+  }
+  return 0;
+}
+
+void cruise_run_retarget(struct cruise_run *run, INT16S setpoint)
+{
+  run->ctrl.target_velocity = setpoint;
+  run->setpoint   = setpoint;
+  run->v0         = run->car.velocity;
+  run->period     = 0;
+  run->unsettled  = 0;
+  run->overshoot  = 0;
+  run->iae        = 0;
+  run->ise        = 0;
+  run->throttle   = 0;
+  run->recent_sum = 0;
+  memset(run->recent, 0, sizeof(run->recent));
+}
+
+void cruise_run_metrics(const struct cruise_run *run, struct cruise_metrics *m)
+{
+  INT32U n = run->period < CRUISE_SS_PERIODS ? run->period : CRUISE_SS_PERIODS;
+
+  m->settling  = run->unsettled == run->period ? -1.0 : run->unsettled * CRUISE_DT;
+  m->overshoot = run->overshoot;
+  m->ss_error  = n ? (double) run->recent_sum / n : 0.0;
+  m->iae       = run->iae * CRUISE_DT;
+  m->ise       = run->ise * CRUISE_DT;
+  m->effort    = run->period ? (double) run->throttle / run->period : 0.0;
+}
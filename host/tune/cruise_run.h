@@ -0,0 +1,81 @@
+/* Headless cruise scenario
+ *
+ * Description:
+ *
+ *   One closed loop of control_step() and vehicle_step() with the cruise
+ *   control engaged, as the tasks of src-merlijn/cruise.c run it once the
+ *   driver has pressed the cruise button: engine on, top gear, no pedal.
+ *   The vehicle starts at velocity v0 and the target is the setpoint, so
+ *   the run is a step response of the controller, disturbed by the slopes
+ *   of the track.
+ *
+ *   A run can be advanced a few periods at a time and gives up as soon as
+ *   the velocity error exceeds a bound, which lets an optimizer spend its
+ *   simulated time on the gains that look promising.
+ */
+#ifndef CRUISE_RUN_H
+#define CRUISE_RUN_H
+
+#include "control.h"
+
+/* Settled means within this fraction of the setpoint, at least 1 m/s */
+#define CRUISE_BAND      0.02
+
+/* The steady-state error is averaged over this many periods (power of two) */
+#define CRUISE_SS_PERIODS 64
+
+struct cruise_case {
+  INT16S              v0;         /* m/s, initial velocity */
+  INT16S              setpoint;   /* m/s, target velocity */
+  INT32U              position;   /* m, initial position */
+  const struct track *track;      /* NULL: track_default */
+};
+
+/* The controller of a run, control_step() unless replaced after init */
+typedef void (*cruise_control_fn)(struct control_state *state, const struct control_inputs *in,
+                                  struct control_outputs *out);
+
+struct cruise_run {
+  cruise_control_fn     control;
+  struct vehicle_state  car;
+  struct control_state  ctrl;
+  struct control_inputs in;
+  INT16S setpoint;
+  INT16S v0;
+  INT32U period;                  /* periods simulated */
+  INT32U unsettled;               /* periods up to the last one out of the band */
+  INT32S overshoot;               /* m/s past the setpoint, away from v0 */
+  INT32U iae;                     /* sum of |error| in m/s */
+  uint64_t ise;                   /* sum of error^2 */
+  INT32U throttle;                /* sum of throttle */
+  INT16U recent[CRUISE_SS_PERIODS];
+  INT32U recent_sum;              /* sum of |error| over recent[] */
+  int    aborted;
+};
+
+struct cruise_metrics {
+  double settling;                /* s, negative if not settled at the end */
+  double overshoot;               /* m/s */
+  double ss_error;                /* m/s, mean |error| of the last periods */
+  double iae;                     /* m/s * s */
+  double ise;                     /* (m/s)^2 * s */
+  double effort;                  /* mean throttle */
+};
+
+/* Prepares a run with per-period gains kp, ki and kd */
+void cruise_run_init(struct cruise_run *run, const struct cruise_case *c, double kp, double ki,
+                     double kd);
+
+/*
+ * Simulates up to 'periods' more control periods; returns -1 and stops for
+ * good if |error| exceeds 'bound' m/s (0: no bound), 0 otherwise
+ */
+int  cruise_run_step(struct cruise_run *run, INT32U periods, INT32U bound);
+
+/* Changes the target of the engaged controller; the metrics from now on
+   are those of the step from the current velocity to 'setpoint' */
+void cruise_run_retarget(struct cruise_run *run, INT16S setpoint);
+
+void cruise_run_metrics(const struct cruise_run *run, struct cruise_metrics *m);
+
+#endif /* CRUISE_RUN_H */
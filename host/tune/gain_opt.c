@@ -0,0 +1,220 @@
+/* Successive halving search of the cruise controller gains
+ *
+ * Description:
+ *
+ *   Draws n random kp, ki, kd candidates and races them in rungs instead of
+ *   simulating a full grid: every rung advances the surviving runs (on all
+ *   CPUs) to a longer horizon, ranks them by IAE and keeps the best 1/eta
+ *   of them, so that only a few candidates get the full -P periods. A run
+ *   whose velocity error ever exceeds the bound (-b, m/s) is stopped on the
+ *   spot and drops out.
+ *
+ *   The runs are resumed where the previous rung left them
+ *   (cruise_run_step()), so the IAE of a rung is the IAE of the full run so
+ *   far and only grows. The report gives the simulated periods every rung
+ *   cost and how many it took until a candidate reached the cost -c over
+ *   the full horizon, against the periods a full evaluation of all
+ *   candidates would need. The candidates only depend on the seed (-S), the
+ *   results not on the number of workers.
+ *
+ *   usage: gain-opt [-n candidates] [-e eta] [-P periods] [-b bound] [-c cost]
+ *                   [-p kp0:kp1] [-i ki0:ki1] [-d kd0:kd1] [-v v0] [-s setpoint]
+ *                   [-S seed] [-j workers] [-t track]
+ */
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "cruise_run.h"
+#include "parallel.h"
+#include "track_file.h"
+#include "bench.h"
+
+/* Shortest horizon of the first rung, in periods */
+#define OPT_MIN_PERIODS 8
+
+struct opt_candidate {
+  double            kp, ki, kd;
+  double            cost;         /* IAE so far, INFINITY once aborted */
+  struct cruise_run run;
+};
+
+struct opt {
+  struct opt_candidate  *cand;
+  struct opt_candidate **alive;   /* survivors of the previous rung */
+  INT32U                 budget;  /* horizon of the current rung */
+  INT32U                 bound;
+};
+
+static void opt_chunk(size_t begin, size_t end, int worker, void *arg)
+{
+  struct opt            *o = arg;
+  struct opt_candidate  *c;
+  struct cruise_metrics  m;
+  size_t                 i;
+
+  for (i = begin; i < end; i++) {
+    c = o->alive[i];
+    if (cruise_run_step(&c->run, o->budget - c->run.period, o->bound) < 0) {
+      c->cost = INFINITY;
+    } else {
+      cruise_run_metrics(&c->run, &m);
+      c->cost = m.iae;
+    }
+  }
+}
+
+/* Best first, ties in candidate order so that the ranking is stable */
+static int opt_cmp(const void *a, const void *b)
+{
+  const struct opt_candidate *x = *(struct opt_candidate *const *) a;
+  const struct opt_candidate *y = *(struct opt_candidate *const *) b;
+
+  if (x->cost != y->cost)
+    return x->cost < y->cost ? -1 : 1;
+  return x < y ? -1 : x > y;
+}
+
+/* splitmix64, uniform in [lo, hi) */
+static double opt_random(uint64_t *state, const double range[2])
+{
+  uint64_t z = (*state += 0x9e3779b97f4a7c15ull);
+
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  z ^= z >> 31;
+  return range[0] + (range[1] - range[0]) * (z >> 11) * 0x1.0p-53;
+}
+
+static int opt_range_arg(double range[2], const char *arg)
+{
+  return sscanf(arg, "%lf:%lf", &range[0], &range[1]) == 2 ? 0 : -1;
+}
+
+int main(int argc, char **argv)
+{
+  struct cruise_case    c = {30, 50, 0, NULL};
+  struct opt            o = {NULL, NULL, 0, 0};
+  struct track         *track = NULL;
+  double                kp[2] = {0, 2}, ki[2] = {0, 1}, kd[2] = {0, 1};
+  double                target = 0, t0, t1;
+  uint64_t              seed = 1;
+  uint64_t              spent = 0, reached = 0, full;
+  INT32U                periods = 400, first;
+  size_t                n = 729, alive, keep, i;
+  int                   eta = 3, rungs, r, workers = 0, opt, aborted;
+
+  while ((opt = getopt(argc, argv, "n:e:P:b:c:p:i:d:v:s:S:j:t:")) != -1) {
+    switch (opt) {
+    case 'n': n        = strtoul(optarg, NULL, 0); break;
+    case 'e': eta      = atoi(optarg); break;
+    case 'P': periods  = strtoul(optarg, NULL, 0); break;
+    case 'b': o.bound  = strtoul(optarg, NULL, 0); break;
+    case 'c': target   = atof(optarg); break;
+    case 'p': if (opt_range_arg(kp, optarg) < 0) goto usage; break;
+    case 'i': if (opt_range_arg(ki, optarg) < 0) goto usage; break;
+    case 'd': if (opt_range_arg(kd, optarg) < 0) goto usage; break;
+    case 'v': c.v0       = (INT16S) atoi(optarg); break;
+    case 's': c.setpoint = (INT16S) atoi(optarg); break;
+    case 'S': seed     = strtoull(optarg, NULL, 0); break;
+    case 'j': workers  = atoi(optarg); break;
+    case 't':
+      if ((track = track_load(optarg)) == NULL)
+        return 1;
+      c.track = track;
+      break;
+    default:
+      goto usage;
+    }
+  }
+  if (n == 0 || eta < 2 || periods == 0)
+    goto usage;
+  /* Past the initial step plus some overshoot the candidate is hopeless */
+  if (o.bound == 0)
+    o.bound = abs(c.setpoint - c.v0) + 10;
+
+  o.cand  = malloc(n * sizeof(*o.cand));
+  o.alive = malloc(n * sizeof(*o.alive));
+  if (o.cand == NULL || o.alive == NULL) {
+    fprintf(stderr, "%s: out of memory\n", argv[0]);
+    return 1;
+  }
+  for (i = 0; i < n; i++) {
+    o.cand[i].kp = opt_random(&seed, kp);
+    o.cand[i].ki = opt_random(&seed, ki);
+    o.cand[i].kd = opt_random(&seed, kd);
+    cruise_run_init(&o.cand[i].run, &c, o.cand[i].kp, o.cand[i].ki, o.cand[i].kd);
+    o.alive[i] = &o.cand[i];
+  }
+  for (rungs = 1, keep = n; keep > (size_t) eta; keep /= eta)
+    rungs++;
+  workers = parallel_workers(workers);
+  full    = (uint64_t) n * periods;
+
+  printf("rung  candidates  periods  aborted  best_iae  kp        ki        kd        "
+         "simulated\n");
+  t0    = bench_now();
+  alive = n;
+  for (r = 0; r < rungs && alive > 0; r++) {
+    /* The horizon grows geometrically up to the full one in the last rung */
+    o.budget = periods;
+    if (r + 1 < rungs && periods > OPT_MIN_PERIODS)
+      o.budget = (INT32U) (OPT_MIN_PERIODS *
+                           pow((double) periods / OPT_MIN_PERIODS, (double) r / (rungs - 1)));
+    if (parallel_for(alive, 4, workers, opt_chunk, &o) < 0) {
+      fprintf(stderr, "%s: out of memory\n", argv[0]);
+      return 1;
+    }
+    qsort(o.alive, alive, sizeof(*o.alive), opt_cmp);
+
+    for (spent = 0, i = 0; i < n; i++)
+      spent += o.cand[i].run.period;
+    for (aborted = 0, i = 0; i < alive; i++)
+      aborted += o.alive[i]->run.aborted;
+    printf("%4d  %10zu  %7u  %7d  %8.1f  %-8.4f  %-8.4f  %-8.4f  %9llu\n", r, alive,
+           o.budget, aborted, o.alive[0]->cost, o.alive[0]->kp, o.alive[0]->ki, o.alive[0]->kd,
+           (unsigned long long) spent);
+    if (reached == 0 && o.budget == periods && o.alive[0]->cost <= target)
+      reached = spent;
+
+    keep = alive / eta ? alive / eta : 1;
+    if (keep > alive - aborted)
+      keep = alive - aborted;
+    alive = r + 1 < rungs ? keep : alive;
+  }
+  t1 = bench_now();
+
+  first = o.alive[0]->run.period;
+  fprintf(stderr, "[opt] %zu candidates, %d rungs on %d workers: %.3f s, %llu periods "
+          "simulated, %.1f%% of a full evaluation (%llu)\n", n, rungs, workers, t1 - t0,
+          (unsigned long long) spent, 100.0 * spent / full, (unsigned long long) full);
+  if (alive > 0 && !o.alive[0]->run.aborted) {
+    struct cruise_metrics m;
+
+    cruise_run_metrics(&o.alive[0]->run, &m);
+    fprintf(stderr, "[opt] best kp %g ki %g kd %g over %u periods: IAE %.1f, settling %.1f s, "
+            "overshoot %g m/s, steady-state error %.3f m/s\n", o.alive[0]->kp, o.alive[0]->ki,
+            o.alive[0]->kd, first, m.iae, m.settling, m.overshoot, m.ss_error);
+  } else {
+    fprintf(stderr, "[opt] every candidate exceeded the error bound of %u m/s\n", o.bound);
+  }
+  if (target > 0) {
+    if (reached != 0)
+      fprintf(stderr, "[opt] IAE %g reached after %llu simulated periods\n", target,
+              (unsigned long long) reached);
+    else
+      fprintf(stderr, "[opt] IAE %g not reached\n", target);
+  }
+  track_free(track);
+  free(o.alive);
+  free(o.cand);
+  return 0;
+
+usage:
+  fprintf(stderr, "usage: %s [-n candidates] [-e eta] [-P periods] [-b bound] [-c cost]\n"
+          "       [-p kp0:kp1] [-i ki0:ki1] [-d kd0:kd1] [-v v0] [-s setpoint]\n"
+          "       [-S seed] [-j workers] [-t track]\n", argv[0]);
+  return 2;
+}
@@ -0,0 +1,197 @@
+/* Grid sweep of the cruise controller gains
+ *
+ * Description:
+ *
+ *   Runs the headless cruise scenario (cruise_run.h) for every point of a
+ *   kp x ki x kd grid on all CPUs. The points are handed out from a work
+ *   queue in chunks; every worker appends its results to its own buffer
+ *   and the buffers are merged in grid order at the end.
+ *
+ *   One CSV line per point goes to stdout, the best point by IAE among the
+ *   settled ones and the run time to stderr. Gains are per control period,
+ *   like CONTROL_KP, CONTROL_KI and CONTROL_KD. With a result cache (-C,
+ *   result_cache.h) the points simulated before are read back.
+ *
+ *   usage: gain-sweep [-p kp0:kp1:n] [-i ki0:ki1:n] [-d kd0:kd1:n]
+ *                     [-v v0] [-s setpoint] [-P periods] [-j workers] [-t track]
+ *                     [-C cache]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "cruise_run.h"
+#include "parallel.h"
+#include "result_cache.h"
+#include "track_file.h"
+#include "bench.h"
+
+struct sweep_axis {
+  double lo;
+  double hi;
+  size_t n;
+};
+
+struct sweep_result {
+  size_t                index;
+  struct cruise_metrics m;
+};
+
+struct sweep_buffer {
+  struct sweep_result *r;
+  size_t               used;
+  size_t               size;
+  char                 pad[64];   /* keeps the buffers on separate cache lines */
+};
+
+struct sweep {
+  struct sweep_axis    kp, ki, kd;
+  struct cruise_case   c;
+  INT32U               periods;
+  struct sweep_buffer *buffer;    /* one per worker */
+  int                  oom;
+  struct result_cache  cache;
+  struct result_key    key;       /* of the tool, the point is added */
+};
+
+static double sweep_value(const struct sweep_axis *a, size_t i)
+{
+  return a->n > 1 ? a->lo + (a->hi - a->lo) * i / (a->n - 1) : a->lo;
+}
+
+static void sweep_gains(const struct sweep *s, size_t index, double *kp, double *ki, double *kd)
+{
+  *kd = sweep_value(&s->kd, index % s->kd.n);
+  index /= s->kd.n;
+  *ki = sweep_value(&s->ki, index % s->ki.n);
+  *kp = sweep_value(&s->kp, index / s->ki.n);
+}
+
+static void sweep_chunk(size_t begin, size_t end, int worker, void *arg)
+{
+  struct sweep        *s = arg;
+  struct sweep_buffer *b = &s->buffer[worker];
+  struct cruise_run    run;
+  struct result_key    key;
+  double               kp, ki, kd;
+  size_t               i;
+
+  for (i = begin; i < end; i++) {
+    if (b->used == b->size) {
+      struct sweep_result *r = realloc(b->r, (b->size * 2 + 256) * sizeof(*r));
+
+      if (r == NULL) {
+        s->oom = 1;
+        return;
+      }
+      b->r    = r;
+      b->size = b->size * 2 + 256;
+    }
+    sweep_gains(s, i, &kp, &ki, &kd);
+    b->r[b->used].index = i;
+    key = s->key;
+    result_key_cruise(&key, &s->c, kp, ki, kd, s->periods);
+    if (result_cache_get(&s->cache, &key, &b->r[b->used].m, sizeof(b->r[b->used].m)) < 0) {
+      cruise_run_init(&run, &s->c, kp, ki, kd);
+      cruise_run_step(&run, s->periods, 0);
+      cruise_run_metrics(&run, &b->r[b->used].m);
+      result_cache_put(&s->cache, &key, &b->r[b->used].m, sizeof(b->r[b->used].m));
+    }
+    b->used++;
+  }
+}
+
+static int sweep_axis_arg(struct sweep_axis *a, const char *arg)
+{
+  return sscanf(arg, "%lf:%lf:%zu", &a->lo, &a->hi, &a->n) == 3 && a->n > 0 ? 0 : -1;
+}
+
+int main(int argc, char **argv)
+{
+  struct sweep           s = {{0, 2, 100}, {0, 1, 100}, {0, 1, 10}, {30, 50, 0, NULL}, 400, NULL, 0,
+                                  {NULL, -1, NULL, NULL, 0, 0, 0}, {{0, 0}}};
+  struct cruise_metrics *all;
+  struct track          *track = NULL;
+  const char            *cache = NULL;
+  size_t                 n, i, best = (size_t) -1;
+  double                 t0, t1, kp, ki, kd;
+  int                    workers = 0, opt, w;
+
+  while ((opt = getopt(argc, argv, "p:i:d:v:s:P:j:t:C:")) != -1) {
+    switch (opt) {
+    case 'p': if (sweep_axis_arg(&s.kp, optarg) < 0) goto usage; break;
+    case 'i': if (sweep_axis_arg(&s.ki, optarg) < 0) goto usage; break;
+    case 'd': if (sweep_axis_arg(&s.kd, optarg) < 0) goto usage; break;
+    case 'v': s.c.v0       = (INT16S) atoi(optarg); break;
+    case 's': s.c.setpoint = (INT16S) atoi(optarg); break;
+    case 'P': s.periods    = strtoul(optarg, NULL, 0); break;
+    case 'j': workers      = atoi(optarg); break;
+    case 't':
+      if ((track = track_load(optarg)) == NULL)
+        return 1;
+      s.c.track = track;
+      break;
+    case 'C': cache = optarg; break;
+    default:
+      goto usage;
+    }
+  }
+  if (result_cache_open(&s.cache, cache) < 0)
+    return 1;
+  result_key_init(&s.key, "gain-sweep");
+  workers  = parallel_workers(workers);
+  n        = s.kp.n * s.ki.n * s.kd.n;
+  s.buffer = calloc(workers, sizeof(*s.buffer));
+  all      = malloc(n * sizeof(*all));
+  if (s.buffer == NULL || all == NULL) {
+    fprintf(stderr, "%s: out of memory\n", argv[0]);
+    return 1;
+  }
+
+  t0 = bench_now();
+  if (parallel_for(n, 64, workers, sweep_chunk, &s) < 0 || s.oom) {
+    fprintf(stderr, "%s: out of memory\n", argv[0]);
+    return 1;
+  }
+  for (w = 0; w < workers; w++) {
+    for (i = 0; i < s.buffer[w].used; i++)
+      all[s.buffer[w].r[i].index] = s.buffer[w].r[i].m;
+    free(s.buffer[w].r);
+  }
+  t1 = bench_now();
+
+  printf("kp,ki,kd,settling_s,overshoot,ss_error,iae\n");
+  for (i = 0; i < n; i++) {
+    sweep_gains(&s, i, &kp, &ki, &kd);
+    printf("%g,%g,%g,%.1f,%g,%.3f,%.1f\n", kp, ki, kd, all[i].settling, all[i].overshoot,
+           all[i].ss_error, all[i].iae);
+    if (all[i].settling >= 0 && (best == (size_t) -1 || all[i].iae < all[best].iae))
+      best = i;
+  }
+
+  fprintf(stderr, "[sweep] %zu points x %u periods on %d workers: %.3f s, %.0f points/s\n", n,
+          s.periods, workers, t1 - t0, n / (t1 - t0));
+  if (s.cache.dir != NULL)
+    fprintf(stderr, "[sweep] cache %s: %llu hits, %llu misses\n", s.cache.dir,
+            (unsigned long long) s.cache.hits, (unsigned long long) s.cache.misses);
+  if (best != (size_t) -1) {
+    sweep_gains(&s, best, &kp, &ki, &kd);
+    fprintf(stderr, "[sweep] best kp %g ki %g kd %g: settling %.1f s, overshoot %g m/s, "
+            "steady-state error %.3f m/s, IAE %.1f\n", kp, ki, kd, all[best].settling,
+            all[best].overshoot, all[best].ss_error, all[best].iae);
+  } else {
+    fprintf(stderr, "[sweep] no point settles\n");
+  }
+  result_cache_close(&s.cache);
+  track_free(track);
+  free(all);
+  free(s.buffer);
+  return 0;
+
+usage:
+  fprintf(stderr, "usage: %s [-p kp0:kp1:n] [-i ki0:ki1:n] [-d kd0:kd1:n]\n"
+          "       [-v v0] [-s setpoint] [-P periods] [-j workers] [-t track] [-C cache]\n",
+          argv[0]);
+  return 2;
+}
@@ -0,0 +1,236 @@
+/* Monte Carlo robustness runs of the cruise controller
+ *
+ * Description:
+ *
+ *   Repeats the headless cruise scenario (cruise_run.h) a large number of
+ *   times from random positions on the track, disturbed every period by
+ *
+ *     sensor noise  - the controller reads the velocity plus a normal
+ *                     error of -n m/s standard deviation, rounded
+ *     gusts         - with probability -g a headwind takes 1..-w units off
+ *                     the throttle the vehicle gets, for 1..-l periods
+ *     late throttle - the vehicle gets the throttle of 0..-D periods ago
+ *
+ *   If the velocity still falls below the 25 m/s at which control_step()
+ *   lets go, the driver resumes the setpoint as soon as it is back, so that
+ *   the errors are those of tracking under the disturbances, not of a car
+ *   left to coast; stderr tells in how many runs that happened.
+ *
+ *   The random numbers come from Philox (philox.h) keyed by the seed and
+ *   counted by run and period, so every run is the same whichever worker
+ *   simulates it. Instead of keeping traces, every worker adds the
+ *   velocity errors past the warm-up (-W periods), and the IAE and the
+ *   largest error of every run, to quantile sketches (sketch.h) that are
+ *   merged at the end: the memory does not grow with the number of runs
+ *   and the report is the same for any -j.
+ *
+ *   usage: monte-carlo [-r runs] [-P periods] [-W warmup] [-n noise] [-g gust]
+ *                      [-w wind] [-l length] [-D delay] [-k kp:ki:kd]
+ *                      [-v v0] [-s setpoint] [-S seed] [-j workers] [-t track]
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "cruise_run.h"
+#include "parallel.h"
+#include "philox.h"
+#include "sketch.h"
+#include "track_file.h"
+#include "bench.h"
+
+/* Longest throttle delay, in periods (power of two) */
+#define MC_DELAY_MAX 8
+
+struct mc {
+  struct cruise_case c;
+  double             kp, ki, kd;
+  INT32U             periods;
+  INT32U             warmup;
+  double             noise;      /* m/s */
+  uint32_t           gust;       /* probability per period, 24 bit fraction */
+  INT32U             wind;       /* largest gust, units of throttle */
+  INT32U             length;     /* longest gust, periods */
+  INT32U             delay;      /* longest throttle delay, periods */
+  uint64_t           seed;
+  struct mc_worker  *worker;
+};
+
+struct mc_worker {
+  struct sketch error;           /* |error| of every period past the warm-up, m/s */
+  struct sketch iae;             /* per run, m/s * s */
+  struct sketch peak;            /* per run, largest |error| past the warm-up */
+  uint64_t      resumed;         /* runs where the cruise control let go */
+  char          pad[64];
+};
+
+/* control_step() drops the cruise control below this velocity, m/s */
+#define MC_RESUME 25
+
+/* Run-wide draws use this period number */
+#define MC_RUN_COUNTER 0xFFFFFFFFu
+
+static void mc_run(const struct mc *mc, struct mc_worker *w, uint64_t r)
+{
+  static const struct vehicle_inputs cruising = {0, off, on};
+  struct cruise_case     c = mc->c;
+  struct cruise_run      run;
+  struct vehicle_inputs  drive = cruising;
+  struct control_outputs out;
+  INT8U                  sent[MC_DELAY_MAX];
+  uint32_t               ctr[4] = {(uint32_t) r, (uint32_t) (r >> 32), MC_RUN_COUNTER, 0};
+  uint32_t               u[4];
+  INT32U                 p, d, gust_left = 0, wind = 0, iae = 0, peak = 0, error;
+  int                    resumed = 0;
+  const struct track    *track = c.track != NULL ? c.track : track_default;
+
+  philox4x32(ctr, mc->seed, u);
+  c.position = u[0] % (track->length + 1);
+  cruise_run_init(&run, &c, mc->kp, mc->ki, mc->kd);
+
+  for (p = 0; p < mc->periods; p++) {
+    ctr[2] = p;
+    philox4x32(ctr, mc->seed, u);
+
+    /* Box-Muller */
+    run.in.velocity = run.car.velocity + (INT16S) lround(
+      mc->noise * sqrt(-2 * log(philox_unit(u[0]))) * cos(2 * M_PI * philox_unit(u[1])));
+    /* the driver resumes the setpoint as soon as the controller takes it */
+    if (run.ctrl.cruise_control != on && run.car.velocity >= MC_RESUME) {
+      run.ctrl.cruise_control  = on;
+      run.ctrl.target_velocity = c.setpoint;
+      resumed = 1;
+    }
+    control_step(&run.ctrl, &run.in, &out);
+
+    sent[p & (MC_DELAY_MAX - 1)] = out.throttle;
+    d = mc->delay ? (u[3] & 0xFF) % (mc->delay + 1) : 0;
+    drive.throttle = sent[(p - (d < p ? d : p)) & (MC_DELAY_MAX - 1)];
+
+    if (gust_left == 0 && (u[2] >> 8) < mc->gust) {
+      gust_left = 1 + (u[2] & 0xFF) % mc->length;
+      wind      = 1 + (u[3] >> 16) % mc->wind;
+    }
+    if (gust_left != 0) {
+      drive.throttle = drive.throttle > wind ? drive.throttle - wind : 0;
+      gust_left--;
+    }
+    vehicle_step(&run.car, &drive);
+
+    if (p >= mc->warmup) {
+      error = abs(c.setpoint - run.car.velocity);
+      sketch_add(&w->error, error);
+      if (error > peak)
+        peak = error;
+    }
+    iae += abs(c.setpoint - run.car.velocity);
+  }
+  sketch_add(&w->iae, iae * (CONTROL_STEP_MS / 1000.0));
+  sketch_add(&w->peak, peak);
+  w->resumed += resumed;
+}
+
+static void mc_chunk(size_t begin, size_t end, int worker, void *arg)
+{
+  struct mc *mc = arg;
+  size_t     r;
+
+  for (r = begin; r < end; r++)
+    mc_run(mc, &mc->worker[worker], r);
+}
+
+static void mc_report(const char *name, const struct sketch *s)
+{
+  printf("%-14s %10llu %8.2f %8.2f %8.2f %8.2f %8.2f %8.2f\n", name,
+         (unsigned long long) s->count, sketch_quantile(s, 0.5), sketch_quantile(s, 0.9),
+         sketch_quantile(s, 0.99), sketch_quantile(s, 0.999), sketch_quantile(s, 0.9999),
+         s->count ? s->max : 0.0);
+}
+
+int main(int argc, char **argv)
+{
+  struct mc     mc = {{30, 50, 0, NULL}, CONTROL_KP, CONTROL_KI, CONTROL_KD, 200, 20, 1.0, 0,
+                      10, 10, 2, 1, NULL};
+  struct track *track = NULL;
+  unsigned long runs = 100000;
+  double        gust = 0.02, t0, t1;
+  int           workers = 0, opt, i;
+
+  while ((opt = getopt(argc, argv, "r:P:W:n:g:w:l:D:k:v:s:S:j:t:")) != -1) {
+    switch (opt) {
+    case 'r': runs       = strtoul(optarg, NULL, 0); break;
+    case 'P': mc.periods = strtoul(optarg, NULL, 0); break;
+    case 'W': mc.warmup  = strtoul(optarg, NULL, 0); break;
+    case 'n': mc.noise   = atof(optarg); break;
+    case 'g': gust       = atof(optarg); break;
+    case 'w': mc.wind    = strtoul(optarg, NULL, 0); break;
+    case 'l': mc.length  = strtoul(optarg, NULL, 0); break;
+    case 'D': mc.delay   = strtoul(optarg, NULL, 0); break;
+    case 'k':
+      if (sscanf(optarg, "%lf:%lf:%lf", &mc.kp, &mc.ki, &mc.kd) != 3)
+        goto usage;
+      break;
+    case 'v': mc.c.v0       = (INT16S) atoi(optarg); break;
+    case 's': mc.c.setpoint = (INT16S) atoi(optarg); break;
+    case 'S': mc.seed    = strtoull(optarg, NULL, 0); break;
+    case 'j': workers    = atoi(optarg); break;
+    case 't':
+      if ((track = track_load(optarg)) == NULL)
+        return 1;
+      mc.c.track = track;
+      break;
+    default:
+      goto usage;
+    }
+  }
+  if (mc.wind == 0 || mc.length == 0 || mc.delay >= MC_DELAY_MAX || gust < 0 || gust > 1)
+    goto usage;
+  mc.gust = (uint32_t) (gust * (1 << 24));
+
+  workers   = parallel_workers(workers);
+  mc.worker = malloc(workers * sizeof(*mc.worker));
+  if (mc.worker == NULL) {
+    fprintf(stderr, "%s: out of memory\n", argv[0]);
+    return 1;
+  }
+  for (i = 0; i < workers; i++) {
+    sketch_init(&mc.worker[i].error);
+    sketch_init(&mc.worker[i].iae);
+    sketch_init(&mc.worker[i].peak);
+    mc.worker[i].resumed = 0;
+  }
+
+  t0 = bench_now();
+  if (parallel_for(runs, 64, workers, mc_chunk, &mc) < 0) {
+    fprintf(stderr, "%s: out of memory\n", argv[0]);
+    return 1;
+  }
+  for (i = 1; i < workers; i++) {
+    sketch_merge(&mc.worker[0].error, &mc.worker[i].error);
+    sketch_merge(&mc.worker[0].iae, &mc.worker[i].iae);
+    sketch_merge(&mc.worker[0].peak, &mc.worker[i].peak);
+    mc.worker[0].resumed += mc.worker[i].resumed;
+  }
+  t1 = bench_now();
+
+  printf("metric              count      p50      p90      p99    p99.9   p99.99      max\n");
+  mc_report("error_mps", &mc.worker[0].error);
+  mc_report("run_iae", &mc.worker[0].iae);
+  mc_report("run_peak_mps", &mc.worker[0].peak);
+  fprintf(stderr, "[mc] %lu runs x %u periods on %d workers: %.3f s, %.0f runs/s, "
+          "%zu bytes of sketches per worker\n", runs, mc.periods, workers, t1 - t0,
+          runs / (t1 - t0), sizeof(*mc.worker));
+  fprintf(stderr, "[mc] the cruise control let go and was resumed in %llu runs\n",
+          (unsigned long long) mc.worker[0].resumed);
+  track_free(track);
+  free(mc.worker);
+  return 0;
+
+usage:
+  fprintf(stderr, "usage: %s [-r runs] [-P periods] [-W warmup] [-n noise] [-g gust]\n"
+          "       [-w wind] [-l length] [-D delay(<%d)] [-k kp:ki:kd]\n"
+          "       [-v v0] [-s setpoint] [-S seed] [-j workers] [-t track]\n", argv[0],
+          MC_DELAY_MAX);
+  return 2;
+}
@@ -0,0 +1,213 @@
+/* Explicit MPC table of the cruise controller
+ *
+ * Description:
+ *
+ *   Solves the model predictive control problem of the cruise control
+ *   offline and writes its first moves as the C table of control.h that
+ *   ControlTask looks up instead of running the PID.
+ *
+ *   With the throttle w taken relative to WIND_FACTOR * target, the error
+ *   e = target - velocity of vehicle_step() evolves as
+ *
+ *     e' = e - trunc((w + WIND_FACTOR * e + gradient) * VEHICLE_STEP_MS / 1000)
+ *
+ *   whatever the target, truncation of the whole m/s included. The problem
+ *   is to choose the throttles of the next -N periods that minimize
+ *
+ *     sum of q * e'^2 + r * (w - w_previous)^2
+ *
+ *   with the throttle changing by at most -S per period and staying within
+ *   the throttle axis. States and inputs being integers, it is solved
+ *   exactly by dynamic programming: the cost-to-go of every error in
+ *   +-MPC_ERROR, previous throttle and segment of the lab track is computed
+ *   one period at a time back from the end of the horizon, every period on
+ *   all CPUs over the (segment, error) rows, and the best move of the first
+ *   period is the table entry. The errors beyond the table axis only serve
+ *   to predict large excursions correctly.
+ *
+ *   The table goes to stdout or -o, ready for model/control_mpc_lab.c;
+ *   the time the solution took goes to stderr.
+ *
+ *   usage: mpc-table [-N periods] [-q weight] [-r weight] [-S slew] [-j workers]
+ *                    [-o file]
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "control.h"
+#include "parallel.h"
+#include "bench.h"
+
+/* Errors the prediction tracks, m/s; beyond them they are clamped */
+#define MPC_ERROR    60
+#define MPC_ERRORS   (2 * MPC_ERROR + 1)
+#define MPC_THROTTLE CONTROL_MPC_THROTTLE
+#define MPC_INPUTS   (2 * MPC_THROTTLE + 1)
+
+struct mpc {
+  int      horizon;                  /* periods */
+  double   q;
+  double   r;
+  int      slew;                     /* throttle units per period */
+  INT32U   segments;
+  double  *next;                     /* cost-to-go after this period, [segment][e][w] */
+  double  *cost;                     /* from this period on */
+  int8_t  *move;                     /* best throttle of this period, [segment][e][w] */
+};
+
+static size_t mpc_index(INT32U segment, int e, int w)
+{
+  return ((size_t) segment * MPC_ERRORS + (size_t) (e + MPC_ERROR)) * MPC_INPUTS +
+         (size_t) (w + MPC_THROTTLE);
+}
+
+/* Error after a period with throttle w on this gradient, as vehicle_step() has it */
+static int mpc_error(int e, int w, int gradient)
+{
+  int    acceleration = w + WIND_FACTOR * e + gradient;
+  double dv = acceleration * VEHICLE_STEP_MS / 1000.0;
+  int    next = e - (int) dv;
+
+  /* the velocity truncates toward zero, for a moving car that is down */
+  if (dv < 0 && dv != (int) dv)
+    next++;
+  return next < -MPC_ERROR ? -MPC_ERROR : next > MPC_ERROR ? MPC_ERROR : next;
+}
+
+/* One period for the rows [begin, end) of (segment, error) */
+static void mpc_rows(size_t begin, size_t end, int worker, void *arg)
+{
+  struct mpc *m = arg;
+  size_t      row;
+  INT32U      s;
+  double      best, c;
+  int         e, prev, w, lo, hi, next, gradient, bw;
+
+  for (row = begin; row < end; row++) {
+    s        = (INT32U) (row / MPC_ERRORS);
+    e        = (int) (row % MPC_ERRORS) - MPC_ERROR;
+    gradient = track_lab.segment[s].gradient;
+    for (prev = -MPC_THROTTLE; prev <= MPC_THROTTLE; prev++) {
+      lo = prev - m->slew < -MPC_THROTTLE ? -MPC_THROTTLE : prev - m->slew;
+      hi = prev + m->slew > MPC_THROTTLE ? MPC_THROTTLE : prev + m->slew;
+      best = 0;
+      bw   = prev;
+      /* ties go to the smallest change */
+      for (w = lo; w <= hi; w++) {
+        next = mpc_error(e, w, gradient);
+        c = m->q * next * next + m->r * (w - prev) * (w - prev) + m->next[mpc_index(s, next, w)];
+        if (w == lo || c < best || (c == best && abs(w - prev) < abs(bw - prev))) {
+          best = c;
+          bw   = w;
+        }
+      }
+      m->cost[mpc_index(s, e, prev)] = best;
+      m->move[mpc_index(s, e, prev)] = (int8_t) bw;
+    }
+  }
+}
+
+static void mpc_print(FILE *f, const struct mpc *m)
+{
+  INT32U s;
+  int    e, c, w;
+
+  fprintf(f, "/* Explicit MPC table of the lab track, see control.h\n"
+             " *\n"
+             " * Written by host/build/bin/mpc-table -N %d -q %g -r %g -S %d, do not\n"
+             " * edit: %u segments x %d errors x %d throttle columns.\n"
+             " */\n"
+             "#include \"control.h\"\n\n"
+             "#if CONTROL_MPC_ERROR != %d || CONTROL_MPC_THROTTLE != %d || CONTROL_MPC_SHIFT != %d\n"
+             "#error \"control.h changed the axes, run mpc-table again\"\n"
+             "#endif\n\n"
+             "static const int8_t control_mpc_lab_throttle[] = {\n",
+          m->horizon, m->q, m->r, m->slew, (unsigned) m->segments, CONTROL_MPC_ROWS,
+          CONTROL_MPC_COLUMNS, CONTROL_MPC_ERROR, CONTROL_MPC_THROTTLE, CONTROL_MPC_SHIFT);
+  for (s = 0; s < m->segments; s++) {
+    fprintf(f, "  /* segment %u, gradient %d */\n", (unsigned) s,
+            track_lab.segment[s].gradient);
+    for (e = -CONTROL_MPC_ERROR; e <= CONTROL_MPC_ERROR; e++) {
+      fprintf(f, "  ");
+      for (c = 0; c < CONTROL_MPC_COLUMNS; c++) {
+        w = (c < CONTROL_MPC_COLUMNS - 1 ? c : c - 1) << CONTROL_MPC_SHIFT;
+        fprintf(f, "%d,%s", m->move[mpc_index(s, e, w - MPC_THROTTLE)],
+                c < CONTROL_MPC_COLUMNS - 1 ? " " : "\n");
+      }
+    }
+  }
+  fprintf(f, "};\n\n"
+             "const struct control_mpc control_mpc_lab = {&track_lab, control_mpc_lab_throttle};\n");
+}
+
+int main(int argc, char **argv)
+{
+  struct mpc m = {20, 1.0, 0.05, 8, 0, NULL, NULL, NULL};
+  const char *out = NULL;
+  FILE       *f = stdout;
+  double     *swap, t0, t1;
+  size_t      states;
+  int         workers = 0, opt, k;
+
+  while ((opt = getopt(argc, argv, "N:q:r:S:j:o:")) != -1) {
+    switch (opt) {
+    case 'N': m.horizon = atoi(optarg); break;
+    case 'q': m.q       = atof(optarg); break;
+    case 'r': m.r       = atof(optarg); break;
+    case 'S': m.slew    = atoi(optarg); break;
+    case 'j': workers   = atoi(optarg); break;
+    case 'o': out       = optarg; break;
+    default:
+      goto usage;
+    }
+  }
+  if (optind != argc || m.horizon < 1 || m.q < 0 || m.r < 0 || m.slew < 1)
+    goto usage;
+  workers    = parallel_workers(workers);
+  m.segments = track_lab.segments;
+  states     = (size_t) m.segments * MPC_ERRORS * MPC_INPUTS;
+  m.next     = calloc(states, sizeof(*m.next));
+  m.cost     = calloc(states, sizeof(*m.cost));
+  m.move     = calloc(states, sizeof(*m.move));
+  if (m.next == NULL || m.cost == NULL || m.move == NULL) {
+    fprintf(stderr, "%s: out of memory\n", argv[0]);
+    return 1;
+  }
+
+  /* nothing is left to pay past the horizon */
+  t0 = bench_now();
+  for (k = m.horizon - 1; k >= 0; k--) {
+    if (parallel_for((size_t) m.segments * MPC_ERRORS, 4, workers, mpc_rows, &m) < 0) {
+      fprintf(stderr, "%s: out of memory\n", argv[0]);
+      return 1;
+    }
+    swap   = m.next;
+    m.next = m.cost;
+    m.cost = swap;
+  }
+  t1 = bench_now();
+
+  if (out != NULL && (f = fopen(out, "w")) == NULL) {
+    perror(out);
+    return 1;
+  }
+  mpc_print(f, &m);
+  if (f != stdout && fclose(f) != 0) {
+    perror(out);
+    return 1;
+  }
+  fprintf(stderr, "[mpc] %zu states x %d periods on %d workers: %.3f s; table of %d bytes\n",
+          states, m.horizon, workers, t1 - t0,
+          (int) (m.segments * CONTROL_MPC_ROWS * CONTROL_MPC_COLUMNS));
+  free(m.next);
+  free(m.cost);
+  free(m.move);
+  return 0;
+
+usage:
+  fprintf(stderr, "usage: %s [-N periods] [-q weight] [-r weight] [-S slew] [-j workers] "
+          "[-o file]\n", argv[0]);
+  return 2;
+}
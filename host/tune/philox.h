@@ -0,0 +1,45 @@
+/* Counter-based random numbers
+ *
+ * Description:
+ *
+ *   Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as
+ *   1, 2, 3", SC 2011): a keyed bijection of a 128 bit counter. The random
+ *   numbers of a simulation are a pure function of (seed, run, period, ...),
+ *   so every run draws the same numbers whichever thread runs it and in
+ *   whatever order, and nothing has to be stored or skipped ahead.
+ */
+#ifndef PHILOX_H
+#define PHILOX_H
+
+#include <stdint.h>
+
+static inline void philox4x32(const uint32_t ctr[4], uint64_t seed, uint32_t out[4])
+{
+  uint32_t k0 = (uint32_t) seed, k1 = (uint32_t) (seed >> 32);
+  uint32_t x0 = ctr[0], x1 = ctr[1], x2 = ctr[2], x3 = ctr[3];
+  uint64_t p0, p1;
+  int      round;
+
+  for (round = 0; round < 10; round++) {
+    p0 = (uint64_t) 0xD2511F53u * x0;
+    p1 = (uint64_t) 0xCD9E8D57u * x2;
+    x0 = (uint32_t) (p1 >> 32) ^ x1 ^ k0;
+    x2 = (uint32_t) (p0 >> 32) ^ x3 ^ k1;
+    x1 = (uint32_t) p1;
+    x3 = (uint32_t) p0;
+    k0 += 0x9E3779B9u;
+    k1 += 0xBB67AE85u;
+  }
+  out[0] = x0;
+  out[1] = x1;
+  out[2] = x2;
+  out[3] = x3;
+}
+
+/* Uniform in (0, 1], never 0 so that it can go through log() */
+static inline double philox_unit(uint32_t x)
+{
+  return (x + 1.0) * 0x1.0p-32;
+}
+
+#endif /* PHILOX_H */
@@ -0,0 +1,236 @@
+/* On-disk cache of simulation results, see result_cache.h */
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "result_cache.h"
+
+/* Checksum of the sources in ../model and of cruise_run.[ch], passed by the Makefile */
+#ifndef RESULT_CACHE_MODEL
+#define RESULT_CACHE_MODEL 0
+#endif
+
+#define RESULT_CACHE_MAGIC 0x31524352u /* "RCR1" */
+#define RESULT_CACHE_PATH  512
+#define RESULT_CACHE_VALUE 256         /* largest record */
+
+/* The entries of the log start on 8 byte boundaries */
+#define RESULT_CACHE_ALIGN(size) (((size) + 7) & ~(size_t) 7)
+
+struct result_entry {
+  uint32_t          magic;
+  uint32_t          size;
+  struct result_key key;
+};
+
+static uint64_t result_mix(uint64_t z)
+{
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  return z ^ (z >> 31);
+}
+
+/* Two independent 64 bit lanes, FNV-1a and a splitmix sponge */
+void result_key_add(struct result_key *k, const void *data, size_t size)
+{
+  const unsigned char *p = data;
+  size_t               i;
+
+  for (i = 0; i < size; i++) {
+    k->h[0] = (k->h[0] ^ p[i]) * 0x100000001B3ull;
+    k->h[1] = result_mix(k->h[1] + p[i] + 0x9E3779B97F4A7C15ull);
+  }
+  k->h[1] = result_mix(k->h[1] ^ size);
+}
+
+void result_key_int(struct result_key *k, int64_t value)
+{
+  result_key_add(k, &value, sizeof(value));
+}
+
+void result_key_double(struct result_key *k, double value)
+{
+  /* -0.0 and 0.0 give the same run */
+  if (value == 0)
+    value = 0;
+  result_key_add(k, &value, sizeof(value));
+}
+
+void result_key_init(struct result_key *k, const char *tool)
+{
+  k->h[0] = 0xCBF29CE484222325ull;
+  k->h[1] = 0;
+  result_key_add(k, tool, strlen(tool));
+  result_key_int(k, RESULT_CACHE_VERSION);
+  result_key_int(k, (int64_t) RESULT_CACHE_MODEL);
+
+  /* controller */
+  result_key_int(k, CONTROL_STEP_MS);
+  result_key_int(k, PID_FX_Q);
+  result_key_int(k, STATIONARY_THROTTLE);
+  result_key_int(k, MAXIMUM_TARGET_VELOCITY);
+  result_key_int(k, CONTROL_BUILD_FLAGS);
+
+  /* vehicle */
+  result_key_int(k, VEHICLE_STEP_MS);
+  result_key_int(k, MAX_THROTTLE);
+  result_key_int(k, WIND_FACTOR);
+  result_key_int(k, BRAKE_FACTOR);
+  result_key_int(k, GRAVITY_FACTOR);
+  result_key_int(k, VEHICLE_BUILD_FLAGS);
+
+  /* metrics */
+  result_key_double(k, CRUISE_BAND);
+  result_key_int(k, CRUISE_SS_PERIODS);
+}
+
+void result_key_track(struct result_key *k, const struct track *track)
+{
+  INT32U i;
+
+  result_key_int(k, track->length);
+  result_key_int(k, track->segments);
+  for (i = 0; i < track->segments; i++) {
+    result_key_int(k, track->segment[i].start);
+    result_key_int(k, track->segment[i].gradient);
+  }
+}
+
+void result_key_cruise(struct result_key *k, const struct cruise_case *c, double kp, double ki,
+                       double kd, INT32U periods)
+{
+  result_key_double(k, kp);
+  result_key_double(k, ki);
+  result_key_double(k, kd);
+  result_key_int(k, c->v0);
+  result_key_int(k, c->setpoint);
+  result_key_int(k, c->position);
+  result_key_track(k, c->track != NULL ? c->track : track_default);
+  result_key_int(k, periods);
+}
+
+/*
+ * Indexes the entries of the log read into cache->data. A write torn by a
+ * killed run is skipped: the entries are moved down over it, so that they
+ * stay aligned, and indexed from where the next one starts.
+ */
+static int result_cache_index(struct result_cache *cache, size_t bytes)
+{
+  const struct result_entry *e;
+  struct result_entry        head;
+  size_t at = 0, end = 0, n = 0, size, slot;
+
+  while (at + sizeof(head) <= bytes) {
+    memcpy(&head, cache->data + at, sizeof(head));
+    size = sizeof(head) + RESULT_CACHE_ALIGN(head.size);
+    if (head.magic != RESULT_CACHE_MAGIC || head.size > RESULT_CACHE_VALUE ||
+        at + size > bytes) {
+      at++;
+      continue;
+    }
+    memmove(cache->data + end, cache->data + at, size);
+    at  += size;
+    end += size;
+    n++;
+  }
+  for (cache->mask = 15; cache->mask < 2 * n; cache->mask = cache->mask * 2 + 1)
+    ;
+  cache->slot = calloc(cache->mask + 1, sizeof(*cache->slot));
+  if (cache->slot == NULL)
+    return -1;
+  for (at = 0; at < end; at += sizeof(*e) + RESULT_CACHE_ALIGN(e->size)) {
+    e = (const struct result_entry *) (cache->data + at);
+    for (slot = e->key.h[0] & cache->mask; cache->slot[slot] != NULL;
+         slot = (slot + 1) & cache->mask)
+      ;
+    cache->slot[slot] = e;
+  }
+  return 0;
+}
+
+int result_cache_open(struct result_cache *cache, const char *dir)
+{
+  char        path[RESULT_CACHE_PATH];
+  struct stat st;
+  FILE       *f;
+
+  memset(cache, 0, sizeof(*cache));
+  cache->fd  = -1;
+  cache->dir = dir != NULL ? dir : getenv("CRUISE_RESULT_CACHE");
+  if (cache->dir == NULL || cache->dir[0] == '\0') {
+    cache->dir = NULL;
+    return 0;
+  }
+  if (mkdir(cache->dir, 0777) < 0 && errno != EEXIST) {
+    fprintf(stderr, "%s: %s\n", cache->dir, strerror(errno));
+    return -1;
+  }
+  snprintf(path, sizeof(path), "%s/results", cache->dir);
+  if ((cache->fd = open(path, O_RDWR | O_APPEND | O_CREAT, 0666)) < 0 ||
+      fstat(cache->fd, &st) < 0 || (f = fdopen(dup(cache->fd), "rb")) == NULL) {
+    fprintf(stderr, "%s: %s\n", path, strerror(errno));
+    return -1;
+  }
+  cache->data = malloc(st.st_size ? (size_t) st.st_size : 1);
+  if (cache->data == NULL || fread(cache->data, 1, st.st_size, f) != (size_t) st.st_size ||
+      result_cache_index(cache, st.st_size) < 0) {
+    fprintf(stderr, "%s: cannot be read\n", path);
+    fclose(f);
+    return -1;
+  }
+  fclose(f);
+  return 0;
+}
+
+void result_cache_close(struct result_cache *cache)
+{
+  if (cache->fd >= 0)
+    close(cache->fd);
+  free(cache->slot);
+  free(cache->data);
+}
+
+int result_cache_get(struct result_cache *cache, const struct result_key *k, void *value,
+                     size_t size)
+{
+  const struct result_entry *e;
+  size_t slot;
+
+  if (cache->dir == NULL)
+    return -1;
+  for (slot = k->h[0] & cache->mask; (e = cache->slot[slot]) != NULL;
+       slot = (slot + 1) & cache->mask) {
+    if (e->key.h[0] != k->h[0] || e->key.h[1] != k->h[1] || e->size != size)
+      continue;
+    memcpy(value, e + 1, size);
+    __atomic_fetch_add(&cache->hits, 1, __ATOMIC_RELAXED);
+    return 0;
+  }
+  __atomic_fetch_add(&cache->misses, 1, __ATOMIC_RELAXED);
+  return -1;
+}
+
+int result_cache_put(struct result_cache *cache, const struct result_key *k, const void *value,
+                     size_t size)
+{
+  struct {
+    struct result_entry e;
+    unsigned char       value[RESULT_CACHE_VALUE];
+  } buf;
+
+  if (cache->dir == NULL || size > RESULT_CACHE_VALUE)
+    return -1;
+  memset(&buf, 0, sizeof(buf.e) + RESULT_CACHE_ALIGN(size));
+  buf.e.magic = RESULT_CACHE_MAGIC;
+  buf.e.size  = (uint32_t) size;
+  buf.e.key   = *k;
+  memcpy(buf.value, value, size);
+
+  /* one write(), appended whole even with other writers */
+  size = sizeof(buf.e) + RESULT_CACHE_ALIGN(size);
+  return write(cache->fd, &buf, size) == (ssize_t) size ? 0 : -1;
+}
@@ -0,0 +1,81 @@
+/* On-disk cache of simulation results
+ *
+ * Description:
+ *
+ *   Content-addressed store of the metric records of the sweep tools, so
+ *   that a point whose inputs did not change is read back instead of
+ *   simulated again. The key is a 128 bit hash of everything the result
+ *   depends on: the controller constants and gains, the vehicle constants
+ *   (WIND_FACTOR, BRAKE_FACTOR, GRAVITY_FACTOR, the step), the build
+ *   options of both (CONTROL_BUILD_FLAGS, VEHICLE_BUILD_FLAGS), a checksum
+ *   the build computes of the model/ sources and of cruise_run.[ch], which
+ *   defines the metrics (CRUISE_BAND, CRUISE_SS_PERIODS, settling, IAE,
+ *   ...), the track table and the scenario. The code of the tools around
+ *   these is not covered: a tool that changes what it simulates (its
+ *   disturbances, say) puts that in its keys itself.
+ *
+ *   The records are appended to one log, dir/results, each behind its key
+ *   and size in a single write() to the file opened O_APPEND, so that
+ *   threads and processes may fill the same cache at once. Opening the
+ *   cache reads the log into memory and indexes it in a hash table, which
+ *   stays as it is: lookups need no locking, and the records a run adds
+ *   are found by the next one. A torn entry at the end of the log, from a
+ *   run that was killed, ends the index there.
+ *
+ *   The cache is used when a directory is given (-C) or CRUISE_RESULT_CACHE
+ *   is set.
+ */
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cruise_run.h"
+
+/* Bumped when a record or the meaning of a key changes */
+#define RESULT_CACHE_VERSION 2
+
+struct result_key {
+  uint64_t h[2];
+};
+
+struct result_entry;
+
+struct result_cache {
+  const char                 *dir;     /* NULL: no cache */
+  int                         fd;      /* of the log */
+  char                       *data;    /* the log as read at open */
+  const struct result_entry **slot;    /* open addressing by key.h[0] */
+  size_t                      mask;    /* slots - 1 */
+  uint64_t                    hits;
+  uint64_t                    misses;
+};
+
+/* Starts a key for the records of 'tool', from the controller and vehicle
+   constants and the model sources */
+void result_key_init(struct result_key *k, const char *tool);
+void result_key_add(struct result_key *k, const void *data, size_t size);
+void result_key_int(struct result_key *k, int64_t value);
+void result_key_double(struct result_key *k, double value);
+void result_key_track(struct result_key *k, const struct track *track);
+
+/* The gains, the case and its track, and the periods of a cruise run */
+void result_key_cruise(struct result_key *k, const struct cruise_case *c, double kp, double ki,
+                       double kd, INT32U periods);
+
+/* 'dir', or CRUISE_RESULT_CACHE if NULL; returns 0, -1 after printing why
+   the directory cannot be used */
+int  result_cache_open(struct result_cache *cache, const char *dir);
+void result_cache_close(struct result_cache *cache);
+
+/* Returns 0 and fills 'value' if the key is cached, -1 otherwise */
+int  result_cache_get(struct result_cache *cache, const struct result_key *k, void *value,
+                      size_t size);
+
+/* Appends a record of at most 256 bytes; returns 0, -1 if it could not be
+   written (then the next run simulates it again) */
+int  result_cache_put(struct result_cache *cache, const struct result_key *k, const void *value,
+                      size_t size);
+
+#endif /* RESULT_CACHE_H */
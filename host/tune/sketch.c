@@ -0,0 +1,72 @@
+/* Mergeable quantile sketch, see sketch.h */
+#include <math.h>
+#include <string.h>
+
+#include "sketch.h"
+
+/* Bucket i holds (SKETCH_MIN * gamma^(i-1), SKETCH_MIN * gamma^i] */
+#define SKETCH_GAMMA ((1 + SKETCH_ALPHA) / (1 - SKETCH_ALPHA))
+
+void sketch_init(struct sketch *s)
+{
+  memset(s, 0, sizeof(*s));
+  s->min = INFINITY;
+  s->max = -INFINITY;
+}
+
+void sketch_add(struct sketch *s, double value)
+{
+  double i;
+
+  s->count++;
+  if (value < s->min)
+    s->min = value;
+  if (value > s->max)
+    s->max = value;
+  if (value < SKETCH_MIN) {
+    s->zero++;
+    return;
+  }
+  i = ceil(log(value / SKETCH_MIN) / log(SKETCH_GAMMA));
+  s->bin[i < SKETCH_BINS - 1 ? (int) i : SKETCH_BINS - 1]++;
+}
+
+void sketch_merge(struct sketch *to, const struct sketch *from)
+{
+  int i;
+
+  to->count += from->count;
+  to->zero  += from->zero;
+  for (i = 0; i < SKETCH_BINS; i++)
+    to->bin[i] += from->bin[i];
+  if (from->min < to->min)
+    to->min = from->min;
+  if (from->max > to->max)
+    to->max = from->max;
+}
+
+double sketch_quantile(const struct sketch *s, double q)
+{
+  uint64_t rank, seen;
+  double   value;
+  int      i;
+
+  if (s->count == 0)
+    return 0;
+  if (q <= 0)
+    return s->min;
+  if (q >= 1)
+    return s->max;
+  rank = (uint64_t) (q * (s->count - 1));
+  seen = s->zero;
+  if (rank < seen)
+    return s->min < 0 ? s->min : 0;
+  for (i = 0; i < SKETCH_BINS; i++) {
+    seen += s->bin[i];
+    if (rank < seen)
+      break;
+  }
+  /* Middle of the bucket in relative terms, clamped to what was seen */
+  value = SKETCH_MIN * pow(SKETCH_GAMMA, i) * 2 / (1 + SKETCH_GAMMA);
+  return value < s->min ? s->min : value > s->max ? s->max : value;
+}
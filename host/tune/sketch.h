@@ -0,0 +1,40 @@
+/* Mergeable quantile sketch
+ *
+ * Description:
+ *
+ *   A histogram with logarithmic buckets (like DDSketch, Masson et al.,
+ *   VLDB 2019): any quantile of the values added comes back within a
+ *   relative error of SKETCH_ALPHA, whatever their number, in a fixed
+ *   amount of memory. Two sketches merge by adding their buckets, and
+ *   since the counts are integers the merged sketch does not depend on
+ *   how the values were split up, which is what lets every worker of a
+ *   parallel run keep its own.
+ *
+ *   Values below SKETCH_MIN count as zero, values past the last bucket
+ *   (about 9e6 * SKETCH_MIN) in the last bucket.
+ */
+#ifndef SKETCH_H
+#define SKETCH_H
+
+#include <stdint.h>
+
+#define SKETCH_ALPHA 0.01
+#define SKETCH_MIN   0.01
+#define SKETCH_BINS  800
+
+struct sketch {
+  uint64_t count;
+  uint64_t zero;                  /* values below SKETCH_MIN */
+  uint64_t bin[SKETCH_BINS];
+  double   min;
+  double   max;
+};
+
+void   sketch_init(struct sketch *s);
+void   sketch_add(struct sketch *s, double value);
+void   sketch_merge(struct sketch *to, const struct sketch *from);
+
+/* Value at quantile q (0..1), 0 for an empty sketch */
+double sketch_quantile(const struct sketch *s, double q);
+
+#endif /* SKETCH_H */
@@ -0,0 +1,391 @@
+/* Sharded multi-process sweep of the cruise controller gains
+ *
+ * Description:
+ *
+ *   Runs the headless cruise scenario (cruise_run.h) for every gain point
+ *   of a kp x ki x kd grid, in every scenario of a fixed set and under -n
+ *   disturbance seeds, like gain-sweep but in worker processes instead of
+ *   threads: a worker that crashes or runs out of memory (-m limits each
+ *   one) loses its shard and nothing else.
+ *
+ *   The runs are numbered (point, scenario, seed) and cut into shards of
+ *   -z runs. Everything lives in one MAP_SHARED region made before the
+ *   fork: a state word per shard, which the workers claim with a
+ *   compare-and-swap that writes their pid along, and one fixed-size
+ *   record per run, written by the worker in place. When a worker dies, the launcher puts the shard it
+ *   was running back (at most -R times, then the shard is given up) and
+ *   starts another worker. At the end the launcher aggregates the records
+ *   where they are, one CSV line per gain point over the runs that
+ *   finished; the summary and the lost shards go to stderr.
+ *
+ *   A seed disturbs the run with gusts: every period a gust doubles the
+ *   wind factor with probability 1/32, for 1..8 periods, except in the
+ *   last 100 periods (Philox, philox.h, counted by seed and period), so
+ *   every run is the same in whatever worker and shard it ends up. A gust
+ *   can still take a car cruising at 30 m/s below the 25 m/s at which
+ *   control_step() lets go; the driver then resumes the setpoint as soon
+ *   as the velocity is back. With a result cache (-C, result_cache.h) the
+ *   runs simulated before are read back.
+ *
+ *   The IAE of a point thus measures how well its gains reject the gusts
+ *   on top of the step of the scenario, and settled counts the runs back
+ *   within the band after the last gust, when the steady-state error is
+ *   measured as well.
+ *
+ *   usage: sweep-shard [-p kp0:kp1:n] [-i ki0:ki1:n] [-d kd0:kd1:n] [-n seeds]
+ *                      [-P periods] [-j workers] [-z shard] [-R retries] [-m MB]
+ *                      [-t track] [-C cache]
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "cruise_run.h"
+#include "parallel.h"
+#include "philox.h"
+#include "result_cache.h"
+#include "track_file.h"
+#include "bench.h"
+
+enum shard_state {
+  SHARD_PENDING,
+  SHARD_RUNNING,
+  SHARD_DONE,
+  SHARD_FAILED                       /* crashed more than -R times */
+};
+
+/* A running shard has the pid of its worker in the upper half of the
+   state word, so that a claim leaves no moment where it has none */
+#define SHARD_CLAIM(pid) ((uint64_t) (uint32_t) (pid) << 32 | SHARD_RUNNING)
+
+struct shard {
+  uint64_t state;                    /* enum shard_state, or SHARD_CLAIM() */
+  uint32_t attempts;                 /* crashes, counted by the launcher */
+};
+
+/* The result of a run, where the launcher reads it */
+struct shard_record {
+  float    settling;                 /* s, negative if not settled */
+  float    overshoot;                /* m/s */
+  float    ss_error;                 /* m/s */
+  float    iae;                      /* m/s * s */
+  float    effort;                   /* mean throttle */
+  uint32_t done;                     /* 1, 2 if read from the cache */
+};
+
+struct shard_axis {
+  double lo;
+  double hi;
+  size_t n;
+};
+
+struct shard_sweep {
+  struct shard_axis    kp, ki, kd;
+  size_t               seeds;
+  INT32U               periods;
+  size_t               runs;
+  size_t               size;         /* runs per shard */
+  size_t               shards;
+  struct shard        *shard;        /* shared */
+  struct shard_record *record;       /* shared */
+  struct result_cache  cache;
+  struct result_key    key;          /* of the tool, the run is added */
+};
+
+/* The scenarios of every gain point, above the 25 m/s where cruise drops out */
+static const struct cruise_case shard_cases[] = {
+  {30, 50,    0, NULL},              /* accelerate */
+  {50, 30,    0, NULL},              /* slow down */
+  {40, 40,  400, NULL},              /* hold it up the hills */
+  {40, 40, 1600, NULL},              /* and down */
+};
+
+#define SHARD_CASES (sizeof(shard_cases) / sizeof(shard_cases[0]))
+
+static double shard_value(const struct shard_axis *a, size_t i)
+{
+  return a->n > 1 ? a->lo + (a->hi - a->lo) * i / (a->n - 1) : a->lo;
+}
+
+static void shard_gains(const struct shard_sweep *s, size_t point, double *kp, double *ki,
+                        double *kd)
+{
+  *kd = shard_value(&s->kd, point % s->kd.n);
+  point /= s->kd.n;
+  *ki = shard_value(&s->ki, point % s->ki.n);
+  *kp = shard_value(&s->kp, point / s->ki.n);
+}
+
+/* Gusts: probability 1 / (SHARD_GUST_ODDS), longest, strongest; none in
+   the last SHARD_GUST_QUIET periods */
+#define SHARD_GUST_ODDS   32
+#define SHARD_GUST_LENGTH 8
+#define SHARD_GUST_WIND   1
+#define SHARD_GUST_QUIET  100
+#define SHARD_GUST_KEY    0x5EED
+
+/* control_step() drops the cruise control below this velocity, m/s */
+#define SHARD_RESUME      25
+
+/* Run i is seed i % seeds of scenario i / seeds % cases of point i / seeds / cases */
+static void shard_run(struct shard_sweep *s, size_t i, struct shard_record *r)
+{
+  size_t                seed = i % s->seeds;
+  size_t                c    = i / s->seeds % SHARD_CASES;
+  struct cruise_run     run;
+  struct cruise_metrics m;
+  struct result_key     key = s->key;
+  uint32_t              ctr[4] = {(uint32_t) seed, 0, 0, 0}, u[4];
+  double                kp, ki, kd;
+  INT32U                p, gust = 0;
+
+  shard_gains(s, i / s->seeds / SHARD_CASES, &kp, &ki, &kd);
+  result_key_cruise(&key, &shard_cases[c], kp, ki, kd, s->periods);
+  result_key_int(&key, seed);
+  if (result_cache_get(&s->cache, &key, r, sizeof(*r)) == 0) {
+    __atomic_store_n(&r->done, 2, __ATOMIC_RELEASE);
+    return;
+  }
+  cruise_run_init(&run, &shard_cases[c], kp, ki, kd);
+  for (p = 0; p < s->periods; p++) {
+    ctr[1] = p;
+    philox4x32(ctr, SHARD_GUST_KEY, u);
+    if (gust == 0 && u[0] % SHARD_GUST_ODDS == 0 && p + SHARD_GUST_QUIET < s->periods) {
+      gust = 1 + u[1] % SHARD_GUST_LENGTH;
+      run.car.wind_factor = WIND_FACTOR + 1 + u[2] % SHARD_GUST_WIND;
+    }
+    /* the driver resumes the setpoint as soon as the controller takes it */
+    if (run.ctrl.cruise_control != on && run.car.velocity >= SHARD_RESUME) {
+      run.ctrl.cruise_control  = on;
+      run.ctrl.target_velocity = run.setpoint;
+    }
+    cruise_run_step(&run, 1, 0);
+    if (gust != 0 && --gust == 0)
+      run.car.wind_factor = WIND_FACTOR;
+  }
+  cruise_run_metrics(&run, &m);
+  r->settling  = (float) m.settling;
+  r->overshoot = (float) m.overshoot;
+  r->ss_error  = (float) m.ss_error;
+  r->iae       = (float) m.iae;
+  r->effort    = (float) m.effort;
+  r->done      = 0;
+  result_cache_put(&s->cache, &key, r, sizeof(*r));
+  __atomic_store_n(&r->done, 1, __ATOMIC_RELEASE);
+}
+
+/* A worker process: claims pending shards until there are none */
+static void shard_worker(struct shard_sweep *s)
+{
+  uint64_t pending, claim = SHARD_CLAIM(getpid());
+  size_t   k, i, end;
+
+  for (k = 0; k < s->shards; k++) {
+    pending = SHARD_PENDING;
+    if (!__atomic_compare_exchange_n(&s->shard[k].state, &pending, claim, 0,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+      continue;
+    end = (k + 1) * s->size < s->runs ? (k + 1) * s->size : s->runs;
+    for (i = k * s->size; i < end; i++)
+      shard_run(s, i, &s->record[i]);
+    __atomic_store_n(&s->shard[k].state, SHARD_DONE, __ATOMIC_RELEASE);
+  }
+}
+
+static pid_t shard_spawn(struct shard_sweep *s, rlim_t limit)
+{
+  struct rlimit rl = {limit, limit};
+  pid_t         pid;
+
+  fflush(stdout);
+  if ((pid = fork()) != 0)
+    return pid;
+  if (limit != 0 && setrlimit(RLIMIT_AS, &rl) < 0)
+    _exit(1);
+  shard_worker(s);
+  _exit(0);
+}
+
+/* Puts the shards of a dead worker back, or gives them up; returns how many */
+static size_t shard_recover(struct shard_sweep *s, pid_t pid, uint32_t retries)
+{
+  size_t k, lost = 0;
+
+  for (k = 0; k < s->shards; k++) {
+    if (s->shard[k].state != SHARD_CLAIM(pid))
+      continue;
+    s->shard[k].state = ++s->shard[k].attempts > retries ? SHARD_FAILED : SHARD_PENDING;
+    lost++;
+  }
+  return lost;
+}
+
+static int shard_pending(const struct shard_sweep *s)
+{
+  size_t k;
+
+  for (k = 0; k < s->shards; k++)
+    if (s->shard[k].state == SHARD_PENDING)
+      return 1;
+  return 0;
+}
+
+static int shard_axis_arg(struct shard_axis *a, const char *arg)
+{
+  return sscanf(arg, "%lf:%lf:%zu", &a->lo, &a->hi, &a->n) == 3 && a->n > 0 ? 0 : -1;
+}
+
+int main(int argc, char **argv)
+{
+  struct shard_sweep s = {{0, 2, 20}, {0, 1, 20}, {0, 1, 5}, 8, 400, 0, 256, 0, NULL, NULL,
+                        {NULL, -1, NULL, NULL, 0, 0, 0}, {{0, 0}}};
+  struct track      *track = NULL;
+  size_t  points, point, i, bytes, failed = 0, interrupted = 0, best = SIZE_MAX;
+  size_t  runs, settled, best_settled = 0, cached = 0;
+  const char *cache = NULL;
+  double  t0, t1, kp, ki, kd, iae, worst, best_iae = 0, overshoot, ss_error;
+  rlim_t  limit = 0;
+  uint32_t retries = 1;
+  unsigned crashes = 0;
+  pid_t   pid;
+  void   *shared;
+  int     opt, workers = 0, live = 0, status;
+
+  while ((opt = getopt(argc, argv, "p:i:d:n:P:j:z:R:m:t:C:")) != -1) {
+    switch (opt) {
+    case 'p': if (shard_axis_arg(&s.kp, optarg) < 0) goto usage; break;
+    case 'i': if (shard_axis_arg(&s.ki, optarg) < 0) goto usage; break;
+    case 'd': if (shard_axis_arg(&s.kd, optarg) < 0) goto usage; break;
+    case 'n': s.seeds   = strtoull(optarg, NULL, 0); break;
+    case 'P': s.periods = strtoul(optarg, NULL, 0); break;
+    case 'j': workers   = atoi(optarg); break;
+    case 'z': s.size    = strtoull(optarg, NULL, 0); break;
+    case 'R': retries   = strtoul(optarg, NULL, 0); break;
+    case 'm': limit     = (rlim_t) strtoull(optarg, NULL, 0) << 20; break;
+    case 't':
+      if ((track = track_load(optarg)) == NULL)
+        return 1;
+      track_default = track;
+      break;
+    case 'C': cache = optarg; break;
+    default:
+      goto usage;
+    }
+  }
+  if (s.seeds < 1 || s.size < 1)
+    goto usage;
+  if (result_cache_open(&s.cache, cache) < 0)
+    return 1;
+  result_key_init(&s.key, "sweep-shard");
+  result_key_int(&s.key, SHARD_GUST_ODDS);
+  result_key_int(&s.key, SHARD_GUST_LENGTH);
+  result_key_int(&s.key, SHARD_GUST_WIND);
+  result_key_int(&s.key, SHARD_GUST_QUIET);
+  result_key_int(&s.key, SHARD_RESUME);
+  result_key_int(&s.key, SHARD_GUST_KEY);
+  workers  = parallel_workers(workers);
+  points   = s.kp.n * s.ki.n * s.kd.n;
+  s.runs   = points * SHARD_CASES * s.seeds;
+  s.shards = (s.runs + s.size - 1) / s.size;
+
+  /* The shard states, then the records, in one region shared with the workers */
+  bytes  = s.shards * sizeof(*s.shard);
+  bytes  = (bytes + 63) & ~(size_t) 63;
+  shared = mmap(NULL, bytes + s.runs * sizeof(*s.record), PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (shared == MAP_FAILED) {
+    perror("mmap");
+    return 1;
+  }
+  s.shard  = shared;
+  s.record = (struct shard_record *) ((char *) shared + bytes);
+
+  t0 = bench_now();
+  for (; live < workers; live++)
+    if (shard_spawn(&s, limit) < 0) {
+      perror("fork");
+      break;
+    }
+  while (live > 0 && (pid = wait(&status)) > 0) {
+    live--;
+    if (WIFEXITED(status) && WEXITSTATUS(status) == 0)
+      continue;
+    crashes++;
+    if (WIFSIGNALED(status))
+      fprintf(stderr, "[shard] worker %d killed by signal %d\n", (int) pid, WTERMSIG(status));
+    else
+      fprintf(stderr, "[shard] worker %d exited with %d\n", (int) pid, WEXITSTATUS(status));
+    interrupted += shard_recover(&s, pid, retries);
+    if (shard_pending(&s) && shard_spawn(&s, limit) > 0)
+      live++;
+  }
+  t1 = bench_now();
+
+  for (i = 0; i < s.shards; i++) {
+    if (s.shard[i].state == SHARD_DONE)
+      continue;
+    failed++;
+    fprintf(stderr, "[shard] shard %zu (runs %zu to %zu) lost after %u attempts\n", i,
+              i * s.size, (i + 1) * s.size < s.runs ? (i + 1) * s.size - 1 : s.runs - 1,
+              s.shard[i].attempts);
+  }
+
+  /* Aggregate in place: over the scenarios and seeds of every point */
+  printf("kp,ki,kd,runs,settled,mean_iae,worst_iae,worst_overshoot,mean_ss_error\n");
+  for (point = 0; point < points; point++) {
+    const struct shard_record *r = &s.record[point * SHARD_CASES * s.seeds];
+
+    runs = settled = 0;
+    iae = worst = overshoot = ss_error = 0;
+    for (i = 0; i < SHARD_CASES * s.seeds; i++) {
+      if (!r[i].done)
+        continue;
+      runs++;
+      cached   += r[i].done == 2;
+      settled  += r[i].settling >= 0;
+      iae      += r[i].iae;
+      ss_error += r[i].ss_error;
+      if (r[i].iae > worst)
+        worst = r[i].iae;
+      if (r[i].overshoot > overshoot)
+        overshoot = r[i].overshoot;
+    }
+    shard_gains(&s, point, &kp, &ki, &kd);
+    printf("%g,%g,%g,%zu,%zu,%.1f,%.1f,%g,%.3f\n", kp, ki, kd, runs, settled,
+           runs ? iae / runs : 0.0, worst, overshoot, runs ? ss_error / runs : 0.0);
+    /* the most runs settled, then the lowest IAE, among the complete points */
+    if (runs == SHARD_CASES * s.seeds &&
+        (best == SIZE_MAX || settled > best_settled || (settled == best_settled && iae < best_iae))) {
+      best         = point;
+      best_iae     = iae;
+      best_settled = settled;
+    }
+  }
+  fflush(stdout);
+
+  fprintf(stderr, "[shard] %zu runs in %zu shards on %d processes: %.3f s, %.0f runs/s; "
+          "%u crashes, %zu shards interrupted, %zu lost\n", s.runs, s.shards, workers, t1 - t0,
+          s.runs / (t1 - t0), crashes, interrupted, failed);
+  if (s.cache.dir != NULL)
+    fprintf(stderr, "[shard] cache %s: %zu of the runs read back\n", s.cache.dir, cached);
+  if (best != SIZE_MAX) {
+    shard_gains(&s, best, &kp, &ki, &kd);
+    fprintf(stderr, "[shard] best kp %g ki %g kd %g: settled in %zu of %zu runs, mean IAE %.1f\n",
+            kp, ki, kd, best_settled, SHARD_CASES * s.seeds, best_iae / (SHARD_CASES * s.seeds));
+  } else {
+    fprintf(stderr, "[shard] no point has all its runs\n");
+  }
+  result_cache_close(&s.cache);
+  track_free(track);
+  return failed != 0;
+
+usage:
+  fprintf(stderr, "usage: %s [-p kp0:kp1:n] [-i ki0:ki1:n] [-d kd0:kd1:n] [-n seeds]\n"
+          "       [-P periods] [-j workers] [-z shard] [-R retries] [-m MB] [-t track]\n"
+          "       [-C cache]\n", argv[0]);
+  return 2;
+}
@@ -0,0 +1,932 @@
+/* Kernel core of the host uC/OS-II port
+ *
+ * Description:
+ *
+ *   Tasks, semaphores, mailboxes, software timers and time management with
+ *   the semantics of uC/OS-II v2.86. Scheduling is strictly priority based:
+ *   the ready set, the wait lists of the events and the set of delayed tasks
+ *   are 64-bit masks indexed by priority, so picking the next task is a
+ *   single count-trailing-zeros.
+ *
+ *   Context switches are delegated to the port (see os_port.h).
+ */
+#include <string.h>
+#include <sys/mman.h>
+
+#include "ucos_ii.h"
+#include "os_port.h"
+
+#define OS_BIT(prio) (1ull << (prio))
+
+/*
+ * Global kernel state
+ */
+volatile INT32U OSTime;
+INT32U          OSTmrTime;
+BOOLEAN         OSRunning;
+INT8U           OSIntNesting;
+INT8U           OSLockNesting;
+INT8U           OSPrioCur;
+INT8U           OSPrioHighRdy;
+uint64_t        OSRdyMask;
+INT32U          OSCtxSwCtr;
+INT8U           OSCPUUsage;
+OS_TCB         *OSTCBCur;
+OS_TCB         *OSTCBHighRdy;
+OS_TCB         *OSTCBPrioTbl[OS_N_PRIOS];
+
+static uint64_t OSDlyMask;                  /* Tasks with OSTCBDly != 0 */
+
+static OS_TCB   OSTCBTbl[OS_MAX_TASKS];
+static INT16U   OSTCBUsed;                  /* TCBs are never recycled, a deleted
+                                               task's port context may still
+                                               refer to its TCB                */
+
+static OS_EVENT OSEventTbl[OS_MAX_EVENTS];
+static OS_EVENT *OSEventFreeList;
+
+static OS_TMR   OSTmrTbl[OS_TMR_CFG_MAX];
+static INT16U   OSTmrUsed;                  /* High-water mark of OSTmrTbl */
+
+
+/*
+ * Scheduling
+ */
+
+static void OS_SchedNew(void)
+{
+  if (OSRdyMask != 0) {
+    OSPrioHighRdy = (INT8U) __builtin_ctzll(OSRdyMask);
+    OSTCBHighRdy  = OSTCBPrioTbl[OSPrioHighRdy];
+  } else {
+    OSPrioHighRdy = OS_TASK_IDLE_PRIO;
+    OSTCBHighRdy  = (OS_TCB *) 0;
+  }
+}
+
+static void OS_Sched(void)
+{
+  OS_CPU_SR cpu_sr;
+
+  OS_ENTER_CRITICAL();
+  if (OSRunning && OSIntNesting == 0 && OSLockNesting == 0) {
+    OSPortSchedHook();
+    OS_SchedNew();
+    if (OSTCBHighRdy != OSTCBCur)
+      OSCtxSw();
+  }
+  OS_EXIT_CRITICAL();
+}
+
+/*
+ * Called by the port each time a task (or the idle state) is switched in
+ */
+void OSTaskSwHook(void)
+{
+  OSCtxSwCtr++;
+  if (OSTCBHighRdy != (OS_TCB *) 0)
+    OSTCBHighRdy->OSTCBCtxSwCtr++;
+}
+
+static void OS_RdySet(INT8U prio)
+{
+  OSRdyMask |= OS_BIT(prio);
+}
+
+static void OS_RdyClr(INT8U prio)
+{
+  OSRdyMask &= ~OS_BIT(prio);
+}
+
+/*
+ * Event wait lists
+ */
+
+/* Makes the current task wait for 'pevent' for at most 'timeout' ticks */
+static void OS_EventTaskWait(OS_EVENT *pevent, INT8U stat, INT32U timeout)
+{
+  INT8U prio = OSTCBCur->OSTCBPrio;
+
+  OSTCBCur->OSTCBStat    |= stat;
+  OSTCBCur->OSTCBStatPend = OS_STAT_PEND_OK;
+  OSTCBCur->OSTCBDly      = timeout;
+  OSTCBCur->OSTCBEventPtr = pevent;
+  if (timeout != 0)
+    OSDlyMask |= OS_BIT(prio);
+  pevent->OSEventWaitMask |= OS_BIT(prio);
+  OS_RdyClr(prio);
+}
+
+/* Readies the highest priority task waiting for 'pevent' */
+static void OS_EventTaskRdy(OS_EVENT *pevent, void *pmsg, INT8U msk)
+{
+  INT8U   prio  = (INT8U) __builtin_ctzll(pevent->OSEventWaitMask);
+  OS_TCB *ptcb  = OSTCBPrioTbl[prio];
+
+  pevent->OSEventWaitMask &= ~OS_BIT(prio);
+  OSDlyMask               &= ~OS_BIT(prio);
+  ptcb->OSTCBDly           = 0;
+  ptcb->OSTCBEventPtr      = (OS_EVENT *) 0;
+  ptcb->OSTCBMsg           = pmsg;
+  ptcb->OSTCBStat         &= ~msk;
+  ptcb->OSTCBStatPend      = OS_STAT_PEND_OK;
+  if ((ptcb->OSTCBStat & OS_STAT_SUSPEND) == 0)
+    OS_RdySet(prio);
+}
+
+/* Collects the outcome of a pend once the current task runs again */
+static void *OS_EventPendResult(INT8U *perr)
+{
+  void *pmsg;
+
+  if (OSTCBCur->OSTCBStatPend == OS_STAT_PEND_OK) {
+    pmsg  = OSTCBCur->OSTCBMsg;
+    *perr = OS_ERR_NONE;
+  } else {
+    pmsg  = (void *) 0;
+    *perr = OS_ERR_TIMEOUT;
+  }
+  OSTCBCur->OSTCBStat     = OS_STAT_RDY;
+  OSTCBCur->OSTCBStatPend = OS_STAT_PEND_OK;
+  OSTCBCur->OSTCBEventPtr = (OS_EVENT *) 0;
+  OSTCBCur->OSTCBMsg      = (void *) 0;
+  return pmsg;
+}
+
+static OS_EVENT *OS_EventAlloc(INT8U type)
+{
+  OS_EVENT *pevent = OSEventFreeList;
+
+  if (pevent != (OS_EVENT *) 0) {
+    OSEventFreeList         = (OS_EVENT *) pevent->OSEventPtr;
+    pevent->OSEventType     = type;
+    pevent->OSEventPtr      = (void *) 0;
+    pevent->OSEventCnt      = 0;
+    pevent->OSEventWaitMask = 0;
+  }
+  return pevent;
+}
+
+
+/*
+ * Initialization and start
+ */
+
+void OSInit(void)
+{
+  INT16U i;
+
+  /* Only ports whose tasks are not live threads support a second OSInit() */
+  OSPortInit();
+  for (i = 0; i < OSTCBUsed; i++)
+    OS_TaskStkFree(&OSTCBTbl[i]);
+
+  OSTime         = 0;
+  OSTmrTime      = 0;
+  OSRunning      = FALSE;
+  OSIntNesting   = 0;
+  OSLockNesting  = 0;
+  OSPrioCur      = OS_TASK_IDLE_PRIO;
+  OSPrioHighRdy  = OS_TASK_IDLE_PRIO;
+  OSRdyMask      = 0;
+  OSDlyMask      = 0;
+  OSCtxSwCtr     = 0;
+  OSCPUUsage     = 0;
+  OSTCBCur       = (OS_TCB *) 0;
+  OSTCBHighRdy   = (OS_TCB *) 0;
+  OSTCBUsed      = 0;
+  OSTmrUsed      = 0;
+  memset(OSTCBPrioTbl, 0, sizeof(OSTCBPrioTbl));
+  memset(OSTCBTbl, 0, sizeof(OSTCBTbl));
+  memset(OSTmrTbl, 0, sizeof(OSTmrTbl));
+
+  memset(OSEventTbl, 0, sizeof(OSEventTbl));
+  for (i = 0; i < OS_MAX_EVENTS - 1; i++)
+    OSEventTbl[i].OSEventPtr = &OSEventTbl[i + 1];
+  OSEventFreeList = &OSEventTbl[0];
+}
+
+void OSStart(void)
+{
+  OS_CPU_SR cpu_sr;
+
+  OS_ENTER_CRITICAL();
+  if (OSRunning) {
+    OS_EXIT_CRITICAL();
+    return;
+  }
+  OS_SchedNew();
+  OSTaskSwHook();
+  OSPrioCur = OSPrioHighRdy;
+  OSTCBCur  = OSTCBHighRdy;
+  OSRunning = TRUE;
+  OS_EXIT_CRITICAL();
+
+  OSPortStart();
+}
+
+/*
+ * The statistic task is not modelled: the host profilers give far better
+ * numbers than the idle counter of OS_TaskStat().
+ */
+void OSStatInit(void)
+{
+}
+
+void OSIntEnter(void)
+{
+  OS_CPU_SR cpu_sr;
+
+  OS_ENTER_CRITICAL();
+  if (OSIntNesting < 255u)
+    OSIntNesting++;
+  OS_EXIT_CRITICAL();
+}
+
+void OSIntExit(void)
+{
+  OS_CPU_SR cpu_sr;
+
+  OS_ENTER_CRITICAL();
+  if (OSIntNesting > 0)
+    OSIntNesting--;
+  if (OSRunning && OSIntNesting == 0 && OSLockNesting == 0) {
+    OS_SchedNew();
+    if (OSTCBHighRdy != OSTCBCur)
+      OSIntCtxSw();
+  }
+  OS_EXIT_CRITICAL();
+}
+
+void OSSchedLock(void)
+{
+  OS_CPU_SR cpu_sr;
+
+  OS_ENTER_CRITICAL();
+  if (OSRunning && OSIntNesting == 0 && OSLockNesting < 255u)
+    OSLockNesting++;
+  OS_EXIT_CRITICAL();
+}
+
+void OSSchedUnlock(void)
+{
+  OS_CPU_SR cpu_sr;
+
+  OS_ENTER_CRITICAL();
+  if (OSLockNesting > 0)
+    OSLockNesting--;
+  OS_EXIT_CRITICAL();
+  OS_Sched();
+}
+
+INT16U OSVersion(void)
+{
+  return OS_VERSION;
+}
+
+
+/*
+ * Task management
+ */
+
+/*
+ * Host stacks: the TCB OSTCBTbl[i] always gets slot i of a region reserved
+ * when the program is loaded, below a guard page. The kernel state may be
+ * put back by OSSimRestore() (os_port_sim.c) without the kernel seeing the
+ * stacks of the tasks it forgets; they are simply taken again by the next
+ * tasks, so a program restarted any number of times maps no more stacks.
+ *
+ * A stack is handed out zero-filled, which doubles as the
+ * OS_TASK_OPT_STK_CLR pattern OSTaskStkChk() looks for.
+ */
+#define OS_STK_GUARD 4096u
+#define OS_STK_SLOT  (OS_STK_GUARD + OS_HOST_STK_SIZE)
+
+static INT8U *OSStkPool;
+
+static void __attribute__((constructor)) OS_StkPoolInit(void)
+{
+  void *pool = mmap(NULL, (size_t) OS_MAX_TASKS * OS_STK_SLOT, PROT_NONE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+  OSStkPool = pool != MAP_FAILED ? (INT8U *) pool : (INT8U *) 0;
+}
+
+INT8U OS_TaskStkAlloc(OS_TCB *ptcb)
+{
+  INT8U *stk;
+
+  if (OSStkPool == (INT8U *) 0)
+    return OS_ERR_TASK_NO_MORE_TCB;
+  stk = OSStkPool + (size_t) (ptcb - OSTCBTbl) * OS_STK_SLOT + OS_STK_GUARD;
+  if (mprotect(stk, OS_HOST_STK_SIZE, PROT_READ | PROT_WRITE) < 0 ||
+      madvise(stk, OS_HOST_STK_SIZE, MADV_DONTNEED) < 0)
+    return OS_ERR_TASK_NO_MORE_TCB;
+  ptcb->OSTCBStkBase = stk;
+  ptcb->OSTCBStkSize = OS_HOST_STK_SIZE;
+  return OS_ERR_NONE;
+}
+
+/* The pages go back to the system, the slot stays with its TCB */
+void OS_TaskStkFree(OS_TCB *ptcb)
+{
+  if (ptcb->OSTCBStkBase != (INT8U *) 0)
+    madvise(ptcb->OSTCBStkBase, ptcb->OSTCBStkSize, MADV_DONTNEED);
+  ptcb->OSTCBStkBase = (INT8U *) 0;
+}
+
+INT8U OSTaskCreateExt(void (*task)(void *p_arg), void *p_arg, OS_STK *ptos, INT8U prio,
+                      INT16U id, OS_STK *pbos, INT32U stk_size, void *pext, INT16U opt)
+{
+  OS_CPU_SR cpu_sr;
+  OS_TCB   *ptcb;
+  INT8U     err;
+
+  (void) ptos;
+  (void) pbos;
+  (void) stk_size;
+
+  if (prio > OS_LOWEST_PRIO)
+    return OS_ERR_PRIO_INVALID;
+
+  OS_ENTER_CRITICAL();
+  if (OSIntNesting > 0) {
+    OS_EXIT_CRITICAL();
+    return OS_ERR_TASK_CREATE_ISR;
+  }
+  if (OSTCBPrioTbl[prio] != (OS_TCB *) 0) {
+    OS_EXIT_CRITICAL();
+    return OS_ERR_PRIO_EXIST;
+  }
+  if (OSTCBUsed >= OS_MAX_TASKS) {
+    OS_EXIT_CRITICAL();
+    return OS_ERR_TASK_NO_MORE_TCB;
+  }
+  ptcb = &OSTCBTbl[OSTCBUsed++];
+  memset(ptcb, 0, sizeof(*ptcb));
+  ptcb->OSTCBTask     = task;
+  ptcb->OSTCBTaskData = p_arg;
+  ptcb->OSTCBPrio     = prio;
+  ptcb->OSTCBId       = id;
+  ptcb->OSTCBOpt      = opt;
+  ptcb->OSTCBExtPtr   = pext;
+  ptcb->OSTCBStat     = OS_STAT_RDY;
+  ptcb->OSTCBStatPend = OS_STAT_PEND_OK;
+
+  err = OS_TaskStkAlloc(ptcb);
+  if (err == OS_ERR_NONE)
+    err = OSPortTaskCreate(ptcb);
+  if (err != OS_ERR_NONE) {
+    OS_TaskStkFree(ptcb);
+    OS_EXIT_CRITICAL();
+    return err;
+  }
+  OSTCBPrioTbl[prio] = ptcb;
+  OS_RdySet(prio);
+  OS_EXIT_CRITICAL();
+
+  OS_Sched();
+  return OS_ERR_NONE;
+}
+
+INT8U OSTaskCreate(void (*task)(void *p_arg), void *p_arg, OS_STK *ptos, INT8U prio)
+{
+  return OSTaskCreateExt(task, p_arg, ptos, prio, prio, (OS_STK *) 0, 0,
+                         (void *) 0, OS_TASK_OPT_NONE);
+}
+
+INT8U OSTaskDel(INT8U prio)
+{
+  OS_CPU_SR cpu_sr;
+  OS_TCB   *ptcb;
+
+  OS_ENTER_CRITICAL();
+  if (OSIntNesting > 0) {
+    OS_EXIT_CRITICAL();
+    return OS_ERR_TASK_DEL_ISR;
+  }
+  if (prio == OS_PRIO_SELF)
+    prio = OSPrioCur;
+  if (prio >= OS_LOWEST_PRIO || OSTCBPrioTbl[prio] == (OS_TCB *) 0) {
+    OS_EXIT_CRITICAL();
+    return OS_ERR_TASK_NOT_EXIST;
+  }
+  ptcb = OSTCBPrioTbl[prio];
+
+  OS_RdyClr(prio);
+  OSDlyMask &= ~OS_BIT(prio);
+  if (ptcb->OSTCBEventPtr != (OS_EVENT *) 0)
+    ptcb->OSTCBEventPtr->OSEventWaitMask &= ~OS_BIT(prio);
+  OSTCBPrioTbl[prio] = (OS_TCB *) 0;
+
+  if (ptcb == OSTCBCur) {
+    OS_SchedNew();
+    OSPortTaskExit(ptcb);           /* Does not return */
+  }
+  OSPortTaskDel(ptcb);
+  OS_EXIT_CRITICAL();
+  return OS_ERR_NONE;
+}
+
+INT8U OSTaskStkChk(INT8U prio, OS_STK_DATA *p_stk_data)
+{
+  OS_CPU_SR cpu_sr;
+  OS_TCB   *ptcb;
+  INT8U    *pstk;
+  INT32U    nfree = 0;
+
+  if (prio > OS_LOWEST_PRIO && prio != OS_PRIO_SELF)
+    return OS_ERR_PRIO_INVALID;
+
+  OS_ENTER_CRITICAL();
+  if (prio == OS_PRIO_SELF)
+    prio = OSPrioCur;
+  ptcb = (prio < OS_N_PRIOS) ? OSTCBPrioTbl[prio] : (OS_TCB *) 0;
+  if (ptcb == (OS_TCB *) 0) {
+    OS_EXIT_CRITICAL();
+    return OS_ERR_TASK_NOT_EXIST;
+  }
+  if ((ptcb->OSTCBOpt & OS_TASK_OPT_STK_CHK) == 0) {
+    OS_EXIT_CRITICAL();
+    return OS_ERR_TASK_OPT;
+  }
+  /* The stack grows downwards: count the untouched bytes from the bottom */
+  pstk = ptcb->OSTCBStkBase;
+  while (nfree < ptcb->OSTCBStkSize && *pstk++ == 0)
+    nfree++;
+  p_stk_data->OSFree = nfree;
+  p_stk_data->OSUsed = ptcb->OSTCBStkSize - nfree;
+  OS_EXIT_CRITICAL();
+  return OS_ERR_NONE;
+}
+
+
+/*
+ * Semaphores
+ */
+
+OS_EVENT *OSSemCreate(INT16U cnt)
+{
+  OS_CPU_SR cpu_sr;
+  OS_EVENT *pevent;
+
+  OS_ENTER_CRITICAL();
+  pevent = OS_EventAlloc(OS_EVENT_TYPE_SEM);
+  if (pevent != (OS_EVENT *) 0)
+    pevent->OSEventCnt = cnt;
+  OS_EXIT_CRITICAL();
+  return pevent;
+}
+
+void OSSemPend(OS_EVENT *pevent, INT32U timeout, INT8U *perr)
+{
+  OS_CPU_SR cpu_sr;
+
+  if (pevent == (OS_EVENT *) 0) {
+    *perr = OS_ERR_PEVENT_NULL;
+    return;
+  }
+  if (pevent->OSEventType != OS_EVENT_TYPE_SEM) {
+    *perr = OS_ERR_EVENT_TYPE;
+    return;
+  }
+
+  OS_ENTER_CRITICAL();
+  if (OSIntNesting > 0) {
+    OS_EXIT_CRITICAL();
+    *perr = OS_ERR_PEND_ISR;
+    return;
+  }
+  if (pevent->OSEventCnt > 0) {
+    pevent->OSEventCnt--;
+    OS_EXIT_CRITICAL();
+    *perr = OS_ERR_NONE;
+    return;
+  }
+  OS_EventTaskWait(pevent, OS_STAT_SEM, timeout);
+  OS_Sched();
+  (void) OS_EventPendResult(perr);
+  OS_EXIT_CRITICAL();
+}
+
+INT8U OSSemPost(OS_EVENT *pevent)
+{
+  OS_CPU_SR cpu_sr;
+
+  if (pevent == (OS_EVENT *) 0)
+    return OS_ERR_PEVENT_NULL;
+  if (pevent->OSEventType != OS_EVENT_TYPE_SEM)
+    return OS_ERR_EVENT_TYPE;
+
+  OS_ENTER_CRITICAL();
+  if (pevent->OSEventWaitMask != 0) {
+    OS_EventTaskRdy(pevent, (void *) 0, OS_STAT_SEM);
+    OS_EXIT_CRITICAL();
+    OS_Sched();
+    return OS_ERR_NONE;
+  }
+  if (pevent->OSEventCnt < 65535u) {
+    pevent->OSEventCnt++;
+    OS_EXIT_CRITICAL();
+    return OS_ERR_NONE;
+  }
+  OS_EXIT_CRITICAL();
+  return OS_ERR_SEM_OVF;
+}
+
+INT16U OSSemAccept(OS_EVENT *pevent)
+{
+  OS_CPU_SR cpu_sr;
+  INT16U    cnt;
+
+  if (pevent == (OS_EVENT *) 0 || pevent->OSEventType != OS_EVENT_TYPE_SEM)
+    return 0;
+  OS_ENTER_CRITICAL();
+  cnt = pevent->OSEventCnt;
+  if (cnt > 0)
+    pevent->OSEventCnt--;
+  OS_EXIT_CRITICAL();
+  return cnt;
+}
+
+
+/*
+ * Mailboxes
+ */
+
+OS_EVENT *OSMboxCreate(void *pmsg)
+{
+  OS_CPU_SR cpu_sr;
+  OS_EVENT *pevent;
+
+  OS_ENTER_CRITICAL();
+  pevent = OS_EventAlloc(OS_EVENT_TYPE_MBOX);
+  if (pevent != (OS_EVENT *) 0)
+    pevent->OSEventPtr = pmsg;
+  OS_EXIT_CRITICAL();
+  return pevent;
+}
+
+void *OSMboxPend(OS_EVENT *pevent, INT32U timeout, INT8U *perr)
+{
+  OS_CPU_SR cpu_sr;
+  void     *pmsg;
+
+  if (pevent == (OS_EVENT *) 0) {
+    *perr = OS_ERR_PEVENT_NULL;
+    return (void *) 0;
+  }
+  if (pevent->OSEventType != OS_EVENT_TYPE_MBOX) {
+    *perr = OS_ERR_EVENT_TYPE;
+    return (void *) 0;
+  }
+
+  OS_ENTER_CRITICAL();
+  if (OSIntNesting > 0) {
+    OS_EXIT_CRITICAL();
+    *perr = OS_ERR_PEND_ISR;
+    return (void *) 0;
+  }
+  pmsg = pevent->OSEventPtr;
+  if (pmsg != (void *) 0) {
+    pevent->OSEventPtr = (void *) 0;
+    OS_EXIT_CRITICAL();
+    *perr = OS_ERR_NONE;
+    return pmsg;
+  }
+  OS_EventTaskWait(pevent, OS_STAT_MBOX, timeout);
+  OS_Sched();
+  pmsg = OS_EventPendResult(perr);
+  OS_EXIT_CRITICAL();
+  return pmsg;
+}
+
+INT8U OSMboxPost(OS_EVENT *pevent, void *pmsg)
+{
+  OS_CPU_SR cpu_sr;
+
+  if (pevent == (OS_EVENT *) 0)
+    return OS_ERR_PEVENT_NULL;
+  if (pmsg == (void *) 0)
+    return OS_ERR_POST_NULL_PTR;
+  if (pevent->OSEventType != OS_EVENT_TYPE_MBOX)
+    return OS_ERR_EVENT_TYPE;
+
+  OS_ENTER_CRITICAL();
+  if (pevent->OSEventWaitMask != 0) {
+    OS_EventTaskRdy(pevent, pmsg, OS_STAT_MBOX);
+    OS_EXIT_CRITICAL();
+    OS_Sched();
+    return OS_ERR_NONE;
+  }
+  if (pevent->OSEventPtr != (void *) 0) {
+    OS_EXIT_CRITICAL();
+    OS_Sched();                      /* Preemption point for busy posters */
+    return OS_ERR_MBOX_FULL;
+  }
+  pevent->OSEventPtr = pmsg;
+  OS_EXIT_CRITICAL();
+  OS_Sched();
+  return OS_ERR_NONE;
+}
+
+void *OSMboxAccept(OS_EVENT *pevent)
+{
+  OS_CPU_SR cpu_sr;
+  void     *pmsg;
+
+  if (pevent == (OS_EVENT *) 0 || pevent->OSEventType != OS_EVENT_TYPE_MBOX)
+    return (void *) 0;
+  OS_ENTER_CRITICAL();
+  pmsg = pevent->OSEventPtr;
+  pevent->OSEventPtr = (void *) 0;
+  OS_EXIT_CRITICAL();
+  return pmsg;
+}
+
+
+/*
+ * Software timers
+ *
+ * On the board OSTmrSignal() wakes the timer task which runs the callbacks.
+ * Here they are run directly by OSTmrSignal() with the scheduler locked, so
+ * a callback that posts a semaphore readies the pending task exactly as the
+ * timer task would.
+ */
+
+OS_TMR *OSTmrCreate(INT32U dly, INT32U period, INT8U opt, OS_TMR_CALLBACK callback,
+                    void *callback_arg, INT8U *pname, INT8U *perr)
+{
+  OS_CPU_SR cpu_sr;
+  OS_TMR   *ptmr = (OS_TMR *) 0;
+  INT16U    i;
+
+  if (opt == OS_TMR_OPT_PERIODIC && period == 0) {
+    *perr = OS_ERR_TMR_INVALID_PERIOD;
+    return (OS_TMR *) 0;
+  }
+  if (opt == OS_TMR_OPT_ONE_SHOT && dly == 0) {
+    *perr = OS_ERR_TMR_INVALID_DLY;
+    return (OS_TMR *) 0;
+  }
+  if (opt != OS_TMR_OPT_PERIODIC && opt != OS_TMR_OPT_ONE_SHOT) {
+    *perr = OS_ERR_TMR_INVALID_OPT;
+    return (OS_TMR *) 0;
+  }
+
+  OS_ENTER_CRITICAL();
+  for (i = 0; i < OS_TMR_CFG_MAX; i++) {
+    if (OSTmrTbl[i].OSTmrState == OS_TMR_STATE_UNUSED) {
+      ptmr = &OSTmrTbl[i];
+      break;
+    }
+  }
+  if (ptmr == (OS_TMR *) 0) {
+    OS_EXIT_CRITICAL();
+    *perr = OS_ERR_TMR_NON_AVAIL;
+    return (OS_TMR *) 0;
+  }
+  if (i + 1 > OSTmrUsed)
+    OSTmrUsed = i + 1;
+  ptmr->OSTmrType        = OS_TMR_TYPE;
+  ptmr->OSTmrState       = OS_TMR_STATE_STOPPED;
+  ptmr->OSTmrDly         = dly;
+  ptmr->OSTmrPeriod      = period;
+  ptmr->OSTmrOpt         = opt;
+  ptmr->OSTmrCallback    = callback;
+  ptmr->OSTmrCallbackArg = callback_arg;
+  ptmr->OSTmrName        = pname;
+  ptmr->OSTmrMatch       = 0;
+  OS_EXIT_CRITICAL();
+  *perr = OS_ERR_NONE;
+  return ptmr;
+}
+
+static INT8U OS_TmrCheck(OS_TMR *ptmr)
+{
+  if (ptmr == (OS_TMR *) 0 || ptmr->OSTmrType != OS_TMR_TYPE)
+    return OS_ERR_TMR_INVALID;
+  if (ptmr->OSTmrState == OS_TMR_STATE_UNUSED)
+    return OS_ERR_TMR_INACTIVE;
+  return OS_ERR_NONE;
+}
+
+BOOLEAN OSTmrDel(OS_TMR *ptmr, INT8U *perr)
+{
+  OS_CPU_SR cpu_sr;
+
+  OS_ENTER_CRITICAL();
+  *perr = OS_TmrCheck(ptmr);
+  if (*perr == OS_ERR_NONE)
+    ptmr->OSTmrState = OS_TMR_STATE_UNUSED;
+  OS_EXIT_CRITICAL();
+  return *perr == OS_ERR_NONE;
+}
+
+BOOLEAN OSTmrStart(OS_TMR *ptmr, INT8U *perr)
+{
+  OS_CPU_SR cpu_sr;
+
+  OS_ENTER_CRITICAL();
+  *perr = OS_TmrCheck(ptmr);
+  if (*perr == OS_ERR_NONE) {
+    ptmr->OSTmrState = OS_TMR_STATE_RUNNING;
+    ptmr->OSTmrMatch = OSTmrTime + (ptmr->OSTmrDly != 0 ? ptmr->OSTmrDly : ptmr->OSTmrPeriod);
+  }
+  OS_EXIT_CRITICAL();
+  return *perr == OS_ERR_NONE;
+}
+
+BOOLEAN OSTmrStop(OS_TMR *ptmr, INT8U opt, void *callback_arg, INT8U *perr)
+{
+  OS_CPU_SR cpu_sr;
+
+  OS_ENTER_CRITICAL();
+  *perr = OS_TmrCheck(ptmr);
+  if (*perr == OS_ERR_NONE && ptmr->OSTmrState != OS_TMR_STATE_RUNNING)
+    *perr = OS_ERR_TMR_INVALID_STATE;
+  if (*perr == OS_ERR_NONE) {
+    ptmr->OSTmrState = OS_TMR_STATE_STOPPED;
+    if (opt == OS_TMR_OPT_CALLBACK && ptmr->OSTmrCallback != (OS_TMR_CALLBACK) 0)
+      ptmr->OSTmrCallback(ptmr, ptmr->OSTmrCallbackArg);
+    else if (opt == OS_TMR_OPT_CALLBACK_ARG && ptmr->OSTmrCallback != (OS_TMR_CALLBACK) 0)
+      ptmr->OSTmrCallback(ptmr, callback_arg);
+    else if (opt != OS_TMR_OPT_NONE && opt != OS_TMR_OPT_CALLBACK && opt != OS_TMR_OPT_CALLBACK_ARG)
+      *perr = OS_ERR_INVALID_OPT;
+  }
+  OS_EXIT_CRITICAL();
+  return *perr == OS_ERR_NONE;
+}
+
+INT32U OSTmrRemainGet(OS_TMR *ptmr, INT8U *perr)
+{
+  OS_CPU_SR cpu_sr;
+  INT32U    remain = 0;
+
+  OS_ENTER_CRITICAL();
+  *perr = OS_TmrCheck(ptmr);
+  if (*perr == OS_ERR_NONE) {
+    if (ptmr->OSTmrState == OS_TMR_STATE_RUNNING)
+      remain = ptmr->OSTmrMatch - OSTmrTime;
+    else if (ptmr->OSTmrState == OS_TMR_STATE_STOPPED)
+      remain = ptmr->OSTmrDly != 0 ? ptmr->OSTmrDly : ptmr->OSTmrPeriod;
+  }
+  OS_EXIT_CRITICAL();
+  return remain;
+}
+
+INT8U OSTmrSignal(void)
+{
+  OS_CPU_SR cpu_sr;
+  OS_TMR   *ptmr;
+  INT16U    i;
+
+  OS_ENTER_CRITICAL();
+  OSTmrTime++;
+  OSLockNesting++;
+  for (i = 0; i < OSTmrUsed; i++) {
+    ptmr = &OSTmrTbl[i];
+    if (ptmr->OSTmrState != OS_TMR_STATE_RUNNING || ptmr->OSTmrMatch != OSTmrTime)
+      continue;
+    if (ptmr->OSTmrOpt == OS_TMR_OPT_PERIODIC)
+      ptmr->OSTmrMatch = OSTmrTime + ptmr->OSTmrPeriod;
+    else
+      ptmr->OSTmrState = OS_TMR_STATE_COMPLETED;
+    if (ptmr->OSTmrCallback != (OS_TMR_CALLBACK) 0)
+      ptmr->OSTmrCallback(ptmr, ptmr->OSTmrCallbackArg);
+  }
+  OSLockNesting--;
+  OS_EXIT_CRITICAL();
+  OS_Sched();
+  return OS_ERR_NONE;
+}
+
+
+/*
+ * Time management
+ */
+
+void OSTimeDly(INT32U ticks)
+{
+  OS_CPU_SR cpu_sr;
+  INT8U     prio;
+
+  OS_ENTER_CRITICAL();
+  if (OSIntNesting > 0 || OSLockNesting > 0 || ticks == 0 || OSTCBCur == (OS_TCB *) 0) {
+    OS_EXIT_CRITICAL();
+    return;
+  }
+  prio = OSTCBCur->OSTCBPrio;
+  OSTCBCur->OSTCBDly = ticks;
+  OSDlyMask |= OS_BIT(prio);
+  OS_RdyClr(prio);
+  OS_EXIT_CRITICAL();
+  OS_Sched();
+}
+
+INT8U OSTimeDlyHMSM(INT8U hours, INT8U minutes, INT8U seconds, INT16U ms)
+{
+  INT32U ticks;
+
+  if (hours == 0 && minutes == 0 && seconds == 0 && ms == 0)
+    return OS_ERR_TIME_ZERO_DLY;
+  if (minutes > 59)
+    return OS_ERR_TIME_INVALID_MINUTES;
+  if (seconds > 59)
+    return OS_ERR_TIME_INVALID_SECONDS;
+  if (ms > 999)
+    return OS_ERR_TIME_INVALID_MS;
+
+  ticks = ((INT32U) hours * 3600u + (INT32U) minutes * 60u + (INT32U) seconds) * OS_TICKS_PER_SEC
+        + OS_TICKS_PER_SEC * ((INT32U) ms + 500u / OS_TICKS_PER_SEC) / 1000u;
+  OSTimeDly(ticks);
+  return OS_ERR_NONE;
+}
+
+INT32U OSTimeGet(void)
+{
+  OS_CPU_SR cpu_sr;
+  INT32U    ticks;
+
+  OS_ENTER_CRITICAL();
+  ticks = OSTime;
+  OS_EXIT_CRITICAL();
+  OS_Sched();                        /* Preemption point for polling loops */
+  return ticks;
+}
+
+void OSTimeSet(INT32U ticks)
+{
+  OS_CPU_SR cpu_sr;
+
+  OS_ENTER_CRITICAL();
+  OSTime = ticks;
+  OS_EXIT_CRITICAL();
+}
+
+/*
+ * Number of ticks until the next delay or pend timeout expires
+ * (0xFFFFFFFF if no task waits for the time)
+ */
+INT32U OSTimeNextEvent(void)
+{
+  uint64_t dly  = OSDlyMask;
+  INT32U   next = 0xFFFFFFFFu;
+  INT8U    prio;
+
+  while (dly != 0) {
+    prio = (INT8U) __builtin_ctzll(dly);
+    dly &= dly - 1;
+    if (OSTCBPrioTbl[prio]->OSTCBDly < next)
+      next = OSTCBPrioTbl[prio]->OSTCBDly;
+  }
+  return next;
+}
+
+/*
+ * Advances the time by 'ticks' ticks in which no delay expires, i.e.
+ * 'ticks' < OSTimeNextEvent(). Used by ports that skip idle time.
+ */
+void OSTimeTickN(INT32U ticks)
+{
+  uint64_t dly = OSDlyMask;
+  INT8U    prio;
+
+  OSTime += ticks;
+  while (dly != 0) {
+    prio = (INT8U) __builtin_ctzll(dly);
+    dly &= dly - 1;
+    OSTCBPrioTbl[prio]->OSTCBDly -= ticks;
+  }
+}
+
+/*
+ * Called from the tick ISR: ages the delays and pend timeouts
+ */
+void OSTimeTick(void)
+{
+  OS_CPU_SR cpu_sr;
+  uint64_t  dly;
+  INT8U     prio;
+  OS_TCB   *ptcb;
+
+  OS_ENTER_CRITICAL();
+  OSTime++;
+  dly = OSDlyMask;
+  while (dly != 0) {
+    prio = (INT8U) __builtin_ctzll(dly);
+    dly &= dly - 1;
+    ptcb = OSTCBPrioTbl[prio];
+    if (--ptcb->OSTCBDly != 0)
+      continue;
+    OSDlyMask &= ~OS_BIT(prio);
+    if (ptcb->OSTCBStat & OS_STAT_PEND_ANY) {
+      ptcb->OSTCBEventPtr->OSEventWaitMask &= ~OS_BIT(prio);
+      ptcb->OSTCBStat    &= ~OS_STAT_PEND_ANY;
+      ptcb->OSTCBStatPend = OS_STAT_PEND_TO;
+    }
+    if ((ptcb->OSTCBStat & OS_STAT_SUSPEND) == 0)
+      OS_RdySet(prio);
+  }
+  OS_EXIT_CRITICAL();
+}
@@ -0,0 +1,51 @@
+/* Port interface of the host uC/OS-II kernel
+ *
+ * Description:
+ *
+ *   os_core.c implements the kernel objects and the scheduling decisions.
+ *   How a task actually gets the CPU and where ticks come from is left to
+ *   a port, exactly as the Nios II port (os_cpu_a.S) does on the board:
+ *
+ *     os_port_posix.c - one pthread per task, wall-clock tick thread
+ *     os_port_sim.c   - coroutines on one thread, virtual time that jumps
+ *                       straight to the next timer or delay expiry
+ *
+ *   All functions below are called with the kernel lock held.
+ */
+#ifndef OS_PORT_H
+#define OS_PORT_H
+
+#include "ucos_ii.h"
+
+/* Called by OSInit() before any task exists */
+void  OSPortInit(void);
+
+/* Prepares the context of a new task whose host stack is already allocated */
+INT8U OSPortTaskCreate(OS_TCB *ptcb);
+
+/* Releases the context of a task deleted by another task */
+void  OSPortTaskDel(OS_TCB *ptcb);
+
+/* Leaves the calling task for good after it deleted itself */
+void  OSPortTaskExit(OS_TCB *ptcb);
+
+/* Gives the CPU to OSTCBCur for the first time and runs the tick source */
+void  OSPortStart(void);
+
+/* Task level switch from OSTCBCur to OSTCBHighRdy (NULL: CPU idles) */
+void  OSCtxSw(void);
+
+/* Switch at the end of the outermost ISR */
+void  OSIntCtxSw(void);
+
+/* Called at every task level scheduling point, before the decision */
+void  OSPortSchedHook(void);
+
+/* Kernel helpers the ports use */
+void  OSTaskSwHook(void);
+INT8U OS_TaskStkAlloc(OS_TCB *ptcb);
+void  OS_TaskStkFree(OS_TCB *ptcb);
+INT32U OSTimeNextEvent(void);
+void  OSTimeTickN(INT32U ticks);
+
+#endif /* OS_PORT_H */
@@ -0,0 +1,274 @@
+/* POSIX threads port of the host uC/OS-II kernel
+ *
+ * Description:
+ *
+ *   Every task is a pthread running on its own zero-filled stack, but only
+ *   the task in OSTCBCur is allowed to execute: a context switch hands the
+ *   kernel lock over to the next task and parks the current one on its
+ *   condition variable. This keeps the single-CPU semantics the lab code
+ *   relies on while letting perf, gprof or valgrind see one thread per task.
+ *
+ *   The thread that calls OSStart() becomes the system clock: it calls
+ *   alt_tick() every 1/OS_TICKS_PER_SEC seconds of wall-clock time. A tick
+ *   that readies a higher priority task preempts the running one at its
+ *   next kernel call (or immediately if the CPU is idle).
+ *
+ *   Setting UCOS_HOST_RUN_MS stops the program after that many milliseconds
+ *   and prints the CPU time every task consumed per activation.
+ *
+ *   UCOS_HOST_RECORD=file records the keys and switches into an input trace
+ *   (alt_host.h) and reads them from the standard input meanwhile, one
+ *   "k <value>" or "s <value>" line per change (keys are active low).
+ *   UCOS_HOST_REPLAY=file plays such a trace back in real time; the
+ *   simulator replays it at full speed (cruise-sim -r).
+ */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "system.h"
+#include "ucos_ii.h"
+#include "os_port.h"
+#include "alt_host.h"
+#include "altera_avalon_pio_regs.h"
+#include "sys/alt_alarm.h"
+
+struct os_port_tcb {
+  pthread_t      thread;
+  pthread_cond_t cond;
+};
+
+static pthread_mutex_t OSPortLock = PTHREAD_MUTEX_INITIALIZER;
+static __thread int    OSPortLockHeld;
+
+/*
+ * Critical sections
+ */
+
+OS_CPU_SR OS_CPU_SR_Save(void)
+{
+  if (OSPortLockHeld)
+    return 0;
+  pthread_mutex_lock(&OSPortLock);
+  OSPortLockHeld = 1;
+  return 1;
+}
+
+void OS_CPU_SR_Restore(OS_CPU_SR cpu_sr)
+{
+  if (cpu_sr) {
+    OSPortLockHeld = 0;
+    pthread_mutex_unlock(&OSPortLock);
+  }
+}
+
+/*
+ * Context switching
+ */
+
+/* Gives the CPU to OSTCBHighRdy */
+static void OSPortDispatch(void)
+{
+  OSTaskSwHook();
+  OSTCBCur  = OSTCBHighRdy;
+  OSPrioCur = OSPrioHighRdy;
+  if (OSTCBCur != (OS_TCB *) 0)
+    pthread_cond_signal(&OSTCBCur->OSTCBPort->cond);
+}
+
+static void OSPortWaitCPU(OS_TCB *ptcb)
+{
+  while (OSTCBCur != ptcb)
+    pthread_cond_wait(&ptcb->OSTCBPort->cond, &OSPortLock);
+}
+
+void OSCtxSw(void)
+{
+  OS_TCB *self = OSTCBCur;
+
+  OSPortDispatch();
+  OSPortWaitCPU(self);
+}
+
+void OSIntCtxSw(void)
+{
+  /* A running thread cannot be stopped from the outside, it switches
+     itself at its next kernel call */
+  if (OSTCBCur == (OS_TCB *) 0)
+    OSPortDispatch();
+}
+
+void OSPortSchedHook(void)
+{
+}
+
+static void *OSPortTaskStart(void *arg)
+{
+  OS_TCB   *ptcb = (OS_TCB *) arg;
+  OS_CPU_SR cpu_sr;
+
+  OS_ENTER_CRITICAL();
+  OSPortWaitCPU(ptcb);
+  OS_EXIT_CRITICAL();
+
+  ptcb->OSTCBTask(ptcb->OSTCBTaskData);
+  OSTaskDel(OS_PRIO_SELF);
+  return NULL;
+}
+
+/*
+ * Task management
+ */
+
+void OSPortInit(void)
+{
+}
+
+INT8U OSPortTaskCreate(OS_TCB *ptcb)
+{
+  struct os_port_tcb *port = calloc(1, sizeof(*port));
+  pthread_attr_t      attr;
+  int                 rc;
+
+  if (port == NULL)
+    return OS_ERR_TASK_NO_MORE_TCB;
+  pthread_cond_init(&port->cond, NULL);
+  ptcb->OSTCBPort = port;
+
+  pthread_attr_init(&attr);
+  pthread_attr_setstack(&attr, ptcb->OSTCBStkBase, ptcb->OSTCBStkSize);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+  rc = pthread_create(&port->thread, &attr, OSPortTaskStart, ptcb);
+  pthread_attr_destroy(&attr);
+  if (rc != 0) {
+    pthread_cond_destroy(&port->cond);
+    free(port);
+    ptcb->OSTCBPort = NULL;
+    return OS_ERR_TASK_NO_MORE_TCB;
+  }
+  return OS_ERR_NONE;
+}
+
+/*
+ * The thread of a task deleted by another task stays parked for good: its
+ * TCB is never handed out again, so it cannot be dispatched.
+ */
+void OSPortTaskDel(OS_TCB *ptcb)
+{
+  (void) ptcb;
+}
+
+void OSPortTaskExit(OS_TCB *ptcb)
+{
+  (void) ptcb;
+  OSPortDispatch();
+  OSPortLockHeld = 0;
+  pthread_mutex_unlock(&OSPortLock);
+  pthread_exit(NULL);
+}
+
+/*
+ * System clock and run-time report
+ */
+
+static void OSPortReport(void)
+{
+  struct timespec cpu;
+  clockid_t       cid;
+  OS_TCB         *ptcb;
+  OS_STK_DATA     stk;
+  double          ms;
+  INT16U          prio;
+
+  printf("[host] %u ticks, %u context switches\n", OSTime, OSCtxSwCtr);
+  printf("[host] prio  activations  cpu[ms]  cpu/activation[us]  stack[bytes]\n");
+  for (prio = 0; prio < OS_N_PRIOS; prio++) {
+    ptcb = OSTCBPrioTbl[prio];
+    if (ptcb == (OS_TCB *) 0)
+      continue;
+    ms = 0.0;
+    if (pthread_getcpuclockid(ptcb->OSTCBPort->thread, &cid) == 0 &&
+        clock_gettime(cid, &cpu) == 0)
+      ms = cpu.tv_sec * 1e3 + cpu.tv_nsec / 1e6;
+    if (OSTaskStkChk((INT8U) prio, &stk) != OS_ERR_NONE)
+      stk.OSUsed = 0;
+    printf("[host] %4u  %11u  %7.3f  %18.3f  %12u\n", prio, ptcb->OSTCBCtxSwCtr, ms,
+           ptcb->OSTCBCtxSwCtr ? ms * 1e3 / ptcb->OSTCBCtxSwCtr : 0.0, stk.OSUsed);
+  }
+  fflush(stdout);
+}
+
+/* Sets the inputs from the lines of the standard input */
+static void *OSPortConsole(void *arg)
+{
+  char          line[64], pio;
+  unsigned long value;
+
+  (void) arg;
+  while (fgets(line, sizeof(line), stdin) != NULL) {
+    if (sscanf(line, " %c %li", &pio, (long *) &value) != 2 || (pio != 'k' && pio != 's')) {
+      fprintf(stderr, "[host] expected 'k <keys>' or 's <switches>'\n");
+      continue;
+    }
+    if (pio == 'k')
+      IOWR_ALTERA_AVALON_PIO_DATA(D2_PIO_KEYS4_BASE, value);
+    else
+      IOWR_ALTERA_AVALON_PIO_DATA(DE2_PIO_TOGGLES18_BASE, value);
+  }
+  return NULL;
+}
+
+static void OSPortTraces(void)
+{
+  const char *record = getenv("UCOS_HOST_RECORD");
+  const char *replay = getenv("UCOS_HOST_REPLAY");
+  pthread_t   console;
+  alt_u32     end;
+
+  if (replay != NULL && alt_host_replay(replay, &end) < 0)
+    exit(1);
+  if (record == NULL)
+    return;
+  if (alt_host_record(record) < 0)
+    exit(1);
+  if (replay == NULL && pthread_create(&console, NULL, OSPortConsole, NULL) == 0)
+    pthread_detach(console);
+}
+
+void OSPortStart(void)
+{
+  const char     *env = getenv("UCOS_HOST_RUN_MS");
+  INT32U          run_ticks = env ? (INT32U) (strtoul(env, NULL, 10) * OS_TICKS_PER_SEC / 1000u) : 0;
+  struct timespec next;
+  OS_CPU_SR       cpu_sr;
+
+  OSPortTraces();
+  OS_ENTER_CRITICAL();
+  if (OSTCBCur != (OS_TCB *) 0)
+    pthread_cond_signal(&OSTCBCur->OSTCBPort->cond);
+  OS_EXIT_CRITICAL();
+
+  clock_gettime(CLOCK_MONOTONIC, &next);
+  for (;;) {
+    next.tv_nsec += 1000000000L / OS_TICKS_PER_SEC;
+    if (next.tv_nsec >= 1000000000L) {
+      next.tv_nsec -= 1000000000L;
+      next.tv_sec++;
+    }
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR)
+      ;
+
+    OS_ENTER_CRITICAL();
+    OSIntEnter();
+    alt_tick();
+    OSIntExit();
+    if (run_ticks != 0 && OSTime >= run_ticks) {
+      OSPortReport();
+      exit(0);
+    }
+    OS_EXIT_CRITICAL();
+  }
+}
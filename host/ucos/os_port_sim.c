@@ -0,0 +1,462 @@
+/* Simulation port of the host uC/OS-II kernel
+ *
+ * Description:
+ *
+ *   All tasks run as coroutines on the thread that calls OSStart(); a
+ *   context switch only saves the callee-saved registers and swaps stack
+ *   pointers. There is no wall clock: when every task waits, the virtual
+ *   time jumps straight to the next alarm, timer or delay expiry, so a
+ *   300 ms control period costs a handful of context switches.
+ *
+ *   A task that keeps the CPU without waiting (a polling loop on OSTimeGet(),
+ *   a busy helper task) is charged one tick every OS_SIM_CALLS_PER_TICK
+ *   scheduling points, which lets the time advance under it. Once the
+ *   lowest-priority task is the only one ready, nothing it does can preempt
+ *   another task before the next event, so the time jumps to that event as
+ *   if the system were idle: the helper task of src-merlijn, which wakes the
+ *   watchdog at each post, costs a few context switches per event instead
+ *   of two per scheduling point on every tick, and a day of driving runs in
+ *   about a third of a second (some 800000 periods per second, where
+ *   src/cruise.c runs 10^6).
+
+ *   The order of events only depends on the program, so every run with the
+ *   same inputs produces the same trace.
+ *
+ *   Since the whole simulated system lives in the data segment of the
+ *   program (kernel, HAL registers and alarms, the globals of the lab
+ *   code) and on the task stacks, a checkpoint is a copy of these: the
+ *   data segment with its runs of zeros left out and the used part of
+ *   every stack. Restoring one and calling OSSimRun() resumes the
+ *   simulation from that point as many times as needed.
+ */
+#include <stdint.h>
+#include <string.h>
+
+#include "ucos_ii.h"
+#include "os_port.h"
+#include "os_sim.h"
+#include "alt_host.h"
+#include "sys/alt_alarm.h"
+
+#ifndef OS_SIM_CALLS_PER_TICK
+#define OS_SIM_CALLS_PER_TICK 10u
+#endif
+
+struct os_port_tcb {
+  void *sp;                          /* Saved stack pointer while switched out */
+  void *top;                         /* Highest address of the stack */
+};
+
+static struct os_port_tcb OSSimCtx[OS_MAX_TASKS];
+static INT16U             OSSimCtxUsed;
+static void              *OSSimMainSp;     /* Context of the OSStart() caller */
+static INT32U             OSSimEnd;
+static INT32U             OSSimCallsPerTick = OS_SIM_CALLS_PER_TICK;
+static INT32U             OSSimCalls;
+static BOOLEAN            OSSimBackground; /* Lowest task alone since the last tick */
+
+/*
+ * Stack switching
+ *
+ * OS_SimCtxSw(save, to) stores the current stack pointer in *save and
+ * resumes the context whose stack pointer is 'to'. A new context starts in
+ * OS_SimTaskStart() (see OS_SimCtxInit()).
+ */
+void OS_SimCtxSw(void **save, void *to);
+
+#if defined(__x86_64__)
+__asm__(
+  ".text\n"
+  ".p2align 4\n"
+  ".type OS_SimCtxSw, @function\n"
+  "OS_SimCtxSw:\n"
+  "  pushq %rbp\n"
+  "  pushq %rbx\n"
+  "  pushq %r12\n"
+  "  pushq %r13\n"
+  "  pushq %r14\n"
+  "  pushq %r15\n"
+  "  movq  %rsp, (%rdi)\n"
+  "  movq  %rsi, %rsp\n"
+  "  popq  %r15\n"
+  "  popq  %r14\n"
+  "  popq  %r13\n"
+  "  popq  %r12\n"
+  "  popq  %rbx\n"
+  "  popq  %rbp\n"
+  "  ret\n"
+  ".size OS_SimCtxSw, .-OS_SimCtxSw\n");
+
+#define OS_SIM_CTX_REGS 6            /* rbp rbx r12-r15 */
+#elif defined(__aarch64__)
+__asm__(
+  ".text\n"
+  ".p2align 4\n"
+  ".type OS_SimCtxSw, %function\n"
+  "OS_SimCtxSw:\n"
+  "  sub  sp, sp, #160\n"
+  "  stp  x19, x20, [sp, #0]\n"
+  "  stp  x21, x22, [sp, #16]\n"
+  "  stp  x23, x24, [sp, #32]\n"
+  "  stp  x25, x26, [sp, #48]\n"
+  "  stp  x27, x28, [sp, #64]\n"
+  "  stp  x29, x30, [sp, #80]\n"
+  "  stp  d8,  d9,  [sp, #96]\n"
+  "  stp  d10, d11, [sp, #112]\n"
+  "  stp  d12, d13, [sp, #128]\n"
+  "  stp  d14, d15, [sp, #144]\n"
+  "  mov  x9, sp\n"
+  "  str  x9, [x0]\n"
+  "  mov  sp, x1\n"
+  "  ldp  x19, x20, [sp, #0]\n"
+  "  ldp  x21, x22, [sp, #16]\n"
+  "  ldp  x23, x24, [sp, #32]\n"
+  "  ldp  x25, x26, [sp, #48]\n"
+  "  ldp  x27, x28, [sp, #64]\n"
+  "  ldp  x29, x30, [sp, #80]\n"
+  "  ldp  d8,  d9,  [sp, #96]\n"
+  "  ldp  d10, d11, [sp, #112]\n"
+  "  ldp  d12, d13, [sp, #128]\n"
+  "  ldp  d14, d15, [sp, #144]\n"
+  "  add  sp, sp, #160\n"
+  "  ret\n"
+  ".size OS_SimCtxSw, .-OS_SimCtxSw\n");
+#else
+#error "os_port_sim.c: no context switch for this host architecture"
+#endif
+
+static void OS_SimTaskStart(void);
+
+static void *OS_SimCtxInit(OS_TCB *ptcb)
+{
+  uintptr_t top = ((uintptr_t) ptcb->OSTCBStkBase + ptcb->OSTCBStkSize) & ~(uintptr_t) 15;
+  void    **sp  = (void **) top;
+  int       i;
+
+#if defined(__x86_64__)
+  *--sp = (void *) 0;                /* Keeps the entry frame ABI aligned */
+  *--sp = (void *) OS_SimTaskStart;  /* Return address of OS_SimCtxSw     */
+  for (i = 0; i < OS_SIM_CTX_REGS; i++)
+    *--sp = (void *) 0;
+#else
+  sp -= 20;                          /* Register save area of OS_SimCtxSw */
+  for (i = 0; i < 20; i++)
+    sp[i] = (void *) 0;
+  sp[11] = (void *) OS_SimTaskStart; /* x30 */
+#endif
+  return sp;
+}
+
+static void OS_SimTaskStart(void)
+{
+  OS_TCB *ptcb = OSTCBCur;
+
+  ptcb->OSTCBTask(ptcb->OSTCBTaskData);
+  OSTaskDel(OS_PRIO_SELF);
+}
+
+/*
+ * Critical sections: there is a single thread and no asynchronous
+ * interrupt, so there is nothing to protect.
+ */
+
+OS_CPU_SR OS_CPU_SR_Save(void)
+{
+  return 0;
+}
+
+void OS_CPU_SR_Restore(OS_CPU_SR cpu_sr)
+{
+  (void) cpu_sr;
+}
+
+/*
+ * Context switching
+ */
+
+static void *OS_SimSpOf(OS_TCB *ptcb)
+{
+  return ptcb != (OS_TCB *) 0 ? ptcb->OSTCBPort->sp : OSSimMainSp;
+}
+
+static void OSPortDispatch(void)
+{
+  OSTaskSwHook();
+  OSTCBCur  = OSTCBHighRdy;
+  OSPrioCur = OSPrioHighRdy;
+}
+
+void OSCtxSw(void)
+{
+  OS_TCB *from = OSTCBCur;
+
+  OSPortDispatch();
+  OS_SimCtxSw(&from->OSTCBPort->sp, OS_SimSpOf(OSTCBCur));
+}
+
+/* ISRs run on the main context, which resumes OSTCBCur afterwards */
+void OSIntCtxSw(void)
+{
+  OSPortDispatch();
+}
+
+/* Whether no task exists below priority 'prio' */
+static BOOLEAN OS_SimLowest(INT8U prio)
+{
+  INT8U p;
+
+  for (p = prio + 1; p < OS_N_PRIOS; p++)
+    if (OSTCBPrioTbl[p] != (OS_TCB *) 0)
+      return FALSE;
+  return TRUE;
+}
+
+void OSPortSchedHook(void)
+{
+  if (OSTCBCur == (OS_TCB *) 0)
+    return;
+  if (!OSSimBackground && OSRdyMask != 0 && (OSRdyMask & (OSRdyMask - 1)) == 0)
+    OSSimBackground = OS_SimLowest((INT8U) __builtin_ctzll(OSRdyMask));
+  if (++OSSimCalls < OSSimCallsPerTick && !OSSimBackground)
+    return;
+  /* Busy task: let the main context advance the time by one tick, or up
+   * to the next event when only the lowest task is left */
+  OS_SimCtxSw(&OSTCBCur->OSTCBPort->sp, OSSimMainSp);
+}
+
+/*
+ * Task management
+ */
+
+void OSPortInit(void)
+{
+  OSSimCtxUsed    = 0;
+  OSSimCalls      = 0;
+  OSSimBackground = FALSE;
+}
+
+INT8U OSPortTaskCreate(OS_TCB *ptcb)
+{
+  if (OSSimCtxUsed >= OS_MAX_TASKS)
+    return OS_ERR_TASK_NO_MORE_TCB;
+  ptcb->OSTCBPort      = &OSSimCtx[OSSimCtxUsed++];
+  ptcb->OSTCBPort->sp  = OS_SimCtxInit(ptcb);
+  ptcb->OSTCBPort->top = ptcb->OSTCBStkBase + ptcb->OSTCBStkSize;
+  return OS_ERR_NONE;
+}
+
+void OSPortTaskDel(OS_TCB *ptcb)
+{
+  (void) ptcb;
+}
+
+/* The stack of the deleted task is released by the next OSInit() */
+void OSPortTaskExit(OS_TCB *ptcb)
+{
+  void *dead;
+
+  OSPortDispatch();
+  OS_SimCtxSw(&dead, OS_SimSpOf(OSTCBCur));
+  (void) ptcb;
+}
+
+/*
+ * Virtual time
+ */
+
+void OSSimStopAt(INT32U ticks)
+{
+  OSSimEnd = ticks;
+}
+
+void OSSimSetCallsPerTick(INT32U calls)
+{
+  OSSimCallsPerTick = calls != 0 ? calls : OS_SIM_CALLS_PER_TICK;
+}
+
+/* 'resume': continue where the last run stopped, without the switch to
+   the task it left running (which the next tick gives the CPU back to) */
+static void OS_SimRun(int resume)
+{
+  INT32U next;
+  INT32U dly;
+
+  for (;;) {
+    /* Run tasks until the CPU idles or a busy task gives up a tick */
+    if (OSTCBCur != (OS_TCB *) 0 && !resume)
+      OS_SimCtxSw(&OSSimMainSp, OSTCBCur->OSTCBPort->sp);
+    resume = 0;
+
+    if (OSTCBCur != (OS_TCB *) 0 && !OSSimBackground) {
+      next = 1;
+    } else {
+      next = alt_alarm_next();
+      dly  = OSTimeNextEvent();
+      if (dly < next)
+        next = dly;
+      if (next == 0xFFFFFFFFu && OSSimEnd == 0) {
+        if (OSTCBCur == (OS_TCB *) 0)
+          break;                     /* Nothing can ever wake a task again */
+        next = 1;
+      }
+    }
+    if (OSSimEnd != 0 && (uint64_t) OSTime + next > OSSimEnd) {
+      if (OSTime < OSSimEnd)
+        alt_tick_skip(OSSimEnd - OSTime);
+      break;
+    }
+
+    OSSimCalls      = 0;
+    OSSimBackground = FALSE;
+    if (next > 1)
+      alt_tick_skip(next - 1);
+    OSIntEnter();
+    alt_tick();
+    OSIntExit();
+  }
+  OSRunning = FALSE;
+}
+
+void OSPortStart(void)
+{
+  OS_SimRun(0);
+}
+
+void OSSimRun(INT32U ticks)
+{
+  OSSimEnd  = ticks;
+  OSRunning = TRUE;
+  OS_SimRun(1);
+}
+
+/*
+ * Checkpoints
+ *
+ * Layout: struct os_sim_ckpt, then for the data segment runs of
+ * (INT32U zero bytes, INT32U literal bytes, literal bytes) up to its end,
+ * then for every stack (uintptr_t low, uintptr_t high, high - low bytes).
+ */
+
+extern char __data_start[], _end[];
+
+#define OS_SIM_CKPT_MAGIC 0x314B4355u   /* "UCK1" */
+
+struct os_sim_ckpt {
+  INT32U    magic;
+  INT32U    stacks;
+  uintptr_t data;                    /* Data segment of the process */
+  uintptr_t data_end;
+};
+
+struct os_sim_buf {
+  INT8U *p;
+  size_t used;
+  size_t size;
+};
+
+static void OS_SimPut(struct os_sim_buf *b, const void *src, size_t n)
+{
+  if (b->used + n <= b->size)
+    memcpy(b->p + b->used, src, n);
+  b->used += n;
+}
+
+static int OS_SimGet(struct os_sim_buf *b, void *dst, size_t n)
+{
+  if (b->used + n > b->size)
+    return -1;
+  memcpy(dst, b->p + b->used, n);
+  b->used += n;
+  return 0;
+}
+
+/* Length of the run of zero words at p, at most n bytes */
+static size_t OS_SimZeros(const char *p, size_t n)
+{
+  size_t   i;
+  uint64_t w;
+
+  for (i = 0; i + sizeof(w) <= n; i += sizeof(w)) {
+    memcpy(&w, p + i, sizeof(w));
+    if (w != 0)
+      break;
+  }
+  return i;
+}
+
+size_t OSSimCheckpoint(void *buf, size_t size)
+{
+  struct os_sim_buf  b = {(INT8U *) buf, 0, buf != (void *) 0 ? size : 0};
+  struct os_sim_ckpt h = {OS_SIM_CKPT_MAGIC, OSSimCtxUsed, (uintptr_t) __data_start,
+                          (uintptr_t) _end};
+  const char        *p = __data_start;
+  size_t             n = (size_t) (_end - __data_start);
+  size_t             i, lit;
+  INT32U             run[2];
+  uintptr_t          lo, hi;
+  INT16U             t;
+
+  OS_SimPut(&b, &h, sizeof(h));
+  for (i = 0; i < n; i += run[0] + run[1]) {
+    run[0] = (INT32U) OS_SimZeros(p + i, n - i);
+    /* A literal run ends at two zero words in a row or at the end */
+    for (lit = i + run[0]; lit < n; lit += sizeof(uint64_t))
+      if (OS_SimZeros(p + lit, n - lit) >= 2 * sizeof(uint64_t))
+        break;
+    run[1] = (INT32U) ((lit < n ? lit : n) - i - run[0]);
+    OS_SimPut(&b, run, sizeof(run));
+    OS_SimPut(&b, p + i + run[0], run[1]);
+  }
+  /* The stacks are taken after the data segment, which holds their
+     saved stack pointers: only the main context is running */
+  for (t = 0; t < OSSimCtxUsed; t++) {
+    lo = (uintptr_t) OSSimCtx[t].sp;
+    hi = (uintptr_t) OSSimCtx[t].top;
+    OS_SimPut(&b, &lo, sizeof(lo));
+    OS_SimPut(&b, &hi, sizeof(hi));
+    OS_SimPut(&b, (void *) lo, hi - lo);
+  }
+  return b.used;
+}
+
+INT8U OSSimRestore(const void *buf, size_t size)
+{
+  struct os_sim_buf  b = {(INT8U *) buf, 0, size};
+  struct os_sim_ckpt h;
+  char              *p = __data_start;
+  size_t             n = (size_t) (_end - __data_start);
+  size_t             i;
+  INT32U             run[2], t;
+  uintptr_t          lo, hi;
+
+  if (OS_SimGet(&b, &h, sizeof(h)) < 0 || h.magic != OS_SIM_CKPT_MAGIC ||
+      h.data != (uintptr_t) __data_start || h.data_end != (uintptr_t) _end)
+    return OS_ERR_PDATA_NULL;
+
+  /* Check the whole checkpoint before overwriting anything */
+  for (i = 0; i < n; i += run[0] + run[1]) {
+    if (OS_SimGet(&b, run, sizeof(run)) < 0 || run[0] + run[1] > n - i ||
+        b.used + run[1] > size)
+      return OS_ERR_PDATA_NULL;
+    b.used += run[1];
+  }
+  for (t = 0; t < h.stacks; t++) {
+    if (OS_SimGet(&b, &lo, sizeof(lo)) < 0 || OS_SimGet(&b, &hi, sizeof(hi)) < 0 ||
+        hi < lo || b.used + (hi - lo) > size)
+      return OS_ERR_PDATA_NULL;
+    b.used += hi - lo;
+  }
+
+  b.used = sizeof(h);
+  for (i = 0; i < n; i += run[0] + run[1]) {
+    OS_SimGet(&b, run, sizeof(run));
+    memset(p + i, 0, run[0]);
+    OS_SimGet(&b, p + i + run[0], run[1]);
+  }
+  for (t = 0; t < h.stacks; t++) {
+    OS_SimGet(&b, &lo, sizeof(lo));
+    OS_SimGet(&b, &hi, sizeof(hi));
+    OS_SimGet(&b, (void *) lo, hi - lo);
+  }
+  return OS_ERR_NONE;
+}
@@ -0,0 +1,39 @@
+/* Controls of the simulation port (os_port_sim.c)
+ *
+ * With the simulation port OSStart() returns once the virtual time reaches
+ * the end set here, or when every task waits for an event that no timer or
+ * alarm can produce any more. OSSimRun() then continues the simulation.
+ *
+ * A checkpoint holds the addresses of the process that took it: it can be
+ * restored in that process and in the children it forks, not in another
+ * run of the program.
+ */
+#ifndef OS_SIM_H
+#define OS_SIM_H
+
+#include <stddef.h>
+
+#include "ucos_ii.h"
+
+/* OSStart() returns when OSTime reaches 'ticks' (0: run forever) */
+void   OSSimStopAt(INT32U ticks);
+
+/* Virtual time charged to the running task: one tick every 'calls'
+   scheduling points without an idle period in between */
+void   OSSimSetCallsPerTick(INT32U calls);
+
+/* Continues a simulation OSStart() returned from until OSTime reaches 'ticks' */
+void   OSSimRun(INT32U ticks);
+
+/*
+ * Writes a checkpoint of the simulated system to 'buf' if it fits in
+ * 'size' bytes and returns its size. Only valid after OSStart() or
+ * OSSimRun() returned, or before the first task is created.
+ */
+size_t OSSimCheckpoint(void *buf, size_t size);
+
+/* Puts the simulated system back to a checkpoint; OS_ERR_PDATA_NULL if it
+   is corrupt or was taken by another program or process */
+INT8U  OSSimRestore(const void *buf, size_t size);
+
+#endif /* OS_SIM_H */
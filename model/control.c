@@ -0,0 +1,232 @@
+/* Cruise controller of the cruise control lab, see control.h */
+#include "control.h"
+
+#define CONTROL_GAINS(kp, ki, kd) \
+  { PID_FX_C(kp, PID_FX_Q), PID_FX_C(ki, PID_FX_Q), PID_FX_C(kd, PID_FX_Q) }
+
+/*
+ * Segments of track_lab: flat, uphill, steep uphill, flat, downhill, steep
+ * downhill. Found by a coordinate search within the box of gain-opt (kp
+ * 0..2, ki 0..1, kd 0..1), for the least IAE over laps at 30 to 70 m/s.
+ */
+static const struct control_gains control_gains_lab[] = {
+  CONTROL_GAINS(1.5,  1.0, 0.0),
+  CONTROL_GAINS(1.75, 1.0, 0.0),
+  CONTROL_GAINS(2.0,  1.0, 0.5),
+  CONTROL_GAINS(2.0,  1.0, 0.5),
+  CONTROL_GAINS(2.0,  1.0, 0.5),
+  CONTROL_GAINS(2.0,  1.0, 0.5),
+};
+
+const struct control_schedule control_schedule_lab = {&track_lab, control_gains_lab};
+
+/* The steady throttle is WIND_FACTOR * velocity - gradient (vehicle.c) */
+#define CONTROL_OFFSET(gradient) ((int32_t) -(gradient) * ((int32_t) 1 << PID_FX_Q))
+
+static const int32_t control_offset_lab[] = {
+  CONTROL_OFFSET(0),
+  CONTROL_OFFSET(-GRAVITY_FACTOR),
+  CONTROL_OFFSET(-2 * GRAVITY_FACTOR),
+  CONTROL_OFFSET(0),
+  CONTROL_OFFSET(2 * GRAVITY_FACTOR),
+  CONTROL_OFFSET(GRAVITY_FACTOR),
+};
+
+const struct control_offsets control_offsets_lab = {&track_lab, control_offset_lab};
+
+void control_offsets_init(struct control_offsets *ff, const struct track *track,
+                          int32_t *offset)
+{
+  INT32U i;
+
+  for (i = 0; i < track->segments; i++)
+    offset[i] = CONTROL_OFFSET(track->segment[i].gradient);
+  ff->track  = track;
+  ff->offset = offset;
+}
+
+/* Segment the car will be in horizon_ms from now at this velocity, wrapping
+   around like the position */
+static INT32U control_ahead(const struct control_state *state, INT16S velocity)
+{
+  INT32S position = ((INT32S) state->position +
+                     (INT32S) velocity * (INT32S) state->horizon_ms / 1000) %
+                    (INT32S) state->track->length;
+
+  if (position < 0)
+    position += (INT32S) state->track->length;
+  return track_segment_at(state->track, (INT32U) position);
+}
+
+/* First move of the MPC solution for this error, segment and the throttle
+   in the PID output, a fixed number of operations */
+static INT8U control_mpc_throttle(const struct control_state *state, INT16S velocity,
+                                  INT32U segment)
+{
+  int q = state->pid.q;
+  int32_t base = WIND_FACTOR * (int32_t) state->target_velocity;
+  int32_t error = state->target_velocity - velocity;
+  int32_t throttle = ((state->pid.out + ((int32_t) 1 << (q - 1))) >> q) - base;
+  const int8_t *row;
+  int32_t u;
+
+  if (error > CONTROL_MPC_ERROR)
+    error = CONTROL_MPC_ERROR;
+  else if (error < -CONTROL_MPC_ERROR)
+    error = -CONTROL_MPC_ERROR;
+  if (throttle > CONTROL_MPC_THROTTLE)
+    throttle = CONTROL_MPC_THROTTLE;
+  else if (throttle < -CONTROL_MPC_THROTTLE)
+    throttle = -CONTROL_MPC_THROTTLE;
+  throttle += CONTROL_MPC_THROTTLE;
+
+  row = state->mpc->throttle +
+        (segment * CONTROL_MPC_ROWS + (INT32U) (error + CONTROL_MPC_ERROR)) * CONTROL_MPC_COLUMNS +
+        (throttle >> CONTROL_MPC_SHIFT);
+  u = ((int32_t) row[0] << CONTROL_MPC_SHIFT) +
+      (row[1] - row[0]) * (throttle & ((1 << CONTROL_MPC_SHIFT) - 1));
+  u = base + ((u + (1 << (CONTROL_MPC_SHIFT - 1))) >> CONTROL_MPC_SHIFT);
+  return u < 0 ? 0 : u > MAX_THROTTLE ? MAX_THROTTLE : (INT8U) u;
+}
+
+void control_init(struct control_state *state)
+{
+  pid_fx_init(&state->pid, PID_FX_Q,
+              PID_FX_C(CONTROL_KP, PID_FX_Q),
+              PID_FX_C(CONTROL_KI, PID_FX_Q),
+              PID_FX_C(CONTROL_KD, PID_FX_Q),
+              0, (int32_t) MAX_THROTTLE << PID_FX_Q);
+  state->throttle = STATIONARY_THROTTLE;
+  state->engine_state = 0;
+  state->top_gear = off;
+  state->cruise_control = off;
+  state->target_velocity = 0;
+  state->track = track_default;
+  state->position = 0;
+#ifdef CONTROL_GAIN_SCHEDULE
+  state->schedule = &control_schedule_lab;
+#else
+  state->schedule = NULL;
+#endif
+#ifdef CONTROL_FEED_FORWARD
+  state->feed_forward = &control_offsets_lab;
+#else
+  state->feed_forward = NULL;
+#endif
+  state->horizon_ms = CONTROL_HORIZON_MS;
+  state->offset = 0;
+#ifdef CONTROL_MPC
+  state->mpc = &control_mpc_lab;
+#else
+  state->mpc = NULL;
+#endif
+}
+
+void control_step(struct control_state *state, const struct control_inputs *in,
+                  struct control_outputs *out)
+{
+  INT16S velocity = in->velocity;
+  INT8U buttons = in->buttons;
+  int switches = in->switches;
+  int q = state->pid.q;
+  int32_t error;
+  INT32S position;
+  const struct control_gains *gains;
+  int32_t offset;
+
+  out->engine = 0;
+
+  /* Logic for handling the engine,
+  turning it on and off
+  If the velocity is zero and the car is not moving then the car is turned off
+  */
+  if (((switches & ENGINE_FLAG) == 0) & (state->engine_state == 1))
+  {
+    // If there is still velocity then set the throttle to 0
+    if (velocity != 0)
+      state->throttle = 0;
+    else
+    {
+      out->engine = off;
+      state->engine_state = 0;
+    }
+  }
+  else if (((switches & ENGINE_FLAG) == 1) & (state->engine_state == 0))
+  {
+    // The task takes the engine back down if the mailbox is full
+    out->engine = on;
+    state->engine_state = 1;
+  }
+
+  /*
+  Get information about the top gear and cruise control
+  */
+  state->top_gear = (switches & TOP_GEAR_FLAG) ? on : off;
+
+  if ((buttons & CRUISE_CONTROL_FLAG) && (velocity > 20) && (state->top_gear == on))
+  {
+    state->target_velocity = velocity % MAXIMUM_TARGET_VELOCITY;
+    state->cruise_control = on;
+  }
+
+  // Turn cruise control off if the brake is pressed or the gas is pressed
+  if ((buttons & (BRAKE_PEDAL_FLAG | GAS_PEDAL_FLAG)) |
+      ((state->cruise_control == on) & (state->top_gear == off)) |
+      (velocity < 25))
+    state->cruise_control = off;
+
+  /*
+  Logic for handling the break, gas and cruise control. It also is of this order in importance
+  Starts out with having a throttle of 40 and then changing it according to the rules
+  */
+  state->throttle = STATIONARY_THROTTLE;
+
+  if (buttons & BRAKE_PEDAL_FLAG)
+    state->throttle = 0;
+  else if (buttons & GAS_PEDAL_FLAG)
+    state->throttle = MAX_THROTTLE;
+  else if (state->cruise_control == on &&
+           state->mpc != NULL && state->mpc->track == state->track)
+  {
+    // The table keeps its last throttle in the PID output, so that the
+    // PID could take over without a bump
+    state->throttle = control_mpc_throttle(state, velocity, control_ahead(state, velocity));
+    state->pid.out = (int32_t) state->throttle << q;
+  }
+  else if (state->cruise_control == on)
+  {
+    // PID on the difference between target and current velocity,
+    // rounded to whole units of throttle
+    if (state->schedule != NULL && state->schedule->track == state->track)
+    {
+      gains = &state->schedule->gains[track_segment_at(state->track, state->position)];
+      state->pid.kp = gains->kp;
+      state->pid.ki = gains->ki;
+      state->pid.kd = gains->kd;
+    }
+    if (state->feed_forward != NULL && state->feed_forward->track == state->track)
+    {
+      offset = state->feed_forward->offset[control_ahead(state, velocity)];
+      state->pid.out += offset - state->offset;
+      state->offset = offset;
+    }
+    error = (int32_t) (state->target_velocity - velocity) * ((int32_t) 1 << q);
+    state->throttle = (pid_fx_step(&state->pid, error) + ((int32_t) 1 << (q - 1))) >> q;
+  }
+
+  // Without cruise control the loop restarts from the stationary throttle
+  if (state->cruise_control != on)
+  {
+    pid_fx_reset(&state->pid, (int32_t) STATIONARY_THROTTLE << q);
+    state->offset = 0;
+  }
+
+  out->throttle = state->throttle;
+  out->brake = (buttons & BRAKE_PEDAL_FLAG) ? on : off;
+
+  // Calculate the new position modulo the length of the track, backing
+  // up past 0 m leads to its end
+  position = ((INT32S) state->position + velocity * CONTROL_STEP_MS / 1000) %
+             (INT32S) state->track->length;
+  state->position = position < 0 ? position + (INT32S) state->track->length : position;
+}
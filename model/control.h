@@ -0,0 +1,183 @@
+/* Cruise controller of the cruise control lab
+ *
+ * Description:
+ *
+ *   The engine, gear and cruise mode logic and the PID law of ControlTask
+ *   (src-merlijn/cruise.c) as a re-entrant step function over an explicit
+ *   state. One call handles one CONTROL_STEP_MS period: it takes the
+ *   velocity and the button and switch patterns the IO tasks delivered and
+ *   returns the throttle, brake and engine commands for the vehicle. The
+ *   cruise control law is the fixed-point incremental PID of pid_fx.h, so
+ *   the controller needs no floating point either.
+ *
+ *   The step does not touch any kernel object or register; posting the
+ *   commands and lighting the LEDs stays in the task.
+ *
+ *   With a gain schedule the PID gains follow the track: the schedule holds
+ *   one set of fixed-point gains per segment of its track, and every step
+ *   loads those of the segment the dead-reckoned position is in, found in
+ *   constant time through the bucket index of track.h. The incremental PID
+ *   keeps its output across the change, so a new segment changes the slope
+ *   of the throttle but does not make it jump. Building with
+ *   -DCONTROL_GAIN_SCHEDULE makes control_init() schedule the lab track.
+ *
+ *   The slopes are known in advance, so a feed-forward term need not wait
+ *   for the velocity to drop: it looks horizon_ms ahead of the position at
+ *   the current velocity and adds the throttle offset of the segment found
+ *   there, the throttle that holds the velocity against its slope. The
+ *   offsets are a table per segment of a track like the gains, so a step
+ *   costs one more bucket lookup whatever the horizon. The offset moves
+ *   the output of the incremental PID, which keeps clamping the sum and
+ *   integrates whatever the offset does not cancel. -DCONTROL_FEED_FORWARD
+ *   makes control_init() use the offsets of the lab track.
+ *
+ *   An explicit MPC table replaces the PID altogether: host/tune/mpc_table.c
+ *   solves the model predictive control problem of the vehicle model
+ *   offline for every velocity error, segment and current throttle of a
+ *   grid, and a step only looks up the first move of the solution. The
+ *   throttle is relative to WIND_FACTOR * target velocity, around which
+ *   the dynamics of the error do not depend on the target; the error row
+ *   is exact (velocities are whole m/s) and the current throttle is
+ *   interpolated between two columns, so the lookup takes the same few
+ *   operations whatever the state. -DCONTROL_MPC makes control_init() use
+ *   the table of the lab track (control_mpc_lab.c).
+ */
+#ifndef CONTROL_H
+#define CONTROL_H
+
+#include "includes.h"
+#include "vehicle.h"
+#include "pid_fx.h"
+
+/* Period the controller is sampled with (CONTROL_PERIOD of the tasks) */
+#define CONTROL_STEP_MS    300
+
+/* Button Patterns */
+
+#define GAS_PEDAL_FLAG 0x08
+#define BRAKE_PEDAL_FLAG 0x04
+#define CRUISE_CONTROL_FLAG 0x02
+#define INCREASE_CRUISE_CONTROL_FLAG 0x01
+
+/* Switch Patterns */
+
+#define TOP_GEAR_FLAG 0x00000002
+#define ENGINE_FLAG 0x00000001
+
+/* Throttle while driving without cruise control or pedal (4.0 V) */
+#define STATIONARY_THROTTLE 40
+
+/* The target velocity is kept below this value */
+#define MAXIMUM_TARGET_VELOCITY 80
+
+/* Gains of the PID controller, per control period */
+#define CONTROL_KP 0.5
+#define CONTROL_KI 1.0
+#define CONTROL_KD 0.0
+
+/* Look-ahead of the feed-forward term: VehicleTask applies the throttle
+   ControlTask posts one period later, from where the car is then */
+#define CONTROL_HORIZON_MS CONTROL_STEP_MS
+
+/* The build options above that change what control_init() and control_step()
+   compute, one bit each, for the tools that cache their results */
+#ifdef CONTROL_GAIN_SCHEDULE
+#define CONTROL_BUILD_SCHEDULE     0x1
+#else
+#define CONTROL_BUILD_SCHEDULE     0
+#endif
+#ifdef CONTROL_FEED_FORWARD
+#define CONTROL_BUILD_FEED_FORWARD 0x2
+#else
+#define CONTROL_BUILD_FEED_FORWARD 0
+#endif
+#ifdef CONTROL_MPC
+#define CONTROL_BUILD_MPC          0x4
+#else
+#define CONTROL_BUILD_MPC          0
+#endif
+#define CONTROL_BUILD_FLAGS \
+  (CONTROL_BUILD_SCHEDULE | CONTROL_BUILD_FEED_FORWARD | CONTROL_BUILD_MPC)
+
+/* Gains of one segment, per control period with PID_FX_Q fractional bits */
+struct control_gains {
+  int32_t kp;
+  int32_t ki;
+  int32_t kd;
+};
+
+struct control_schedule {
+  const struct track         *track;  /* only used on this track */
+  const struct control_gains *gains;  /* one per segment of the track */
+};
+
+/* Gains for the flat, uphill and downhill segments of track_lab */
+extern const struct control_schedule control_schedule_lab;
+
+struct control_offsets {
+  const struct track *track;          /* only used on this track */
+  const int32_t      *offset;         /* throttle per segment, PID_FX_Q bits */
+};
+
+/* Offsets of the segments of track_lab */
+extern const struct control_offsets control_offsets_lab;
+
+/* Axes of the MPC tables: the error from -CONTROL_MPC_ERROR to CONTROL_MPC_ERROR
+   m/s, the throttle from -CONTROL_MPC_THROTTLE to CONTROL_MPC_THROTTLE around
+   WIND_FACTOR * target in steps of 2^CONTROL_MPC_SHIFT, with the last column
+   repeated so that the interpolation never reads past a row */
+#define CONTROL_MPC_ERROR    15
+#define CONTROL_MPC_THROTTLE 40
+#define CONTROL_MPC_SHIFT    2
+#define CONTROL_MPC_ROWS     (2 * CONTROL_MPC_ERROR + 1)
+#define CONTROL_MPC_COLUMNS  ((2 * CONTROL_MPC_THROTTLE >> CONTROL_MPC_SHIFT) + 2)
+
+struct control_mpc {
+  const struct track *track;          /* only used on this track */
+  const int8_t       *throttle;       /* [segment][row][column], first move
+                                         relative to WIND_FACTOR * target */
+};
+
+/* Table of the segments of track_lab */
+extern const struct control_mpc control_mpc_lab;
+
+struct control_state {
+  struct pid_fx pid;           /* Throttle in PID_FX_Q, restarts at
+                                  STATIONARY_THROTTLE when cruise engages */
+
+  INT8U       throttle;        /* Value between 0 and 80 */
+  INT8U       engine_state;    /* 1 while the engine is on */
+  enum active top_gear;
+  enum active cruise_control;
+  INT16S      target_velocity; /* m/s, set when cruise control engages */
+  const struct track *track;   /* track_default when initialized */
+  INT32U      position;        /* m, dead-reckoned from the velocity */
+  const struct control_schedule *schedule;  /* NULL: CONTROL_KP, _KI, _KD
+                                               everywhere */
+  const struct control_offsets  *feed_forward;  /* NULL: none */
+  INT32U      horizon_ms;      /* look-ahead, CONTROL_HORIZON_MS when initialized */
+  int32_t     offset;          /* part of the PID output added by the feed-forward */
+  const struct control_mpc      *mpc;     /* NULL: the PID */
+};
+
+struct control_inputs {
+  INT16S velocity;  /* m/s, as sent by the vehicle */
+  INT8U  buttons;   /* Button Patterns */
+  int    switches;  /* Switch Patterns */
+};
+
+struct control_outputs {
+  INT8U       throttle;
+  enum active brake;
+  enum active engine;  /* on/off when the engine changes state, 0 otherwise */
+};
+
+void control_init(struct control_state *state);
+
+/* Offsets of the segments of 'track' into 'offset' (track->segments entries) */
+void control_offsets_init(struct control_offsets *ff, const struct track *track,
+                          int32_t *offset);
+void control_step(struct control_state *state, const struct control_inputs *in,
+                  struct control_outputs *out);
+
+#endif /* CONTROL_H */
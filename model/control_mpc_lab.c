@@ -0,0 +1,207 @@
+/* Explicit MPC table of the lab track, see control.h
+ *
+ * Written by host/build/bin/mpc-table -N 20 -q 1 -r 0.05 -S 8, do not
+ * edit: 6 segments x 31 errors x 22 throttle columns.
+ */
+#include "control.h"
+
+#if CONTROL_MPC_ERROR != 15 || CONTROL_MPC_THROTTLE != 40 || CONTROL_MPC_SHIFT != 2
+#error "control.h changed the axes, run mpc-table again"
+#endif
+
+static const int8_t control_mpc_lab_throttle[] = {
+  /* segment 0, gradient 0 */
+  -33, -28, -25, -20, -19, -19, -19, -19, -16, -12, -6, -2, 1, 4, 8, 13, 16, 20, 24, 28, 32, 32,
+  -32, -28, -25, -20, -17, -17, -17, -17, -13, -10, -7, -3, 0, 5, 9, 12, 17, 20, 24, 29, 32, 32,
+  -32, -28, -24, -20, -18, -18, -14, -14, -14, -11, -8, -4, 0, 4, 8, 12, 16, 21, 24, 28, 32, 32,
+  -32, -28, -24, -21, -17, -15, -15, -15, -15, -12, -5, -2, 1, 5, 8, 13, 16, 20, 24, 28, 32, 32,
+  -32, -29, -24, -20, -16, -16, -16, -16, -13, -10, -6, -3, 0, 4, 9, 12, 16, 20, 24, 28, 33, 33,
+  -32, -29, -24, -20, -16, -14, -14, -14, -11, -11, -7, -4, 1, 5, 9, 13, 16, 20, 25, 28, 32, 32,
+  -32, -28, -24, -20, -17, -12, -12, -12, -12, -12, -8, -2, 2, 4, 8, 12, 17, 21, 24, 28, 32, 32,
+  -32, -28, -24, -21, -17, -13, -13, -9, -9, -9, -6, -3, 1, 4, 9, 12, 17, 20, 24, 28, 32, 32,
+  -32, -28, -24, -20, -16, -13, -10, -10, -10, -7, -7, -4, 0, 6, 8, 12, 16, 20, 24, 29, 32, 32,
+  -33, -28, -24, -20, -16, -13, -9, -8, -8, -8, -5, -1, 2, 5, 9, 12, 16, 21, 24, 28, 32, 32,
+  -32, -28, -24, -20, -16, -12, -8, -7, -6, -6, -6, -2, 1, 4, 8, 13, 17, 20, 24, 28, 32, 32,
+  -32, -28, -25, -21, -16, -12, -8, -7, -5, -3, -3, -3, 0, 5, 9, 13, 16, 20, 24, 28, 32, 32,
+  -32, -28, -24, -20, -17, -12, -9, -6, -4, -4, -1, -1, 2, 5, 8, 12, 16, 20, 25, 28, 32, 32,
+  -32, -28, -24, -20, -17, -13, -8, -4, -4, -2, -2, 1, 1, 5, 8, 12, 17, 20, 25, 28, 32, 32,
+  -32, -28, -24, -20, -16, -12, -9, -5, -2, -2, 0, 0, 4, 4, 9, 13, 16, 20, 24, 29, 33, 33,
+  -32, -29, -25, -20, -16, -12, -10, -5, 0, 0, 0, 3, 3, 6, 9, 13, 16, 20, 24, 28, 32, 32,
+  -32, -28, -24, -21, -16, -13, -8, -4, -1, -1, 3, 4, 5, 5, 8, 12, 17, 21, 24, 28, 32, 32,
+  -32, -28, -24, -21, -16, -12, -8, -4, -2, 2, 2, 5, 6, 7, 10, 13, 16, 21, 24, 28, 32, 32,
+  -32, -28, -24, -20, -16, -12, -9, -5, -2, 4, 4, 4, 7, 8, 10, 12, 16, 20, 25, 29, 32, 32,
+  -33, -28, -24, -20, -16, -13, -9, -4, 0, 3, 6, 6, 6, 9, 10, 12, 16, 20, 24, 28, 32, 32,
+  -32, -28, -24, -20, -17, -12, -8, -5, -1, 2, 5, 9, 9, 9, 11, 13, 17, 20, 24, 28, 32, 32,
+  -32, -28, -25, -20, -16, -12, -8, -4, -2, 4, 8, 8, 11, 11, 11, 13, 17, 20, 24, 28, 32, 32,
+  -32, -28, -24, -20, -16, -13, -8, -5, 0, 3, 7, 10, 10, 13, 13, 13, 16, 21, 25, 28, 32, 32,
+  -32, -28, -24, -20, -17, -13, -8, -4, 0, 2, 6, 12, 12, 12, 12, 16, 16, 21, 24, 28, 32, 32,
+  -32, -28, -24, -21, -16, -12, -9, -5, -1, 2, 8, 11, 15, 15, 15, 15, 17, 20, 24, 28, 33, 33,
+  -32, -29, -24, -20, -16, -12, -8, -6, 0, 4, 7, 10, 14, 14, 17, 17, 18, 20, 24, 28, 33, 33,
+  -32, -28, -24, -20, -16, -12, -9, -4, -1, 3, 6, 9, 16, 16, 19, 19, 19, 21, 25, 28, 32, 32,
+  -32, -28, -24, -20, -17, -12, -8, -4, 0, 4, 8, 12, 15, 18, 18, 18, 18, 20, 24, 28, 32, 32,
+  -32, -28, -25, -20, -16, -13, -8, -5, -1, 4, 7, 11, 14, 17, 17, 17, 21, 21, 24, 29, 32, 32,
+  -33, -28, -24, -20, -16, -12, -9, -4, 0, 3, 6, 10, 16, 20, 20, 20, 20, 20, 24, 29, 32, 32,
+  -32, -28, -24, -20, -16, -12, -8, -4, -1, 3, 6, 12, 15, 19, 22, 22, 22, 22, 24, 28, 32, 32,
+  /* segment 1, gradient -2 */
+  -32, -28, -24, -20, -17, -17, -17, -17, -14, -10, -7, -4, 0, 4, 8, 12, 16, 20, 25, 28, 32, 32,
+  -32, -28, -24, -20, -17, -15, -15, -15, -15, -11, -8, -1, 1, 5, 9, 12, 17, 20, 24, 28, 32, 32,
+  -33, -28, -25, -20, -16, -16, -12, -12, -12, -12, -6, -2, 1, 4, 8, 13, 16, 20, 24, 28, 32, 32,
+  -32, -28, -25, -20, -16, -13, -13, -13, -13, -10, -7, -3, 0, 5, 9, 12, 17, 20, 24, 29, 32, 32,
+  -32, -28, -24, -20, -16, -14, -14, -14, -11, -11, -8, -4, 2, 4, 8, 12, 16, 21, 25, 28, 32, 32,
+  -32, -28, -24, -21, -17, -13, -12, -12, -12, -9, -5, -2, 1, 5, 8, 13, 16, 20, 24, 28, 32, 32,
+  -32, -28, -24, -20, -16, -12, -10, -10, -10, -10, -6, -3, 0, 4, 10, 12, 16, 20, 24, 28, 33, 33,
+  -32, -29, -24, -20, -16, -12, -11, -7, -7, -7, -7, -4, 2, 5, 9, 13, 16, 20, 25, 28, 32, 32,
+  -32, -28, -24, -20, -16, -12, -8, -8, -8, -8, -5, -2, 2, 5, 8, 12, 17, 21, 24, 28, 32, 32,
+  -32, -28, -24, -21, -17, -12, -8, -6, -6, -6, -6, -3, 1, 4, 9, 13, 17, 20, 24, 28, 32, 32,
+  -32, -28, -24, -20, -16, -13, -9, -6, -4, -4, -4, 0, 0, 6, 8, 12, 16, 20, 24, 29, 32, 32,
+  -33, -28, -24, -20, -16, -13, -9, -5, -4, -2, -1, -1, 2, 5, 9, 12, 16, 21, 24, 28, 32, 32,
+  -32, -28, -24, -20, -16, -12, -8, -5, -3, -2, -2, 1, 1, 4, 8, 13, 17, 20, 24, 28, 33, 33,
+  -32, -28, -25, -21, -16, -12, -8, -6, -2, -1, 0, 0, 3, 7, 9, 13, 16, 20, 24, 28, 32, 32,
+  -32, -28, -24, -20, -17, -12, -9, -4, 0, 0, 1, 2, 2, 6, 9, 12, 16, 21, 25, 28, 32, 32,
+  -32, -28, -24, -20, -17, -13, -8, -4, -1, 2, 2, 4, 5, 5, 8, 12, 17, 20, 25, 28, 32, 32,
+  -32, -28, -24, -20, -16, -12, -8, -5, -2, 1, 5, 5, 7, 7, 10, 14, 16, 20, 24, 29, 33, 33,
+  -32, -29, -25, -20, -16, -12, -9, -5, 0, 4, 4, 7, 7, 9, 9, 13, 16, 20, 24, 28, 32, 32,
+  -32, -28, -24, -20, -16, -13, -8, -4, -1, 3, 6, 6, 9, 9, 11, 12, 17, 21, 24, 28, 32, 32,
+  -32, -28, -24, -21, -16, -12, -8, -4, 0, 2, 8, 8, 8, 10, 12, 13, 17, 21, 24, 28, 32, 32,
+  -32, -28, -24, -20, -16, -12, -9, -5, -1, 4, 7, 11, 11, 11, 12, 13, 16, 20, 25, 29, 32, 32,
+  -33, -28, -24, -20, -16, -13, -9, -4, 0, 3, 6, 10, 13, 13, 13, 14, 16, 20, 24, 28, 32, 32,
+  -32, -28, -24, -20, -17, -12, -8, -5, -1, 2, 5, 12, 12, 15, 15, 15, 17, 20, 24, 28, 32, 32,
+  -32, -28, -25, -20, -16, -12, -8, -4, -2, 4, 8, 11, 14, 14, 14, 15, 18, 20, 24, 28, 32, 32,
+  -32, -28, -24, -20, -16, -12, -8, -5, 0, 3, 7, 10, 13, 17, 17, 17, 17, 21, 25, 29, 32, 32,
+  -32, -28, -24, -20, -17, -13, -8, -4, 0, 4, 6, 12, 16, 16, 19, 19, 19, 21, 24, 28, 32, 32,
+  -32, -28, -24, -21, -16, -12, -9, -4, -1, 3, 8, 11, 15, 18, 18, 21, 21, 21, 24, 28, 33, 33,
+  -32, -29, -24, -20, -16, -12, -8, -5, 0, 4, 7, 10, 14, 20, 20, 20, 20, 20, 24, 28, 33, 33,
+  -32, -28, -24, -20, -16, -12, -9, -4, -1, 3, 7, 9, 16, 19, 19, 19, 23, 23, 25, 28, 32, 32,
+  -32, -28, -24, -20, -17, -12, -8, -4, 0, 4, 8, 12, 15, 18, 22, 22, 22, 22, 24, 28, 32, 32,
+  -32, -28, -25, -20, -16, -13, -8, -5, -1, 4, 7, 11, 14, 17, 21, 24, 24, 24, 25, 29, 32, 32,
+  /* segment 2, gradient -4 */
+  -32, -29, -24, -21, -16, -15, -15, -15, -15, -12, -8, -2, 2, 5, 8, 12, 17, 20, 24, 28, 32, 32,
+  -32, -28, -24, -21, -16, -13, -13, -13, -13, -9, -6, -3, 1, 4, 9, 13, 16, 21, 24, 28, 33, 33,
+  -32, -28, -24, -20, -16, -14, -14, -10, -10, -10, -7, -4, 0, 4, 8, 12, 16, 20, 25, 28, 32, 32,
+  -32, -28, -24, -20, -17, -13, -11, -11, -11, -11, -8, -1, 2, 5, 9, 12, 17, 20, 24, 28, 32, 32,
+  -32, -28, -25, -20, -16, -12, -12, -12, -12, -9, -6, -2, 1, 4, 8, 13, 16, 20, 24, 28, 32, 32,
+  -32, -28, -25, -20, -16, -12, -10, -10, -10, -7, -7, -3, 0, 5, 9, 13, 17, 20, 24, 29, 32, 32,
+  -32, -28, -24, -20, -16, -13, -8, -8, -8, -8, -8, -4, 2, 6, 8, 12, 16, 21, 25, 28, 32, 32,
+  -32, -28, -24, -20, -17, -13, -9, -9, -5, -5, -5, -2, 1, 5, 8, 13, 16, 21, 24, 28, 32, 32,
+  -32, -28, -24, -20, -16, -12, -9, -6, -6, -6, -3, -3, 0, 4, 10, 12, 16, 20, 24, 28, 33, 33,
+  -32, -29, -24, -20, -16, -12, -9, -5, -4, -4, -4, -1, 3, 6, 9, 13, 16, 20, 25, 28, 32, 32,
+  -32, -28, -24, -20, -16, -12, -8, -4, -3, -2, -2, -2, 2, 5, 8, 12, 17, 21, 24, 28, 32, 32,
+  -32, -28, -24, -21, -17, -12, -8, -4, -3, -1, 1, 1, 1, 4, 9, 13, 17, 20, 24, 28, 32, 32,
+  -32, -28, -24, -20, -16, -13, -8, -5, -2, 0, 0, 3, 3, 6, 9, 12, 16, 20, 24, 29, 32, 32,
+  -33, -28, -24, -20, -16, -13, -9, -4, 0, 0, 2, 2, 5, 5, 9, 12, 16, 21, 24, 29, 32, 32,
+  -32, -28, -24, -20, -16, -12, -8, -5, -1, 2, 2, 4, 4, 8, 8, 13, 17, 20, 24, 28, 33, 33,
+  -32, -28, -25, -21, -16, -12, -8, -6, -1, 4, 4, 4, 7, 7, 10, 13, 17, 20, 24, 28, 32, 32,
+  -32, -28, -24, -20, -17, -12, -9, -4, 0, 3, 3, 7, 8, 9, 9, 12, 16, 21, 25, 28, 32, 32,
+  -32, -28, -24, -20, -17, -12, -8, -4, 0, 2, 6, 6, 9, 10, 11, 14, 17, 20, 25, 28, 32, 32,
+  -32, -28, -24, -20, -16, -12, -8, -5, -1, 2, 8, 8, 8, 11, 12, 14, 16, 20, 24, 29, 33, 33,
+  -32, -29, -24, -20, -16, -12, -9, -5, 0, 4, 7, 10, 10, 10, 13, 14, 16, 20, 24, 28, 32, 32,
+  -32, -28, -24, -20, -16, -13, -8, -4, -1, 3, 6, 9, 13, 13, 13, 15, 17, 21, 24, 28, 32, 32,
+  -32, -28, -24, -21, -16, -12, -8, -4, 0, 2, 8, 12, 12, 15, 15, 15, 17, 21, 24, 28, 32, 32,
+  -32, -28, -24, -20, -16, -12, -9, -4, -1, 4, 7, 11, 14, 14, 17, 17, 17, 20, 25, 29, 32, 32,
+  -33, -28, -24, -20, -16, -13, -9, -4, 0, 4, 6, 10, 16, 16, 16, 16, 20, 20, 25, 28, 32, 32,
+  -32, -28, -24, -20, -17, -12, -8, -5, -1, 3, 6, 12, 15, 19, 19, 19, 19, 21, 24, 28, 32, 32,
+  -32, -28, -25, -20, -16, -12, -8, -4, -2, 4, 8, 11, 14, 18, 18, 21, 21, 22, 24, 28, 32, 32,
+  -32, -28, -24, -20, -16, -12, -8, -5, 0, 3, 7, 10, 13, 20, 20, 23, 23, 23, 25, 29, 32, 32,
+  -32, -28, -24, -20, -16, -13, -8, -4, 0, 4, 8, 12, 16, 19, 22, 22, 22, 22, 24, 28, 32, 32,
+  -32, -28, -24, -21, -16, -12, -9, -4, -1, 3, 8, 11, 15, 18, 21, 21, 21, 25, 25, 28, 33, 33,
+  -32, -29, -24, -20, -16, -12, -8, -5, 0, 4, 7, 10, 14, 20, 24, 24, 24, 24, 24, 28, 33, 33,
+  -32, -28, -24, -20, -16, -12, -8, -4, 0, 3, 7, 10, 16, 19, 23, 26, 26, 26, 26, 28, 32, 32,
+  /* segment 3, gradient 0 */
+  -33, -28, -25, -20, -19, -19, -19, -19, -16, -12, -6, -2, 1, 4, 8, 13, 16, 20, 24, 28, 32, 32,
+  -32, -28, -25, -20, -17, -17, -17, -17, -13, -10, -7, -3, 0, 5, 9, 12, 17, 20, 24, 29, 32, 32,
+  -32, -28, -24, -20, -18, -18, -14, -14, -14, -11, -8, -4, 0, 4, 8, 12, 16, 21, 24, 28, 32, 32,
+  -32, -28, -24, -21, -17, -15, -15, -15, -15, -12, -5, -2, 1, 5, 8, 13, 16, 20, 24, 28, 32, 32,
+  -32, -29, -24, -20, -16, -16, -16, -16, -13, -10, -6, -3, 0, 4, 9, 12, 16, 20, 24, 28, 33, 33,
+  -32, -29, -24, -20, -16, -14, -14, -14, -11, -11, -7, -4, 1, 5, 9, 13, 16, 20, 25, 28, 32, 32,
+  -32, -28, -24, -20, -17, -12, -12, -12, -12, -12, -8, -2, 2, 4, 8, 12, 17, 21, 24, 28, 32, 32,
+  -32, -28, -24, -21, -17, -13, -13, -9, -9, -9, -6, -3, 1, 4, 9, 12, 17, 20, 24, 28, 32, 32,
+  -32, -28, -24, -20, -16, -13, -10, -10, -10, -7, -7, -4, 0, 6, 8, 12, 16, 20, 24, 29, 32, 32,
+  -33, -28, -24, -20, -16, -13, -9, -8, -8, -8, -5, -1, 2, 5, 9, 12, 16, 21, 24, 28, 32, 32,
+  -32, -28, -24, -20, -16, -12, -8, -7, -6, -6, -6, -2, 1, 4, 8, 13, 17, 20, 24, 28, 32, 32,
+  -32, -28, -25, -21, -16, -12, -8, -7, -5, -3, -3, -3, 0, 5, 9, 13, 16, 20, 24, 28, 32, 32,
+  -32, -28, -24, -20, -17, -12, -9, -6, -4, -4, -1, -1, 2, 5, 8, 12, 16, 20, 25, 28, 32, 32,
+  -32, -28, -24, -20, -17, -13, -8, -4, -4, -2, -2, 1, 1, 5, 8, 12, 17, 20, 25, 28, 32, 32,
+  -32, -28, -24, -20, -16, -12, -9, -5, -2, -2, 0, 0, 4, 4, 9, 13, 16, 20, 24, 29, 33, 33,
+  -32, -29, -25, -20, -16, -12, -10, -5, 0, 0, 0, 3, 3, 6, 9, 13, 16, 20, 24, 28, 32, 32,
+  -32, -28, -24, -21, -16, -13, -8, -4, -1, -1, 3, 4, 5, 5, 8, 12, 17, 21, 24, 28, 32, 32,
+  -32, -28, -24, -21, -16, -12, -8, -4, -2, 2, 2, 5, 6, 7, 10, 13, 16, 21, 24, 28, 32, 32,
+  -32, -28, -24, -20, -16, -12, -9, -5, -2, 4, 4, 4, 7, 8, 10, 12, 16, 20, 25, 29, 32, 32,
+  -33, -28, -24, -20, -16, -13, -9, -4, 0, 3, 6, 6, 6, 9, 10, 12, 16, 20, 24, 28, 32, 32,
+  -32, -28, -24, -20, -17, -12, -8, -5, -1, 2, 5, 9, 9, 9, 11, 13, 17, 20, 24, 28, 32, 32,
+  -32, -28, -25, -20, -16, -12, -8, -4, -2, 4, 8, 8, 11, 11, 11, 13, 17, 20, 24, 28, 32, 32,
+  -32, -28, -24, -20, -16, -13, -8, -5, 0, 3, 7, 10, 10, 13, 13, 13, 16, 21, 25, 28, 32, 32,
+  -32, -28, -24, -20, -17, -13, -8, -4, 0, 2, 6, 12, 12, 12, 12, 16, 16, 21, 24, 28, 32, 32,
+  -32, -28, -24, -21, -16, -12, -9, -5, -1, 2, 8, 11, 15, 15, 15, 15, 17, 20, 24, 28, 33, 33,
+  -32, -29, -24, -20, -16, -12, -8, -6, 0, 4, 7, 10, 14, 14, 17, 17, 18, 20, 24, 28, 33, 33,
+  -32, -28, -24, -20, -16, -12, -9, -4, -1, 3, 6, 9, 16, 16, 19, 19, 19, 21, 25, 28, 32, 32,
+  -32, -28, -24, -20, -17, -12, -8, -4, 0, 4, 8, 12, 15, 18, 18, 18, 18, 20, 24, 28, 32, 32,
+  -32, -28, -25, -20, -16, -13, -8, -5, -1, 4, 7, 11, 14, 17, 17, 17, 21, 21, 24, 29, 32, 32,
+  -33, -28, -24, -20, -16, -12, -9, -4, 0, 3, 6, 10, 16, 20, 20, 20, 20, 20, 24, 29, 32, 32,
+  -32, -28, -24, -20, -16, -12, -8, -4, -1, 3, 6, 12, 15, 19, 22, 22, 22, 22, 24, 28, 32, 32,
+  /* segment 4, gradient 4 */
+  -32, -29, -24, -23, -23, -23, -23, -20, -16, -10, -6, -3, 0, 4, 9, 12, 16, 20, 24, 28, 33, 33,
+  -32, -29, -24, -21, -21, -21, -21, -17, -14, -11, -7, -4, 1, 5, 8, 13, 16, 20, 25, 28, 32, 32,
+  -32, -28, -24, -22, -22, -18, -18, -18, -15, -12, -8, -4, 0, 4, 8, 12, 17, 20, 24, 28, 32, 32,
+  -32, -28, -25, -21, -19, -19, -19, -19, -16, -9, -6, -3, 1, 4, 9, 12, 16, 20, 24, 28, 32, 32,
+  -33, -28, -24, -20, -20, -20, -20, -17, -14, -10, -7, -4, 0, 5, 8, 12, 16, 20, 24, 29, 32, 32,
+  -33, -28, -24, -20, -18, -18, -18, -15, -15, -11, -8, -3, 1, 5, 9, 12, 16, 21, 24, 28, 32, 32,
+  -32, -28, -24, -21, -16, -16, -16, -16, -16, -12, -6, -2, 0, 4, 8, 13, 17, 20, 24, 28, 32, 32,
+  -32, -28, -25, -21, -17, -17, -13, -13, -13, -10, -7, -3, 0, 5, 8, 13, 16, 20, 24, 28, 32, 32,
+  -32, -28, -24, -20, -17, -14, -14, -14, -11, -11, -8, -4, 2, 4, 8, 12, 16, 20, 25, 28, 32, 32,
+  -32, -28, -24, -20, -17, -13, -12, -12, -12, -9, -5, -2, 1, 5, 8, 12, 17, 20, 24, 28, 32, 32,
+  -32, -28, -24, -20, -16, -12, -11, -10, -10, -10, -6, -3, 0, 4, 9, 13, 16, 20, 24, 28, 33, 33,
+  -32, -29, -25, -20, -16, -12, -11, -9, -7, -7, -7, -4, 1, 5, 9, 12, 16, 20, 24, 28, 32, 32,
+  -32, -28, -24, -21, -16, -13, -10, -8, -8, -5, -5, -2, 1, 4, 8, 12, 16, 21, 24, 28, 32, 32,
+  -32, -28, -24, -21, -17, -12, -8, -8, -6, -6, -3, -3, 1, 4, 8, 13, 16, 21, 24, 28, 32, 32,
+  -32, -28, -24, -20, -16, -13, -9, -6, -6, -4, -4, 0, 0, 5, 9, 12, 16, 20, 25, 29, 32, 32,
+  -33, -29, -24, -20, -16, -14, -9, -4, -4, -4, -1, -1, 2, 5, 9, 12, 16, 20, 24, 28, 32, 32,
+  -32, -28, -25, -20, -17, -12, -8, -5, -5, -1, 0, 1, 1, 4, 8, 13, 17, 20, 24, 28, 32, 32,
+  -32, -28, -25, -20, -16, -12, -8, -6, -2, -2, 1, 2, 3, 6, 9, 12, 17, 20, 24, 28, 32, 32,
+  -32, -28, -24, -20, -16, -13, -9, -6, 0, 0, 0, 3, 4, 6, 8, 12, 16, 21, 25, 28, 32, 32,
+  -32, -28, -24, -20, -17, -13, -8, -4, -1, 2, 2, 2, 5, 6, 8, 12, 16, 20, 24, 28, 32, 32,
+  -32, -28, -24, -21, -16, -12, -9, -5, -2, 1, 5, 5, 5, 7, 9, 13, 16, 20, 24, 28, 33, 33,
+  -32, -29, -24, -20, -16, -12, -8, -6, 0, 4, 4, 7, 7, 7, 9, 13, 16, 20, 24, 28, 32, 32,
+  -32, -28, -24, -20, -17, -12, -9, -4, -1, 3, 6, 6, 9, 9, 9, 12, 17, 21, 24, 28, 32, 32,
+  -32, -28, -24, -21, -17, -12, -8, -4, -2, 2, 8, 8, 8, 8, 12, 12, 17, 20, 24, 28, 32, 32,
+  -32, -28, -25, -20, -16, -13, -9, -5, -2, 4, 7, 11, 11, 11, 11, 13, 16, 20, 24, 29, 32, 32,
+  -33, -28, -24, -20, -16, -12, -10, -4, 0, 3, 6, 10, 10, 13, 13, 14, 16, 20, 24, 29, 32, 32,
+  -32, -28, -24, -20, -16, -13, -8, -5, -1, 2, 5, 12, 12, 15, 15, 15, 17, 21, 24, 28, 32, 32,
+  -32, -28, -24, -21, -16, -12, -8, -4, 0, 4, 8, 11, 14, 14, 14, 14, 16, 20, 24, 28, 32, 32,
+  -32, -29, -24, -20, -17, -12, -9, -5, 0, 3, 7, 10, 13, 13, 13, 17, 17, 20, 25, 28, 32, 32,
+  -32, -28, -24, -20, -16, -13, -8, -4, -1, 2, 6, 12, 16, 16, 16, 16, 16, 20, 25, 28, 33, 33,
+  -32, -28, -24, -20, -16, -12, -8, -5, -1, 2, 8, 11, 15, 18, 18, 18, 18, 20, 24, 28, 32, 32,
+  /* segment 5, gradient 2 */
+  -32, -28, -24, -21, -21, -21, -21, -18, -14, -11, -8, -4, 0, 4, 8, 12, 16, 21, 24, 28, 32, 32,
+  -32, -28, -24, -21, -19, -19, -19, -19, -15, -12, -5, -3, 1, 5, 8, 13, 16, 20, 24, 28, 32, 32,
+  -32, -29, -24, -20, -20, -16, -16, -16, -16, -10, -6, -3, 0, 4, 9, 12, 16, 20, 24, 28, 33, 33,
+  -32, -29, -24, -20, -17, -17, -17, -17, -14, -11, -7, -4, 1, 5, 8, 13, 16, 20, 25, 28, 32, 32,
+  -32, -28, -24, -20, -18, -18, -18, -15, -15, -12, -8, -2, 0, 4, 8, 12, 17, 21, 24, 28, 32, 32,
+  -32, -28, -25, -21, -17, -16, -16, -16, -13, -9, -6, -3, 1, 4, 9, 12, 16, 20, 24, 28, 32, 32,
+  -32, -28, -24, -20, -16, -14, -14, -14, -14, -10, -7, -4, 0, 6, 8, 12, 16, 20, 24, 29, 32, 32,
+  -33, -28, -24, -20, -16, -15, -11, -11, -11, -11, -8, -2, 1, 5, 9, 12, 16, 21, 24, 28, 32, 32,
+  -32, -28, -24, -20, -16, -12, -12, -12, -12, -9, -6, -2, 1, 4, 8, 13, 17, 20, 24, 28, 32, 32,
+  -32, -28, -25, -21, -16, -12, -10, -10, -10, -10, -7, -3, 0, 5, 9, 13, 16, 20, 24, 28, 32, 32,
+  -32, -28, -24, -20, -17, -13, -10, -8, -8, -8, -4, -4, 2, 4, 8, 12, 16, 20, 25, 28, 32, 32,
+  -32, -28, -24, -20, -17, -13, -9, -8, -6, -5, -5, -2, 1, 5, 8, 12, 17, 20, 24, 28, 32, 32,
+  -32, -28, -24, -20, -16, -12, -9, -7, -6, -6, -3, -3, 0, 4, 9, 13, 16, 20, 24, 29, 33, 33,
+  -32, -29, -25, -20, -16, -12, -10, -6, -5, -4, -4, -1, 3, 5, 9, 12, 16, 20, 24, 28, 32, 32,
+  -32, -28, -24, -21, -16, -13, -8, -4, -4, -3, -2, -2, 2, 5, 8, 12, 17, 21, 24, 28, 32, 32,
+  -32, -28, -24, -21, -17, -12, -8, -5, -2, -2, 0, 1, 1, 4, 8, 13, 16, 21, 24, 28, 32, 32,
+  -32, -28, -24, -20, -16, -12, -9, -6, -3, 1, 1, 3, 3, 6, 10, 12, 16, 20, 25, 29, 32, 32,
+  -33, -29, -24, -20, -16, -13, -9, -4, 0, 0, 3, 3, 5, 5, 9, 12, 16, 20, 24, 28, 32, 32,
+  -32, -28, -24, -20, -17, -12, -8, -5, -1, 2, 2, 5, 5, 7, 8, 13, 17, 20, 24, 28, 32, 32,
+  -32, -28, -25, -20, -16, -12, -8, -4, -2, 4, 4, 4, 6, 8, 9, 13, 17, 20, 24, 28, 32, 32,
+  -32, -28, -24, -20, -16, -13, -9, -5, 0, 3, 7, 7, 7, 8, 9, 12, 16, 21, 25, 28, 32, 32,
+  -32, -28, -24, -20, -17, -13, -8, -4, -1, 2, 6, 9, 9, 9, 10, 12, 16, 20, 24, 28, 32, 32,
+  -32, -28, -24, -21, -16, -12, -9, -5, -2, 1, 8, 8, 11, 11, 11, 13, 16, 20, 24, 28, 33, 33,
+  -32, -29, -24, -20, -16, -12, -8, -6, 0, 4, 7, 10, 10, 10, 11, 14, 16, 20, 24, 28, 32, 32,
+  -32, -28, -24, -20, -16, -12, -9, -4, -1, 3, 6, 9, 13, 13, 13, 13, 17, 21, 25, 28, 32, 32,
+  -32, -28, -24, -21, -17, -12, -8, -4, 0, 2, 8, 12, 12, 15, 15, 15, 17, 20, 24, 28, 32, 32,
+  -32, -28, -25, -20, -16, -13, -8, -5, -1, 4, 7, 11, 14, 14, 17, 17, 17, 20, 24, 29, 32, 32,
+  -33, -28, -24, -20, -16, -12, -9, -4, 0, 3, 6, 10, 16, 16, 16, 16, 16, 20, 24, 29, 32, 32,
+  -32, -28, -24, -20, -16, -13, -8, -5, -1, 3, 5, 12, 15, 15, 15, 19, 19, 21, 24, 28, 32, 32,
+  -32, -28, -24, -21, -16, -12, -8, -4, 0, 4, 8, 11, 14, 18, 18, 18, 18, 20, 24, 28, 32, 32,
+  -32, -29, -24, -20, -17, -12, -9, -5, 0, 3, 7, 10, 13, 17, 20, 20, 20, 21, 25, 28, 32, 32,
+};
+
+const struct control_mpc control_mpc_lab = {&track_lab, control_mpc_lab_throttle};
@@ -0,0 +1,62 @@
+/* Q16.16 fixed-point arithmetic
+ *
+ * Description:
+ *
+ *   Signed numbers with 16 integer and 16 fractional bits in an INT32S.
+ *   Additions and multiplications saturate at the ends of the range
+ *   instead of wrapping, so an out of range velocity stays extreme rather
+ *   than changing sign. Only integer instructions are used, which the
+ *   Nios II executes in hardware.
+ */
+#ifndef FIX16_H
+#define FIX16_H
+
+#include <stdint.h>
+
+typedef int32_t fix16;
+
+#define FIX16_ONE  ((fix16) 0x00010000)
+#define FIX16_MAX  ((fix16) 0x7FFFFFFF)
+#define FIX16_MIN  ((fix16) -0x7FFFFFFF - 1)
+
+/* Constant conversion, e.g. FIX16_C(0.3) */
+#define FIX16_C(x) ((fix16) ((x) * 65536.0 + ((x) >= 0 ? 0.5 : -0.5)))
+
+static inline fix16 fix16_sat(int64_t x)
+{
+  return x > FIX16_MAX ? FIX16_MAX : x < FIX16_MIN ? FIX16_MIN : (fix16) x;
+}
+
+static inline fix16 fix16_from_int(int32_t i)
+{
+  return fix16_sat((int64_t) i * FIX16_ONE);
+}
+
+/* Integer part, rounded towards zero like a C cast */
+static inline int32_t fix16_to_int(fix16 a)
+{
+  return a >= 0 ? a >> 16 : -(int32_t) ((-(int64_t) a) >> 16);
+}
+
+static inline fix16 fix16_add(fix16 a, fix16 b)
+{
+  return fix16_sat((int64_t) a + b);
+}
+
+static inline fix16 fix16_sub(fix16 a, fix16 b)
+{
+  return fix16_sat((int64_t) a - b);
+}
+
+/* Product rounded to nearest */
+static inline fix16 fix16_mul(fix16 a, fix16 b)
+{
+  return fix16_sat(((int64_t) a * b + 0x8000) >> 16);
+}
+
+static inline fix16 fix16_mul_int(fix16 a, int32_t k)
+{
+  return fix16_sat((int64_t) a * k);
+}
+
+#endif /* FIX16_H */
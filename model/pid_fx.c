@@ -0,0 +1,43 @@
+/* Fixed-point incremental PID controller, see pid_fx.h */
+#include "pid_fx.h"
+
+void pid_fx_init(struct pid_fx *pid, int q, int32_t kp, int32_t ki, int32_t kd,
+                 int32_t out_min, int32_t out_max)
+{
+  pid->q       = q;
+  pid->kp      = kp;
+  pid->ki      = ki;
+  pid->kd      = kd;
+  pid->out_min = out_min;
+  pid->out_max = out_max;
+  pid_fx_reset(pid, out_min);
+}
+
+void pid_fx_reset(struct pid_fx *pid, int32_t out)
+{
+  pid->out = out;
+  pid->e1  = 0;
+  pid->e2  = 0;
+}
+
+int32_t pid_fx_step(struct pid_fx *pid, int32_t error)
+{
+  int64_t du;
+  int64_t out;
+
+  du = (int64_t) pid->kp * ((int64_t) error - pid->e1) +
+       (int64_t) pid->ki * error +
+       (int64_t) pid->kd * ((int64_t) error - 2 * (int64_t) pid->e1 + pid->e2);
+  out = pid->out + ((du + ((int64_t) 1 << (pid->q - 1))) >> pid->q);
+
+  // Anti-windup: the output, which holds the integral action, stays in range
+  if (out > pid->out_max)
+    out = pid->out_max;
+  else if (out < pid->out_min)
+    out = pid->out_min;
+
+  pid->e2  = pid->e1;
+  pid->e1  = error;
+  pid->out = (int32_t) out;
+  return pid->out;
+}
@@ -0,0 +1,50 @@
+/* Fixed-point incremental PID controller
+ *
+ * Description:
+ *
+ *   Velocity form of the PID law: every call adds
+ *
+ *     kp * (e[k] - e[k-1]) + ki * e[k] + kd * (e[k] - 2 e[k-1] + e[k-2])
+ *
+ *   to the previous output and clamps the sum to [out_min, out_max]. The
+ *   integral action lives in the output itself, so a saturated output
+ *   cannot wind up, and the derivative uses the errors of the last two
+ *   periods. The gains are per sample (the sampling period is folded in).
+ *
+ *   Gains, errors and outputs are integers with q (1..24) fractional bits, q being
+ *   chosen per controller (PID_FX_Q by default); products are formed in 64
+ *   bits and rounded back to q bits, so no floating point is involved.
+ */
+#ifndef PID_FX_H
+#define PID_FX_H
+
+#include <stdint.h>
+
+/* Fractional bits used when the caller has no reason to choose */
+#define PID_FX_Q 16
+
+/* Constant conversion to q fractional bits, e.g. PID_FX_C(0.5, PID_FX_Q) */
+#define PID_FX_C(x, q) ((int32_t) ((x) * (double) (1L << (q)) + ((x) >= 0 ? 0.5 : -0.5)))
+
+struct pid_fx {
+  int     q;        /* fractional bits of everything below */
+  int32_t kp;
+  int32_t ki;
+  int32_t kd;
+  int32_t out_min;
+  int32_t out_max;
+  int32_t out;      /* last output */
+  int32_t e1;       /* error of the last call */
+  int32_t e2;       /* error of the call before */
+};
+
+void    pid_fx_init(struct pid_fx *pid, int q, int32_t kp, int32_t ki, int32_t kd,
+                    int32_t out_min, int32_t out_max);
+
+/* Restarts from output 'out' without a bump, e.g. when the loop is closed */
+void    pid_fx_reset(struct pid_fx *pid, int32_t out);
+
+/* One period: takes the error, returns the new output (both with q bits) */
+int32_t pid_fx_step(struct pid_fx *pid, int32_t error);
+
+#endif /* PID_FX_H */
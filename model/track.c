@@ -0,0 +1,65 @@
+/* Track profile of the cruise control lab, see track.h */
+#include "track.h"
+#include "vehicle.h"
+
+static const struct track_segment track_lab_segment[] = {
+  {    0,                   0 },
+  {  400,     -GRAVITY_FACTOR },  // uphill
+  {  800, -2 * GRAVITY_FACTOR },  // steep uphill
+  { 1200,                   0 },
+  { 1600,  2 * GRAVITY_FACTOR },  // downhill
+  { 2000,      GRAVITY_FACTOR },  // steep downhill
+};
+
+/* 256 m buckets: segment at 0, 256, 512, ..., 2304 m */
+static const INT32U track_lab_bucket[] = {0, 0, 1, 1, 2, 3, 3, 4, 5, 5};
+
+const struct track track_lab = {
+  TRACK_LENGTH,
+  sizeof(track_lab_segment) / sizeof(track_lab_segment[0]),
+  track_lab_segment,
+  8,
+  track_lab_bucket,
+};
+
+const struct track *track_default = &track_lab;
+
+INT32U track_buckets(const struct track_segment *segment, INT32U segments, INT32U length,
+                     INT32U *shift)
+{
+  INT32U shortest = length + 1;
+  INT32U end, i;
+
+  if (length == 0 || segments == 0 || segment[0].start != 0)
+    return 0;
+  for (i = 0; i < segments; i++) {
+    end = i + 1 < segments ? segment[i + 1].start : length + 1;
+    if (end <= segment[i].start || end > length + 1)
+      return 0;
+    if (end - segment[i].start < shortest)
+      shortest = end - segment[i].start;
+  }
+  for (*shift = 0; (2u << *shift) <= shortest && *shift < 31; (*shift)++)
+    ;
+  return (length >> *shift) + 1;
+}
+
+void track_index(struct track *track, INT32U *bucket)
+{
+  INT32U n = (track->length >> track->shift) + 1;
+  INT32U i, b;
+
+  for (b = 0, i = 0; b < n; b++) {
+    while (i + 1 < track->segments && track->segment[i + 1].start <= b << track->shift)
+      i++;
+    bucket[b] = i;
+  }
+  track->bucket = bucket;
+}
+
+INT32U track_section(const struct track *track, INT32U position, INT32U sections)
+{
+  INT32U s = (INT32U) ((unsigned long long) position * sections / track->length);
+
+  return s < sections ? s : sections - 1;
+}
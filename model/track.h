@@ -0,0 +1,82 @@
+/* Track profile of the cruise control lab
+ *
+ * Description:
+ *
+ *   A track is a table of segments of constant slope. The slope of a
+ *   segment is given as the acceleration it adds to the vehicle, negative
+ *   uphill. Past its length the vehicle starts over at 0 m.
+ *
+ *   The gradient at a position is found in constant time through a bucket
+ *   index: the track is cut into buckets of 2^shift m, none longer than
+ *   the shortest segment, and the index holds the segment each bucket
+ *   starts in. A position is then either in that segment or in the next
+ *   one.
+ *
+ *   track_lab is the 2400 m track of the lab, compiled in with its index.
+ *   Tables made at run time get their index from track_index(). The host
+ *   programs read them from a binary file (host/sim/track_file.h).
+ */
+#ifndef TRACK_H
+#define TRACK_H
+
+#include "includes.h"
+
+/* Length of the lab track */
+#define TRACK_LENGTH      2400
+
+struct track_segment {
+  INT32U start;     /* m from the beginning, increasing, the first one is 0 */
+  INT16S gradient;  /* m/s^2 added to the acceleration of the vehicle */
+};
+
+struct track {
+  INT32U length;                        /* m */
+  INT32U segments;
+  const struct track_segment *segment;
+  INT32U shift;                         /* buckets of 2^shift m */
+  const INT32U *bucket;                 /* (length >> shift) + 1 entries */
+};
+
+extern const struct track track_lab;
+
+/* Track of the vehicles and controllers initialized from now on */
+extern const struct track *track_default;
+
+/*
+ * Returns the number of buckets track_index() fills for these segments
+ * and sets *shift, 0 if the table is not a valid track
+ */
+INT32U track_buckets(const struct track_segment *segment, INT32U segments, INT32U length,
+                     INT32U *shift);
+
+/* Indexes 'track' (all but bucket set, shift from track_buckets()) into 'bucket' */
+void   track_index(struct track *track, INT32U *bucket);
+
+/* Which of 'sections' equal parts of the track 'position' is in */
+INT32U track_section(const struct track *track, INT32U position, INT32U sections);
+
+/* Index of the segment 'position' is in, the last one past the end */
+static inline INT32U track_segment_at(const struct track *track, INT32U position)
+{
+  INT32U i;
+
+  if (position > track->length)
+    position = track->length;
+  i = track->bucket[position >> track->shift];
+  if (i + 1 < track->segments && track->segment[i + 1].start <= position)
+    i++;
+  return i;
+}
+
+static inline INT16S track_gradient(const struct track *track, INT32U position)
+{
+  return track->segment[track_segment_at(track, position)].gradient;
+}
+
+/* First metre past segment i, length + 1 for the last one */
+static inline INT32U track_segment_end(const struct track *track, INT32U i)
+{
+  return i + 1 < track->segments ? track->segment[i + 1].start : track->length + 1;
+}
+
+#endif /* TRACK_H */
@@ -0,0 +1,156 @@
+/* Vehicle model of the cruise control lab, see vehicle.h
+ *
+ * The car model is equivalent to moving mass with linear resistances acting upon it.
+ * Therefore, if left one, it will stably stop as the velocity converges to zero on a flat surface.
+ * You can prove that easily via basic LTI systems methods.
+ */
+#include <stdint.h>
+
+#include "vehicle.h"
+
+void vehicle_init(struct vehicle_state *state)
+{
+  state->track = track_default;
+  state->position = 0;
+  state->velocity = 0;
+  state->wind_factor = WIND_FACTOR;
+#ifdef VEHICLE_FIXED_POINT
+  vehicle_fx_init(&state->fx);
+#endif
+}
+
+/* Velocity after one period, from the state at its beginning */
+static INT16S vehicle_velocity(const struct vehicle_state *state, const struct vehicle_inputs *in)
+{
+  // constants that should not be modified
+  const unsigned int wind_factor = state->wind_factor;
+  const unsigned int brake_factor = BRAKE_FACTOR;
+  INT16S velocity = state->velocity;
+  INT16S acceleration;
+  INT8U throttle = in->throttle;
+
+  // vehichle cannot effort more than 80 units of throttle
+  if (throttle > MAX_THROTTLE)
+    throttle = MAX_THROTTLE;
+
+  // brakes + wind
+  if (in->brake_pedal == off)
+  {
+    // wind resistance
+    acceleration = -wind_factor * velocity;
+    // actuate with engines
+    if (in->engine == on)
+      acceleration += throttle;
+
+    // gravity effects of the slope under the vehicle
+    acceleration += track_gradient(state->track, state->position);
+  }
+  // if the engine and the brakes are activated at the same time,
+  // we assume that the brake dynamics dominates, so both cases fall
+  // here.
+  else
+    acceleration = -brake_factor * velocity;
+
+  return velocity + acceleration * VEHICLE_STEP_MS / 1000.0;
+}
+
+#ifdef VEHICLE_FIXED_POINT
+/* Hands what the caller may have set in the whole-unit state over to the
+   fixed-point one: the track, the wind and a new position or velocity */
+static void vehicle_fx_sync(struct vehicle_state *state)
+{
+  state->fx.track = state->track;
+  state->fx.wind_factor = state->wind_factor;
+  if ((INT32U) (state->fx.position >> 16) != state->position)
+    state->fx.position = (int64_t) state->position << 16;
+  if (fix16_to_int(state->fx.velocity) != state->velocity)
+    state->fx.velocity = fix16_from_int(state->velocity);
+}
+#endif
+
+void vehicle_step(struct vehicle_state *state, const struct vehicle_inputs *in)
+{
+  INT32U position = state->position;
+  INT16S velocity = state->velocity;
+
+#ifdef VEHICLE_FIXED_POINT
+  vehicle_fx_sync(state);
+  vehicle_fx_step(&state->fx, in);
+  state->position = (INT32U) (state->fx.position >> 16);
+  state->velocity = fix16_to_int(state->fx.velocity);
+  return;
+#endif
+
+  position = position + velocity * VEHICLE_STEP_MS / 1000;
+  velocity = vehicle_velocity(state, in);
+  // reset the position to the beginning of the track
+  if (position > state->track->length)
+    position = 0;
+
+  state->position = position;
+  state->velocity = velocity;
+}
+
+INT32U vehicle_fast_forward(struct vehicle_state *state, const struct vehicle_inputs *in,
+                            INT32U periods)
+{
+#ifdef VEHICLE_FIXED_POINT
+  INT32U work;
+
+  vehicle_fx_sync(state);
+  work = vehicle_fx_fast_forward(&state->fx, in, periods);
+  state->position = (INT32U) (state->fx.position >> 16);
+  state->velocity = fix16_to_int(state->fx.velocity);
+  return work;
+#else
+  const struct track *track = state->track;
+  INT32U work = 0, lap_periods = 0, k, i;
+  INT16S lap_velocity = 0;
+  INT32S move;
+  int64_t position;
+  int    lap = 0;
+
+  while (periods > 0) {
+    work++;
+    // the state at 0 m decides the rest, so a lap that ends the way the
+    // last one did repeats it until the end
+    if (state->position == 0) {
+      if (lap && lap_velocity == state->velocity && lap_periods > periods)
+        periods %= lap_periods - periods;
+      lap          = 1;
+      lap_velocity = state->velocity;
+      lap_periods  = periods;
+      if (periods == 0)
+        break;
+    }
+    if (state->position > track->length || vehicle_velocity(state, in) != state->velocity) {
+      vehicle_step(state, in);
+      periods--;
+      continue;
+    }
+
+    // the velocity holds until the vehicle leaves the segment, the
+    // position moves by the same amount every period until then
+    move = state->velocity * VEHICLE_STEP_MS / 1000;
+    if (move == 0)
+      break;
+    i = track_segment_at(track, state->position);
+    if (move > 0)
+      k = (track_segment_end(track, i) - state->position + move - 1) / move;
+    else
+      k = (state->position - track->segment[i].start) / -move + 1;
+    if (k > periods)
+      k = periods;
+    position = state->position + (int64_t) k * move;
+    // reset the position to the beginning of the track, as vehicle_step()
+    // does when the unsigned position passes the length or wraps below 0
+    if (position < 0 || position > track->length)
+      position = 0;
+    if (position == state->position)
+      break;
+    state->position = (INT32U) position;
+    periods -= k;
+  }
+  return work;
+#endif
+}
@@ -0,0 +1,100 @@
+/* Vehicle model of the cruise control lab
+ *
+ * Description:
+ *
+ *   The moving mass with linear resistances that VehicleTask simulates,
+ *   as a re-entrant step function over an explicit state. One call
+ *   advances the vehicle by VEHICLE_STEP_MS milliseconds; the task is
+ *   only responsible for moving the inputs and outputs through the
+ *   mailboxes and the seven segment display.
+ *
+ *   vehicle_step() follows VehicleTask to the bit: the velocity update is
+ *   computed in double precision, which the Nios II emulates in software,
+ *   and both position and velocity are truncated to whole m and m/s every
+ *   period. vehicle_fx_step() integrates the same equations on a Q16.16
+ *   state that keeps the fractions. Building with -DVEHICLE_FIXED_POINT
+ *   makes vehicle_step() use it, position and velocity then being the
+ *   integer parts of the fixed-point state.
+ *
+ *   With constant inputs the velocity settles on a value within a few
+ *   periods (a few dozen in Q16.16) and then only changes where the slope
+ *   does, the position moving by the same amount every period in between.
+ *   vehicle_fast_forward() steps through the transients, jumps over the
+ *   steady stretches up to the next segment boundary and over whole laps
+ *   once a lap starts like the last one did. The cost of hours of driving
+ *   then depends on the input changes, not on the periods, and the state
+ *   is the one period-by-period stepping gives, bit for bit.
+ *
+ *   The slope under the vehicle comes from the track of its state, which
+ *   vehicle_init() sets to track_default. The wind resistance is a field
+ *   of the state as well, WIND_FACTOR after vehicle_init(), so that a
+ *   simulation can blow gusts at the vehicle.
+ */
+#ifndef VEHICLE_H
+#define VEHICLE_H
+
+#include "includes.h"
+#include "fix16.h"
+#include "track.h"
+
+/* Period the model is integrated with (VEHICLE_PERIOD of the tasks) */
+#define VEHICLE_STEP_MS    300
+
+/* Largest throttle the engine accepts (8.0 V) */
+#define MAX_THROTTLE        80
+
+/* Constants that should not be modified */
+#define WIND_FACTOR          1
+#define BRAKE_FACTOR         4
+#define GRAVITY_FACTOR       2
+
+/* The build options that change what the model computes, one bit each,
+   for the tools that cache its results */
+#ifdef VEHICLE_FIXED_POINT
+#define VEHICLE_BUILD_FLAGS  0x1
+#else
+#define VEHICLE_BUILD_FLAGS  0
+#endif
+
+enum active {on = 2, off = 1};
+
+struct vehicle_fx_state {
+  const struct track *track;
+  int64_t position;  /* m, 16 fractional bits like fix16 */
+  fix16   velocity;  /* m/s */
+  INT16U  wind_factor;
+};
+
+struct vehicle_state {
+  const struct track *track;
+  INT32U position;   /* m   */
+  INT16S velocity;   /* m/s */
+  INT16U wind_factor;
+#ifdef VEHICLE_FIXED_POINT
+  struct vehicle_fx_state fx;
+#endif
+};
+
+struct vehicle_inputs {
+  INT8U       throttle;     /* 0..80, larger values are clamped */
+  enum active brake_pedal;
+  enum active engine;
+};
+
+void vehicle_init(struct vehicle_state *state);
+void vehicle_step(struct vehicle_state *state, const struct vehicle_inputs *in);
+
+/*
+ * Same as 'periods' calls of vehicle_step() with the same inputs. Returns
+ * the iterations it took, which grow with the segments and laps driven
+ * instead of the periods.
+ */
+INT32U vehicle_fast_forward(struct vehicle_state *state, const struct vehicle_inputs *in,
+                            INT32U periods);
+
+void vehicle_fx_init(struct vehicle_fx_state *state);
+void vehicle_fx_step(struct vehicle_fx_state *state, const struct vehicle_inputs *in);
+INT32U vehicle_fx_fast_forward(struct vehicle_fx_state *state, const struct vehicle_inputs *in,
+                               INT32U periods);
+
+#endif /* VEHICLE_H */
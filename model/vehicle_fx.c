@@ -0,0 +1,122 @@
+/* Q16.16 vehicle model of the cruise control lab, see vehicle.h
+ *
+ * The equations are those of vehicle_step(), but the time step is the
+ * constant VEHICLE_FX_DT and nothing is truncated between periods, so a
+ * vehicle left on a flat road at constant throttle converges to the
+ * throttle value instead of stopping a few m/s short of it.
+ */
+#include "vehicle.h"
+
+/* VEHICLE_STEP_MS in seconds */
+#define VEHICLE_FX_DT FIX16_C(VEHICLE_STEP_MS / 1000.0)
+
+void vehicle_fx_init(struct vehicle_fx_state *state)
+{
+  state->track = track_default;
+  state->position = 0;
+  state->velocity = 0;
+  state->wind_factor = WIND_FACTOR;
+}
+
+/* Velocity after one period, from the state at its beginning */
+static fix16 vehicle_fx_velocity(const struct vehicle_fx_state *state,
+                                 const struct vehicle_inputs *in)
+{
+  fix16 velocity = state->velocity;
+  fix16 acceleration;
+  INT32U metre = (INT32U) (state->position >> 16);
+  INT8U throttle = in->throttle;
+
+  // vehichle cannot effort more than 80 units of throttle
+  if (throttle > MAX_THROTTLE)
+    throttle = MAX_THROTTLE;
+
+  // brakes + wind
+  if (in->brake_pedal == off)
+  {
+    // wind resistance
+    acceleration = fix16_mul_int(velocity, -(int32_t) state->wind_factor);
+    // actuate with engines
+    if (in->engine == on)
+      acceleration = fix16_add(acceleration, fix16_from_int(throttle));
+
+    // gravity effects of the slope under the vehicle
+    acceleration = fix16_add(acceleration, fix16_from_int(track_gradient(state->track, metre)));
+  }
+  // the brake dynamics dominates
+  else
+    acceleration = fix16_mul_int(velocity, -BRAKE_FACTOR);
+
+  return fix16_add(velocity, fix16_mul(acceleration, VEHICLE_FX_DT));
+}
+
+void vehicle_fx_step(struct vehicle_fx_state *state, const struct vehicle_inputs *in)
+{
+  int64_t position = state->position;
+  fix16 velocity = vehicle_fx_velocity(state, in);
+
+  position += fix16_mul(state->velocity, VEHICLE_FX_DT);
+  // reset the position to the beginning of the track, also when backing
+  // out of it (the unsigned position of vehicle_step() wraps around)
+  if (position > (int64_t) state->track->length << 16 || position < 0)
+    position = 0;
+
+  state->position = position;
+  state->velocity = velocity;
+}
+
+INT32U vehicle_fx_fast_forward(struct vehicle_fx_state *state, const struct vehicle_inputs *in,
+                               INT32U periods)
+{
+  const struct track *track = state->track;
+  int64_t length = (int64_t) track->length << 16;
+  int64_t position, end;
+  INT32U work = 0, lap_periods = 0, i;
+  int64_t k;
+  fix16 lap_velocity = 0, move;
+  int lap = 0;
+
+  while (periods > 0) {
+    work++;
+    // the state at 0 m decides the rest, see vehicle_fast_forward()
+    if (state->position == 0) {
+      if (lap && lap_velocity == state->velocity && lap_periods > periods)
+        periods %= lap_periods - periods;
+      lap = 1;
+      lap_velocity = state->velocity;
+      lap_periods = periods;
+      if (periods == 0)
+        break;
+    }
+    if (state->position > length || vehicle_fx_velocity(state, in) != state->velocity) {
+      vehicle_fx_step(state, in);
+      periods--;
+      continue;
+    }
+
+    // the velocity holds until the vehicle leaves the metres of the segment
+    move = fix16_mul(state->velocity, VEHICLE_FX_DT);
+    if (move == 0)
+      break;
+    i = track_segment_at(track, (INT32U) (state->position >> 16));
+    if (move > 0) {
+      // the last segment ends where the position wraps, past 'length'
+      end = (int64_t) track_segment_end(track, i) << 16;
+      if (end > length + 1)
+        end = length + 1;
+      k = (end - state->position + move - 1) / move;
+    } else {
+      k = (state->position - ((int64_t) track->segment[i].start << 16)) / -move + 1;
+    }
+    if (k > periods)
+      k = periods;
+    position = state->position + k * move;
+    if (position > length || position < 0)
+      position = 0;
+    if (position == state->position)
+      break;
+    state->position = position;
+    periods -= (INT32U) k;
+  }
+  return work;
+}
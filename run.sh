@@ -25,6 +25,9 @@ APP_NAME=cruise
 CPU_NAME=nios2
 BSP_PATH=../../bsp/il2206-pre-built-ucosii
 SRC_PATH=./src
+MODEL_PATH=./model   # vehicle and controller step functions
+# -DVEHICLE_FIXED_POINT runs the vehicle model in Q16.16 instead of soft-float
+APP_DEFINES=
 
 # Project internal folders
 mkdir -p gen
@@ -52,6 +55,9 @@ nios2-app-generate-makefile \
     --bsp-dir ../bsp \
     --elf-name ../bin/$APP_NAME.elf \
     --src-dir ../$SRC_PATH \
+    --src-dir ../$MODEL_PATH \
+    --set APP_INCLUDE_DIRS ../$MODEL_PATH \
+    --set APP_CFLAGS_DEFINED_SYMBOLS "$APP_DEFINES" \
     --set APP_CFLAGS_OPTIMIZATION -O0
 
 make | tee -a log.txt 
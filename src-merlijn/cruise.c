@@ -24,23 +24,13 @@
 #include "altera_avalon_pio_regs.h"
 #include "sys/alt_irq.h"
 #include "sys/alt_alarm.h"
+#include "vehicle.h"
+#include "control.h"
 
 #define DEBUG 1
 
 #define HW_TIMER_PERIOD 100 /* 100ms */
 
-/* Button Patterns */
-
-#define GAS_PEDAL_FLAG 0x08
-#define BRAKE_PEDAL_FLAG 0x04
-#define CRUISE_CONTROL_FLAG 0x02
-#define INCREASE_CRUISE_CONTROL_FLAG 0x01
-
-/* Switch Patterns */
-
-#define TOP_GEAR_FLAG 0x00000002
-#define ENGINE_FLAG 0x00000001
-
 /* LED Patterns */
 
 #define LED_RED_0 0x00000001 // Engine
@@ -107,15 +97,6 @@ OS_EVENT *SwitchSem;  // Semaphore for the switch task
 OS_TMR *VehicleSWTimer; // Software Timer for the vehicle task
 OS_TMR *ControlSWTimer; // Software Timer for the control task
 
-/*
- * Types
- */
-enum active
-{
-  on = 2,
-  off = 1
-};
-
 /*
  * Global variables
  */
@@ -123,7 +104,7 @@ int delay; // Delay of HW-timer
 INT16U led_green = 0;
 INT32U led_red = 0;
 INT16S target_velocity = 0;
-INT16S MAXIMUM_VELOCITY = 80;
+INT16S MAXIMUM_VELOCITY = MAXIMUM_TARGET_VELOCITY;
 
 int *red_leds = (int *)DE2_PIO_REDLED18_BASE;
 int *green_leds = (int *)DE2_PIO_GREENLED9_BASE;
@@ -252,72 +233,43 @@ void show_target_velocity(INT8U cruise_control)
 }
 
 /*
- * indicates the position of the vehicle on the track with the four leftmost red LEDs
+ * indicates the position of the vehicle on the track with the six leftmost red LEDs,
+ * each standing for a sixth of the track (track_default, model/track.h)
  * LEDR17: [0m, 400m)
  * LEDR16: [400m, 800m)
  * LEDR15: [800m, 1200m)
  * LEDR14: [1200m, 1600m)
  * LEDR13: [1600m, 2000m)
  * LEDR12: [2000m, 2400m]
+ * for the 2400m lab track
  */
-void show_position(INT16U position)
+void show_position(INT32U position)
 {
-  // Use a switch statement to set the leds (set the bit to 1 on the position)
-  switch (position)
-  {
-  case 0 ... 399:
-    *red_leds |= 0x00020000;
-    break;
-  case 400 ... 799:
-    *red_leds |= 0x00010000;
-    break;
-  case 800 ... 1199:
-    *red_leds |= 0x00008000;
-    break;
-  case 1200 ... 1599:
-
-    *red_leds |= 0x00004000;
-    break;
-  case 1600 ... 1999:
-    *red_leds |= 0x00002000;
-    break;
-  case 2000 ... 2400:
-    *red_leds |= 0x00001000;
-    break;
-  default:
-    break;
-  }
+  if (position <= track_default->length)
+    *red_leds |= 0x00020000 >> track_section(track_default, position, 6);
 }
 
 /*
- * The task 'VehicleTask' is the model of the vehicle being simulated. It updates variables like
- * acceleration and velocity based on the input given to the model.
- *
- * The car model is equivalent to moving mass with linear resistances acting upon it.
- * Therefore, if left one, it will stably stop as the velocity converges to zero on a flat surface.
- * You can prove that easily via basic LTI systems methods.
+ * The task 'VehicleTask' is the model of the vehicle being simulated. It feeds the
+ * inputs given to the model to vehicle_step() (model/vehicle.c) every period.
  */
 void VehicleTask(void *pdata)
 {
-  // constants that should not be modified
-  const unsigned int wind_factor = 1;
-  const unsigned int brake_factor = 4;
-  const unsigned int gravity_factor = 2;
   // variables relevant to the model and its simulation on top of the RTOS
   INT8U err;
   void *msg;
-  INT8U *throttle;
-  INT16S acceleration;
-  INT16U position = 0;
-  INT16S velocity = 0;
-  enum active brake_pedal = off;
-  enum active engine = off;
+  INT8U no_throttle = 0;
+  INT8U *throttle = &no_throttle;
+  struct vehicle_state car;
+  struct vehicle_inputs in = {0, off, off};
+
+  vehicle_init(&car);
 
   printf("Vehicle task created!\n");
 
   while (1)
   {
-    err = OSMboxPost(Mbox_Velocity, (void *)&velocity);
+    err = OSMboxPost(Mbox_Velocity, (void *)&car.velocity);
 
     // Wait until the vehicle semaphore is released
     OSSemPend(VehicleSem, 0, &err);
@@ -332,89 +284,39 @@ void VehicleTask(void *pdata)
     /* Same for the brake signal that bypass the control law */
     msg = OSMboxPend(Mbox_Brake, 1, &err);
     if (err == OS_NO_ERR)
-      brake_pedal = (enum active)msg;
+      in.brake_pedal = (enum active)msg;
     /* Same for the engine signal that bypass the control law */
     msg = OSMboxPend(Mbox_Engine, 1, &err);
     if (err == OS_NO_ERR)
-      engine = (enum active)msg;
+      in.engine = (enum active)msg;
 
-    // vehichle cannot effort more than 80 units of throttle
-    if (*throttle > 80)
-      *throttle = 80;
+    in.throttle = *throttle;
+    vehicle_step(&car, &in);
 
-    // brakes + wind
-    if (brake_pedal == off)
-    {
-      // wind resistance
-      acceleration = -wind_factor * velocity;
-      // actuate with engines
-      if (engine == on)
-        acceleration += (*throttle);
-
-      // gravity effects
-      if (400 <= position && position < 800)
-        acceleration -= gravity_factor; // traveling uphill
-      else if (800 <= position && position < 1200)
-        acceleration -= 2 * gravity_factor; // traveling steep uphill
-      else if (1600 <= position && position < 2000)
-        acceleration += 2 * gravity_factor; // traveling downhill
-      else if (2000 <= position)
-        acceleration += gravity_factor; // traveling steep downhill
-    }
-    // if the engine and the brakes are activated at the same time,
-    // we assume that the brake dynamics dominates, so both cases fall
-    // here.
-    else
-      acceleration = -brake_factor * velocity;
-
-    // printf("Position: %d m\n", position);
-    // printf("Velocity: %d m/s\n", velocity);
-    // printf("Accell: %d m/s2\n", acceleration);
-    // printf("Throttle: %d V\n", *throttle);
-
-    position = position + velocity * VEHICLE_PERIOD / 1000;
-    velocity = velocity + acceleration * VEHICLE_PERIOD / 1000.0;
-    // reset the position to the beginning of the track
-    if (position > 2400)
-      position = 0;
-
-    show_velocity_on_sevenseg((INT8S)velocity);
+    show_velocity_on_sevenseg((INT8S)car.velocity);
   }
 }
 
 /*
  * The task 'ControlTask' is the main task of the application. It reacts
- * on sensors and generates responses.
+ * on sensors and generates responses through control_step() (model/control.c).
  */
 void ControlTask(void *pdata)
 {
   INT8U err;
-  INT8U STATIONARY_THROTTLE = 40;
-  INT8U throttle = STATIONARY_THROTTLE; /* Value between 0 and 80, which is interpreted as between 0.0V and 8.0V */
-  int temp_throttle = 0;
   void *msg;
   INT16S *current_velocity;
-  INT16U position = 0;
+  struct control_state ctrl;
+  struct control_inputs in;
+  struct control_outputs out;
 
-  enum active gas_pedal = off;
-  enum active top_gear = off;
-  enum active cruise_control = off;
+  control_init(&ctrl);
 
   printf("Control Task created!\n");
 
   // variable that holds the messages from buttons and switches
   INT8U msg_buttons = 0;
   int msg_switches = 0;
-  INT8U engine_state = 0;
-
-  // Constants and variables for the cruise control using a PID controller
-  float KP = 0.5;
-  float KI = 1;
-  float KD = 0;
-  float error = 0;      // Error term between desired and current velocity
-  float integral = 0;   // Integral term of errors
-  float last_error = 0; // Last error term
-  float derivative = 0; // Derivative term of the last error
 
   // Base pointers for the leds
   *red_leds = 0;
@@ -435,109 +337,41 @@ void ControlTask(void *pdata)
     msg = OSMboxPend(Mbox_switches, 1, &err);
     msg_switches = (int)((err == OS_NO_ERR) ? ((int *)msg) : 0);
 
-    // Here you can use whatever technique or algorithm that you prefer to control
-    // the velocity via the throttle. There are no right and wrong answer to this controller, so
-    // be free to use anything that is able to maintain the cruise working properly. You are also
-    // allowed to store more than one sample of the velocity. For instance, you could define
-    //
-    // INT16S previous_vel;
-    // INT16S pre_previous_vel;
-    // ...
-    //
-    // If your control algorithm/technique needs them in order to function.
-
-    /* Logic for handling the engine,
-    turning it on and off
-    If the velocity is zero and the car is not moving then the car is turned off
-    */
-    if (((msg_switches & ENGINE_FLAG) == 0) & (engine_state == 1))
-    {
-      // If there is still velocity then set the throttle to 0
-      if (*current_velocity != 0)
-        throttle = 0;
-      else
-      {
-        // Send a message to the engine mailbox
-        err = OSMboxPost(Mbox_Engine, (void *)off);
+    // The increase button of ButtonIO moves the target velocity as well
+    ctrl.target_velocity = target_velocity;
 
-        // Set the state of the engine to 0
-        engine_state = 0;
+    in.velocity = *current_velocity;
+    in.buttons = msg_buttons;
+    in.switches = msg_switches;
+    control_step(&ctrl, &in, &out);
 
-        printf("Turned off engine\n");
-      }
-    }
+    target_velocity = ctrl.target_velocity;
 
+    if (out.engine == off)
+    {
+      // Send a message to the engine mailbox
+      err = OSMboxPost(Mbox_Engine, (void *)off);
+      printf("Turned off engine\n");
+    }
     // Turn the engine on, make sure the queue is not full
-    else if (((msg_switches & ENGINE_FLAG) == 1) & (engine_state == 0))
+    else if (out.engine == on)
     {
       // Send a message to the engine mailbox that it is on
       err = OSMboxPost(Mbox_Engine, (void *)on);
       if (err == OS_ERR_NONE)
       {
-        engine_state = 1;
         printf("Turned on engine\n");
 
         // Send a message to turn off the brake
         err = OSMboxPost(Mbox_Brake, (void *)off);
       }
-    }
-
-    /*
-    Get information about the gas pedal, top gear and cruise control
-    */
-
-    gas_pedal = (msg_buttons & GAS_PEDAL_FLAG) ? on : off;
-    top_gear = (msg_switches & TOP_GEAR_FLAG) ? on : off;
-
-    if ((msg_buttons & CRUISE_CONTROL_FLAG) && (*current_velocity > 20) && (top_gear == on))
-    {
-      target_velocity = *current_velocity % MAXIMUM_VELOCITY;
-      cruise_control = on;
-    }
-
-    // Turn cruise control off if the brake is pressed or the gas is pressed
-    if ((msg_buttons & (BRAKE_PEDAL_FLAG | GAS_PEDAL_FLAG)) |
-        ((cruise_control == on) & (top_gear == off)) |
-        (*current_velocity < 25))
-      cruise_control = off;
-
-    /*
-    Logic for handling the break, gas and cruise control. It also is of this order in importance
-    Starts out with having a throttle of 40 and then changing it according to the rules
-    */
-    throttle = STATIONARY_THROTTLE;
-
-    if (msg_buttons & BRAKE_PEDAL_FLAG)
-      throttle = 0;
-    else if (msg_buttons & GAS_PEDAL_FLAG)
-      throttle = 80;
-    else if (cruise_control == on)
-    {
-      // The error term (difference between target and current velocity)
-      error = target_velocity - *current_velocity;
-
-      // The integral term (all the errors so far)
-      integral += error;
-
-      // The derivative term (the difference between the last error and the current error)
-      derivative = error - derivative;
-      last_error = error;
-
-      // Calculate the throttle which is at least 0 and at most 80
-      temp_throttle = throttle + KP * error + KI * integral + KD * derivative;
-
-      // Make sure the throttle is between 0 and 80
-      if (temp_throttle > 80)
-        throttle = 80;
-      else if (temp_throttle < 0)
-        throttle = 0;
       else
-        throttle = temp_throttle;
+        ctrl.engine_state = 0; // try again next period
     }
 
     // Send the throttle and break
-    err = OSMboxPost(Mbox_Throttle, (void *)&throttle);
-    err = OSMboxPost(Mbox_Brake, (void *)(msg_buttons & BRAKE_PEDAL_FLAG) ? on : off);
+    err = OSMboxPost(Mbox_Throttle, (void *)&ctrl.throttle);
+    err = OSMboxPost(Mbox_Brake, (out.brake == on) ? (void *)on : (void *)off);
 
     // Set the green leds according to the buttons pressed
     // The cruise control can be on even though the button is not pressed
@@ -547,28 +381,25 @@ void ControlTask(void *pdata)
     *green_leds = msg_buttons;
 
     // If the cruise control is on then turn on the cruise control light (1)
-    *green_leds += (cruise_control == on) ? LED_GREEN_1 : 0;
+    *green_leds += (ctrl.cruise_control == on) ? LED_GREEN_1 : 0;
 
     /* turn on the red lights */
     *red_leds = 0;
 
     // If the motor is on then turn on the engine light (0)
-    *red_leds += (engine_state == 1) ? LED_RED_0 : 0;
+    *red_leds += (ctrl.engine_state == 1) ? LED_RED_0 : 0;
 
     // If the car is in top gear then turn on the top gear light (1)
-    *red_leds += (top_gear == on) ? LED_RED_1 : 0;
+    *red_leds += (ctrl.top_gear == on) ? LED_RED_1 : 0;
 
     // Turn on leds 4 to 9 if they are pressed using a mask
     *red_leds += (0x3F << 4) & msg_switches;
 
-    // Calculate the new position mod 2400
-    position = (position + *current_velocity * CONTROL_PERIOD / 1000) % 2400;
-
     // Show the position
-    show_position(position);
+    show_position(ctrl.position);
 
     // Show the target velocity
-    show_target_velocity(cruise_control);
+    show_target_velocity(ctrl.cruise_control);
 
     // Wait until the vehicle semaphore is released
     OSSemPend(ControlSem, 0, &err);
@@ -24,6 +24,7 @@
 #include "altera_avalon_pio_regs.h"
 #include "sys/alt_irq.h"
 #include "sys/alt_alarm.h"
+#include "vehicle.h"
 
 #define DEBUG 1
 
@@ -101,11 +102,6 @@ OS_TMR *SwTmrIO;
 
 
 
-/*
- * Types
- */
-enum active {on = 2, off = 1};
-
 
 /*
  * Global variables
@@ -316,37 +312,30 @@ void SwitchIOTask(void *pdata)
 
 
 /*
- * The task 'VehicleTask' is the model of the vehicle being simulated. It updates variables like
- * acceleration and velocity based on the input given to the model.
- * 
- * The car model is equivalent to moving mass with linear resistances acting upon it.
- * Therefore, if left one, it will stably stop as the velocity converges to zero on a flat surface.
- * You can prove that easily via basic LTI systems methods.
+ * The task 'VehicleTask' is the model of the vehicle being simulated. It feeds the
+ * inputs given to the model to vehicle_step() (model/vehicle.c), which updates
+ * the position and velocity of the car, every VEHICLE_PERIOD.
  */
 void VehicleTask(void* pdata)
 { 
-  // constants that should not be modified
-  const unsigned int wind_factor = 1;
-  const unsigned int brake_factor = 4;
-  const unsigned int gravity_factor = 2;
   // variables relevant to the model and its simulation on top of the RTOS
   INT8U err;  
   void* msg;
-  INT8U* throttle; 
-  INT16S acceleration;  
-  INT16U position = 0; 
-  INT16S velocity = 0; 
-  enum active brake_pedal = off;
-  enum active engine = off;
+  INT8U no_throttle = 0;
+  INT8U* throttle = &no_throttle; 
+  struct vehicle_state car;
+  struct vehicle_inputs in = {0, off, off};
+
+  vehicle_init(&car);
 
   printf("Vehicle task created!\n");
     
   if(DEBUG)
-    printf("[VehicleTask] Initial brake val: %d\n", brake_pedal);
+    printf("[VehicleTask] Initial brake val: %d\n", in.brake_pedal);
 
   while(1)
   {
-    err = OSMboxPost(Mbox_Velocity, (void *) &velocity);
+    err = OSMboxPost(Mbox_Velocity, (void *) &car.velocity);
 
     OSSemPend(VehicleSem, 0, &err);
     
@@ -362,10 +351,10 @@ void VehicleTask(void* pdata)
     /* Same for the brake signal that bypass the control law */
     msg = OSMboxPend(Mbox_Brake, 1, &err); 
     if (err == OS_NO_ERR){ 
-      brake_pedal = (enum active) msg;
+      in.brake_pedal = (enum active) msg;
       
       if(DEBUG)
-        printf("[VehicleTask] Brake: %d\n", brake_pedal);
+        printf("[VehicleTask] Brake: %d\n", in.brake_pedal);
       
     }else {
       printf("[VehicleTask] Brake Mbox Error!\n");
@@ -373,56 +362,16 @@ void VehicleTask(void* pdata)
     /* Same for the engine signal that bypass the control law */
     msg = OSMboxPend(Mbox_Engine, 1, &err); 
     if (err == OS_NO_ERR) 
-      engine = (enum active) msg;
-
+      in.engine = (enum active) msg;
 
-    // vehichle cannot effort more than 80 units of throttle
-    if (*throttle > 80) *throttle = 80;
+    in.throttle = *throttle;
+    if(DEBUG)
+      printf(in.brake_pedal == off ? "[VehicleTask] Brake off\n" : "[VehicleTask] Brake on\n");
+    vehicle_step(&car, &in);
 
-    // brakes + wind
-    if (brake_pedal == off)
-    {   
-      if(DEBUG)
-        printf("[VehicleTask] Brake off\n");
-
-      // wind resistance
-      acceleration = - wind_factor*velocity;
-      // actuate with engines
-      if (engine == on)
-        acceleration += (*throttle);
-
-      // gravity effects
-      if (400 <= position && position < 800)
-        acceleration -= gravity_factor; // traveling uphill
-      else if (800 <= position && position < 1200)
-        acceleration -= 2*gravity_factor; // traveling steep uphill
-      else if (1600 <= position && position < 2000)
-        acceleration += 2*gravity_factor; //traveling downhill
-      else if (2000 <= position)
-        acceleration += gravity_factor; // traveling steep downhill
-    }
-    // if the engine and the brakes are activated at the same time,
-    // we assume that the brake dynamics dominates, so both cases fall
-    // here.
-    else { 
-      acceleration = - brake_factor*velocity;
-      if(DEBUG)
-        printf("[VehicleTask] Brake on\n");
-    }
-    //printf("Position: %d m\n", position);
-    //printf("Velocity: %d m/s\n", velocity);
-    //printf("Accell: %d m/s2\n", acceleration);
-    //printf("Throttle: %d V\n", *throttle);
-
-    position = position + velocity * VEHICLE_PERIOD / 1000;
-    velocity = velocity  + acceleration * VEHICLE_PERIOD / 1000.0;
-    // reset the position to the beginning of the track
-    if(position > 2400)
-      position = 0;
-
-    show_velocity_on_sevenseg((INT8S) velocity);
+    show_velocity_on_sevenseg((INT8S) car.velocity);
   }
-} 
+}
 
 /*
  * The task 'ControlTask' is the main task of the application. It reacts